@@ -2,193 +2,713 @@
 #include <glm/gtx/norm.hpp>
 #include <iostream>
 #include <algorithm>
-#include <future>
+#include <chrono>
+#include <cmath>
 #include "utils.h"
 
-Nsolver::Nsolver() : grid(GRID_WIDTH, GRID_HEIGHT, CELL_SIZE),
-    threadPool(std::thread::hardware_concurrency()){
+namespace {
+int64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+Nsolver::Nsolver(const SolverConfig& solverConfig) : config(solverConfig), grid(1, 1, 1.0f), sparseGrid(1.0f),
+    threadPool(solverConfig.threads > 0 ? solverConfig.threads
+                                        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))){
+    config.substeps = std::max(1, config.substeps);
+    config.tileSize = std::max(2, config.tileSize);
+    config.sleepSteps = std::max(1, std::min(config.sleepSteps, static_cast<int>(kRestMask)));
+    workerLoad.resize(threadPool.getThreadCount());
+    workerBusyMs.assign(threadPool.getThreadCount(), 0.0);
+    configureGrid(tunedCellSize());
+    setSimdLevel(detectSimdLevel());
 }
 
 Nsolver::~Nsolver() {}
 
+void Nsolver::setSimdLevel(SimdLevel level){
+    simdLevel = resolveSimdLevel(level);
+    collideKernel = selectCollideKernel(simdLevel, config.deterministic);
+}
+
+void Nsolver::setDeterministic(bool enabled){
+    config.deterministic = enabled;
+    setSimdLevel(simdLevel);
+}
+
+void Nsolver::setPersistentTeam(bool enabled){
+    if (enabled && !team) {
+        // Same member count as the pool so chunks and results are identical
+        team.reset(new PersistentTeam(static_cast<int>(threadPool.getThreadCount())));
+    } else if (!enabled) {
+        team.reset();
+    }
+}
+
+// Size the grid to cover the configured world with square cells of the given edge
+// (the smallest level edge allowed for MultiLevel). Only the selected broad phase gets storage;
+// the dense grid stays 1x1 otherwise.
+void Nsolver::configureGrid(float size){
+    cellSize = size;
+    gridWidth = std::max(1, static_cast<int32_t>(std::ceil(config.width() / size)));
+    gridHeight = std::max(1, static_cast<int32_t>(std::ceil(config.height() / size)));
+    if (usesSparseGrid() || usesMultiLevel()) {
+        grid = CollisionGrid(1, 1, size, config.worldLeft, config.worldBottom);
+    } else {
+        grid = CollisionGrid(gridWidth, gridHeight, size, config.worldLeft, config.worldBottom);
+    }
+    sparseGrid = SparseCollisionGrid(size, config.worldLeft, config.worldBottom);
+    multiGrid.configure(size, multiLevelTopCell(), config.worldLeft, config.worldBottom);
+    tiles.resize(usesMultiLevel() ? multiGrid.levelCount() : 1);
+}
+
+// Top multi-level cell: the largest diameter (or the expected one before any particle)
+float Nsolver::multiLevelTopCell() const {
+    return 2.0f * (maxRadius > 0.0f ? maxRadius : config.expectedMaxRadius);
+}
+
+float Nsolver::tunedCellSize() const {
+    return usesMultiLevel() ? tuneBaseCellSize(config, minRadius) : tuneCellSize(config, maxRadius);
+}
+
+void Nsolver::setCellSize(float size){
+    config.cellSize = size;
+    configureGrid(tunedCellSize());
+}
+
+void Nsolver::setBroadPhase(BroadPhase broadPhase){
+    if (broadPhase == config.broadPhase) return;
+    config.broadPhase = broadPhase;
+    configureGrid(tunedCellSize());
+}
+
+void Nsolver::setSleepSpeed(float speed){
+    config.sleepSpeed = speed;
+    if (!sleepEnabled()) std::fill(particles.rest.begin(), particles.rest.end(), 0);
+    countAwake();
+}
+
+size_t Nsolver::getOccupiedCellCount() const {
+    return usesMultiLevel() ? multiGrid.occupiedCount() : sparseGrid.occupiedCount();
+}
+
 void Nsolver::update(float dt){
+    // Follow the radius distribution (auto cell size) or a radius outgrowing the set size;
+    // multi-level grids also follow the largest radius with their top level
+    const float tunedSize = tunedCellSize();
+    if (tunedSize != cellSize ||
+        (usesMultiLevel() && std::max(multiLevelTopCell(), cellSize) != multiGrid.levels.back().cellSize)) {
+        configureGrid(tunedSize);
+    }
+
+    const int iterations = config.substeps;
     float substeps = dt/iterations;
-    for (int iter = 0; iter < iterations; ++iter) {
-        
-        updateParticles(substeps);
-        updateParticleGrid();
-        solveCollisions();
+    const bool reorder = reorderInterval > 0 && ++framesSinceReorder >= reorderInterval;
+    for (WorkerLoad& load : workerLoad) load.busyNs = 0;
+    if (team) {
+        updateWithTeam(substeps, reorder);
+    } else {
+        for (int iter = 0; iter < iterations; ++iter) {
+            
+            updateParticles(substeps);
+            updateParticleGrid();
+            if (reorder && iter == 0) {
+                reorderParticles();
+            }
+            solveCollisions();
+        }
     }
+    if (reorder) framesSinceReorder = 0;
+    recordLoadBalance();
+    countAwake();
 }
 
+void Nsolver::countAwake(){
+    if (!sleepEnabled()) {
+        awakeCount = particles.size();
+        return;
+    }
+    size_t awake = 0;
+    for (uint16_t rest : particles.rest) awake += (rest & kAsleep) == 0;
+    awakeCount = awake;
+}
+
+// Busy time of every worker in this frame's collision passes, and max over mean
+void Nsolver::recordLoadBalance(){
+    double total = 0.0;
+    double busiest = 0.0;
+    for (size_t w = 0; w < workerLoad.size(); ++w) {
+        workerBusyMs[w] = workerLoad[w].busyNs * 1e-6;
+        total += workerBusyMs[w];
+        busiest = std::max(busiest, workerBusyMs[w]);
+    }
+    const double mean = total / static_cast<double>(workerLoad.size());
+    loadImbalance = mean > 0.0 ? static_cast<float>(busiest / mean) : 1.0f;
+}
+
+// Persistent-team frame: every worker owns one particle chunk, pulls tiles of each color
+// from a shared cursor, and walks all substeps in lockstep, separated by barriers. Integration and cell
+// binning touch only the worker's own chunk, so they share a phase; the dense grid's
+// histogram chunks (see CollisionGrid::chunksFor) may span several workers' particles
+// and are counted after the barrier. The grid is sized before the team starts, so
+// substeps do not allocate.
+void Nsolver::updateWithTeam(float dt, bool reorder){
+    const int workers = team->size();
+    const bool sparse = usesSparseGrid();
+    const bool multiLevel = usesMultiLevel();
+    chunkBounds.resize(workers);
+    const bool dense = !sparse && !multiLevel;
+    if (sparse) {
+        sparseGrid.resize(particles.size());
+    } else if (dense) {
+        grid.resize(particles.size(), grid.chunksFor(particles.size(), workers));
+    }
+
+    const int iterations = config.substeps;
+
+    team->run([this, dt, reorder, workers, iterations, sparse, multiLevel, dense](int worker) {
+        size_t start, end;
+        chunkRange(worker, workers, start, end);
+        const int histogramChunks = dense ? grid.chunkCount : 0;
+        size_t histogramStart = 0, histogramEnd = 0;
+        if (worker < histogramChunks) chunkRange(worker, histogramChunks, histogramStart, histogramEnd);
+
+        for (int iter = 0; iter < iterations; ++iter) {
+            integrateRange(start, end, dt);
+            binGridChunk(worker, workers);
+            team->sync();
+
+            if (dense) {
+                if (worker < histogramChunks) grid.countChunk(worker, histogramStart, histogramEnd);
+                team->sync();
+            }
+
+            if (worker == 0) {
+                if (multiLevel) multiGrid.build(particles.x.data(), particles.y.data(), particles.radius.data(), particles.size());
+                else if (sparse) sparseGrid.build(particles.size());
+                else grid.computeOffsets();
+                buildTileSchedule(workers);
+                for (std::atomic<int>& cursor : tileCursor) cursor.store(0, std::memory_order_relaxed);
+            }
+            team->sync();
+
+            if (dense) {
+                if (worker < histogramChunks) grid.scatterChunk(worker, histogramStart, histogramEnd);
+                team->sync();
+            }
+
+            if (reorder && iter == 0) {
+                if (worker == 0) reorderParticles();
+                team->sync();
+            }
+
+            for (int level = 0; level < static_cast<int>(tiles.size()); ++level) {
+                for (int color = 0; color < TileSchedule::kColors; ++color) {
+                    std::atomic<int>& cursor = tileCursor[level * TileSchedule::kColors + color];
+                    const int count = static_cast<int>(tiles[level].tileCount(color));
+                    const auto t0 = std::chrono::steady_clock::now();
+                    for (int tile = cursor.fetch_add(1, std::memory_order_relaxed); tile < count;
+                         tile = cursor.fetch_add(1, std::memory_order_relaxed)) {
+                        solveTile(level, color, tile);
+                    }
+                    workerLoad[worker].busyNs += elapsedNs(t0);
+                    team->sync();
+                }
+            }
+        }
+    });
+}
+
+void Nsolver::chunkRange(int chunk, int chunks, size_t& start, size_t& end) const {
+    const size_t count = particles.size();
+    start = count * chunk / chunks;
+    end = count * (chunk + 1) / chunks;
+}
+
+// Cell (dense) or cell key (sparse) of every particle in the chunk; the dense grid also
+// gets the chunk's bounding box, for the tile schedule
+void Nsolver::binGridChunk(int chunk, int chunks){
+    size_t start, end;
+    chunkRange(chunk, chunks, start, end);
+    const float* px = particles.x.data();
+    const float* py = particles.y.data();
+
+    // Multi-level grids bin by radius as well, in one serial pass (MultiLevelGrid::build)
+    if (usesMultiLevel()) return;
+
+    if (usesSparseGrid()) {
+        for (size_t i = start; i < end; ++i) {
+            sparseGrid.particleKey[i] = sparseGrid.keyFor(px[i], py[i]);
+        }
+        return;
+    }
+
+    // Bounding box of the chunk, for the tile schedule
+    ChunkBounds& bounds = chunkBounds[chunk];
+    bounds = ChunkBounds();
+    for (size_t i = start; i < end; ++i) {
+        bounds.minX = std::min(bounds.minX, px[i]);
+        bounds.maxX = std::max(bounds.maxX, px[i]);
+        bounds.minY = std::min(bounds.minY, py[i]);
+        bounds.maxY = std::max(bounds.maxY, py[i]);
+    }
+    for (size_t i = start; i < end; ++i) {
+        grid.particleCell[i] = grid.cellIndexFor(px[i], py[i]);
+    }
+}
+
+// Counting-sort grid rebuild: threaded cell binning, per-chunk histograms, a serial
+// prefix sum over cells, then a threaded scatter into the flat index array (see
+// CollisionGrid; a sparsely filled grid uses fewer histogram chunks than threads).
+// The sparse grid computes cell keys per chunk and sorts them serially.
 void Nsolver::updateParticleGrid(){
-    grid.clear();
-    for (size_t i = 0; i < particles.size(); ++i) {
-        Particle& p = particles[i];
-        
-        // Update grid coordinates based on current position
-        p.gridX = static_cast<int>((p.position.x - WORLD_LEFT) / CELL_SIZE);
-        p.gridY = static_cast<int>((p.position.y - WORLD_BOTTOM) / CELL_SIZE);
-        
-        // Clamp to grid bounds
-        p.gridX = std::max(0, std::min(p.gridX, GRID_WIDTH - 1));
-        p.gridY = std::max(0, std::min(p.gridY, GRID_HEIGHT - 1));
-        
-        grid.addParticle(p.gridX, p.gridY, static_cast<uint32_t>(i));
+    const int chunks = std::max(1, static_cast<int>(threadPool.getThreadCount()));
+    chunkBounds.resize(chunks);
+    if (usesMultiLevel()) {
+        multiGrid.build(particles.x.data(), particles.y.data(), particles.radius.data(), particles.size());
+        buildTileSchedule(chunks);
+        return;
     }
+    if (usesSparseGrid()) {
+        sparseGrid.resize(particles.size());
+        partitionThreads(chunks, threadPool, [this, chunks](int first, int last) {
+            for (int chunk = first; chunk < last; ++chunk) {
+                binGridChunk(chunk, chunks);
+            }
+        });
+        sparseGrid.build(particles.size());
+        buildTileSchedule(chunks);
+        return;
+    }
+
+    const int histogramChunks = grid.chunksFor(particles.size(), chunks);
+    grid.resize(particles.size(), histogramChunks);
+
+    partitionThreads(chunks, threadPool, [this, chunks](int first, int last) {
+        for (int chunk = first; chunk < last; ++chunk) {
+            binGridChunk(chunk, chunks);
+        }
+    });
+
+    partitionThreads(histogramChunks, threadPool, [this, histogramChunks](int first, int last) {
+        for (int chunk = first; chunk < last; ++chunk) {
+            size_t start, end;
+            chunkRange(chunk, histogramChunks, start, end);
+            grid.countChunk(chunk, start, end);
+        }
+    });
+
+    grid.computeOffsets();
+
+    partitionThreads(histogramChunks, threadPool, [this, histogramChunks](int first, int last) {
+        for (int chunk = first; chunk < last; ++chunk) {
+            size_t start, end;
+            chunkRange(chunk, histogramChunks, start, end);
+            grid.scatterChunk(chunk, start, end);
+        }
+    });
+    buildTileSchedule(chunks);
+}
+
+// Tiles for the next narrow phase (see TileSchedule): the sparse grid lists the tiles of
+// its occupied cells, the dense grid every tile under the particles' bounding box, and
+// every multi-level grid level the tiles of its own and finer particles' cells.
+void Nsolver::buildTileSchedule(int chunks){
+    for (TileSchedule& schedule : tiles) schedule.tileSize = config.tileSize;
+    if (usesMultiLevel()) {
+        // Finer levels get proportionally more cells per tile, so a tile covers the same
+        // area (and task count stays the same) on every level
+        for (int l = 0; l < multiGrid.levelCount(); ++l) {
+            tiles[l].tileSize = config.tileSize << (multiGrid.levelCount() - 1 - l);
+            const MultiLevelGrid::Level& level = multiGrid.levels[l];
+            tiles[l].reset();
+            tiles[l].addCells(level.own.cellRow.data(), level.own.cellCol.data(), level.own.occupiedCount());
+            tiles[l].addCells(level.finer.cellRow.data(), level.finer.cellCol.data(), level.finer.occupiedCount());
+            tiles[l].finish();
+        }
+        return;
+    }
+    if (usesSparseGrid()) {
+        tiles[0].buildFromCells(sparseGrid.cellRow.data(), sparseGrid.cellCol.data(), sparseGrid.occupiedCount());
+        return;
+    }
+
+    ChunkBounds box;
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        box.minX = std::min(box.minX, chunkBounds[chunk].minX);
+        box.maxX = std::max(box.maxX, chunkBounds[chunk].maxX);
+        box.minY = std::min(box.minY, chunkBounds[chunk].minY);
+        box.maxY = std::max(box.maxY, chunkBounds[chunk].maxY);
+    }
+    if (box.minX > box.maxX) {
+        tiles[0].build(0, 0, -1, -1);
+        return;
+    }
+    const uint32_t low = grid.cellIndexFor(box.minX, box.minY);
+    const uint32_t high = grid.cellIndexFor(box.maxX, box.maxY);
+    tiles[0].build(static_cast<int32_t>(low % grid.width), static_cast<int32_t>(low / grid.width),
+                static_cast<int32_t>(high % grid.width), static_cast<int32_t>(high / grid.width));
+}
+
+// Permute particle storage into grid-cell order so that particles sharing a cell, and
+// vertically adjacent rows of cells, sit next to each other in memory.
+void Nsolver::reorderParticles(){
+    if (particles.empty()) return;
+    if (usesMultiLevel()) {
+        // Level by level; the levels hold particle indices, so they are simply rebuilt
+        multiGrid.cellOrder(levelOrder);
+        particles.reorder(levelOrder, reorderScratch);
+        multiGrid.build(particles.x.data(), particles.y.data(), particles.radius.data(), particles.size());
+        return;
+    }
+    if (usesSparseGrid()) {
+        particles.reorder(sparseGrid.objects, reorderScratch);
+        sparseGrid.adoptSortedOrder();
+        return;
+    }
+    particles.reorder(grid.objects, reorderScratch);
+    grid.adoptSortedOrder();
 }
 
 void Nsolver::updateParticles(float dt){
     // Thread the particle updates
-    auto work = [this, dt](int start, int end){
-        glm::vec2 g(0.0f, -GRAVITY);
-        for (int i = start; i < end; ++i) {
-            particles[i].accelerate(g);
+    partitionThreads((int)particles.size(), threadPool, [this, dt](int start, int end){
+        integrateRange(start, end, dt);
+    });
+}
+
+void Nsolver::integrateRange(size_t start, size_t end, float dt){
+    float* px = particles.x.data();
+    float* py = particles.y.data();
+    float* ppx = particles.prevX.data();
+    float* ppy = particles.prevY.data();
+    const float* pr = particles.radius.data();
+
+    // Verlet integration with gravity as the only acceleration. With sleeping enabled,
+    // a particle counts the substeps it has stayed within sleepSpeed * sleepSteps * dt of
+    // its anchor, i.e. moved slower than sleepSpeed on average over that window; leaving
+    // the radius re-anchors it and restarts the count. Asleep particles skip integration.
+    // Their only motion is what contacts pushed them in the last narrow phase: a push
+    // faster than wakeSpeed wakes them, slower pushes are absorbed.
+    const float gravityStep = -GRAVITY * dt * dt;
+    const bool sleeping = sleepEnabled();
+    const float sleepRadius = config.sleepSpeed * config.sleepSteps * dt;
+    const float sleepRadiusSq = sleepRadius * sleepRadius;
+    const float wakeStep = config.wakeSpeed * dt;
+    const float wakeStepSq = wakeStep * wakeStep;
+    uint16_t* rest = particles.rest.data();
+    float* rx = particles.restX.data();
+    float* ry = particles.restY.data();
+    for (size_t i = start; i < end; ++i) {
+        const float x = px[i];
+        const float y = py[i];
+        if (sleeping) {
+            const float dx = x - rx[i];
+            const float dy = y - ry[i];
+            const float pushX = x - ppx[i];
+            const float pushY = y - ppy[i];
+            const bool asleep = (rest[i] & kAsleep) != 0;
+            if (dx * dx + dy * dy > sleepRadiusSq ||
+                (asleep && pushX * pushX + pushY * pushY > wakeStepSq)) {
+                rx[i] = x;
+                ry[i] = y;
+                rest[i] = 0;
+            } else if (asleep) {
+                ppx[i] = x;
+                ppy[i] = y;
+                continue;
+            } else {
+                rest[i] = static_cast<uint16_t>(std::min<int>(rest[i] + 1, kRestMask));
+            }
         }
-        
-        for (int i = start; i < end; ++i) {
-            particles[i].update(dt);
+        px[i] = x + (x - ppx[i]);
+        py[i] = y + (y - ppy[i]) + gravityStep;
+        ppx[i] = x;
+        ppy[i] = y;
+    }
+    
+    const float restitution = 0.8f;
+    const float left = config.worldLeft;
+    const float right = config.worldRight;
+    const float bottom = config.worldBottom;
+    const float top = config.worldTop;
+    for (size_t i = start; i < end; ++i) {
+        const float r = pr[i];
+        const float velX = px[i] - ppx[i];
+        const float velY = py[i] - ppy[i];
+
+        // Left/Right walls
+        if (px[i] - r < left) {
+            px[i] = left + r;
+            ppx[i] = px[i] + velX * restitution;
+        } else if (px[i] + r > right) {
+            px[i] = right - r;
+            ppx[i] = px[i] + velX * restitution;
         }
-        
-        const float restitution = 0.8f;
-        for (int i = start; i < end; ++i) {
-            Particle& p = particles[i];
-            glm::vec2 vel = p.position - p.previous_position;
-
-            // Left/Right walls
-            if (p.position.x - p.radius < WORLD_LEFT) {
-                p.position.x = WORLD_LEFT + p.radius;
-                p.previous_position.x = p.position.x + vel.x * restitution;
-            } else if (p.position.x + p.radius > WORLD_RIGHT) {
-                p.position.x = WORLD_RIGHT - p.radius;
-                p.previous_position.x = p.position.x + vel.x * restitution;
-            }
 
-            // Bottom/Top walls
-            if (p.position.y - p.radius < WORLD_BOTTOM) {
-                p.position.y = WORLD_BOTTOM + p.radius;
-                p.previous_position.y = p.position.y + vel.y * restitution;
-            } else if (p.position.y + p.radius > WORLD_TOP) {
-                p.position.y = WORLD_TOP - p.radius;
-                p.previous_position.y = p.position.y + vel.y * restitution;
-            }
+        // Bottom/Top walls
+        if (py[i] - r < bottom) {
+            py[i] = bottom + r;
+            ppy[i] = py[i] + velY * restitution;
+        } else if (py[i] + r > top) {
+            py[i] = top - r;
+            ppy[i] = py[i] + velY * restitution;
         }
-    };
-    partitionThreads((int)particles.size(), threadPool, work);
+    }
 }
 
 
-void Nsolver::solveCollision(int i, int j){
-    float responseFactor = 1.0f;
-    Particle &a = particles[i];
-    Particle &b = particles[j];
-    glm::vec2 delta = b.position - a.position;
-    float distSq = glm::dot(delta, delta);
-    float min_dist = a.radius + b.radius;
+// Each cell's particles, then its 8 neighbours', are copied into one contiguous block.
+// Every particle of the cell is tested against the later particles of its own cell and
+// the whole neighbourhood in a single kernel call, then the block is written back.
+// With sleeping enabled a cell whose particles are all resting is put to sleep, and is
+// skipped when its neighbours are resting too. Next to awake cells it is still solved,
+// so its sleepers absorb their neighbours' pushes instead of piling up overlap.
+void Nsolver::collideNeighborhood(const CellSpan& cell, const CellSpan (&neighbors)[8]) {
+    if (sleepEnabled()) {
+        bool resting = allResting(cell);
+        setAsleep(cell, resting);
+        for (int n = 0; n < 8 && resting; ++n) resting = allResting(neighbors[n]);
+        if (resting) return;
+    }
+
+    thread_local NeighborhoodBlock block;
+    float* px = particles.x.data();
+    float* py = particles.y.data();
+    const float* pr = particles.radius.data();
+
+    size_t total = cell.size();
+    for (const CellSpan& neighbor : neighbors) total += neighbor.size();
 
-    if (distSq < min_dist * min_dist && distSq > 1e-9f) {
-        float dist = sqrtf(distSq);
-        float inv_dist = 1.0f / dist;
-        glm::vec2 normal = delta * inv_dist;
-        float overlap = 0.5f * (min_dist - dist) * responseFactor;
+    block.reset(static_cast<uint32_t>(total));
+    block.append(cell.begin(), cell.end(), px, py, pr);
+    for (const CellSpan& neighbor : neighbors) {
+        block.append(neighbor.begin(), neighbor.end(), px, py, pr);
+    }
+    block.seal();
 
-        a.position -= normal * overlap;
-        b.position += normal * overlap;
+    const uint32_t cellCount = static_cast<uint32_t>(cell.size());
+    for (uint32_t k = 0; k < cellCount; ++k) {
+        collideKernel(k, k + 1, block.count(), block.x.data(), block.y.data(), block.r.data());
     }
+    block.writeBack(px, py);
 }
 
-// Helper to check collisions for particles in a cell against another cell
-void Nsolver::checkCellCollisions(uint32_t cellIndex, uint32_t neighborIndex) {
-    if (neighborIndex >= static_cast<uint32_t>(GRID_WIDTH * GRID_HEIGHT)) return;
-    
-    Cell& cell = grid.cells[cellIndex];
-    Cell& neighborCell = grid.cells[neighborIndex];
-    
-    for (size_t i = 0; i < cell.size(); ++i) {
-        uint32_t idx1 = cell.objects[i];
-        for (size_t j = 0; j < neighborCell.size(); ++j) {
-            solveCollision(idx1, neighborCell.objects[j]);
+// True if every particle of the span has rested for sleepSteps substeps.
+bool Nsolver::allResting(const CellSpan& span) const {
+    const uint16_t* rest = particles.rest.data();
+    const int steps = config.sleepSteps;
+    for (uint32_t p : span) {
+        if ((rest[p] & kRestMask) < steps) return false;
+    }
+    return true;
+}
+
+void Nsolver::setAsleep(const CellSpan& span, bool asleep){
+    uint16_t* rest = particles.rest.data();
+    for (uint32_t p : span) {
+        rest[p] = static_cast<uint16_t>(asleep ? rest[p] | kAsleep : rest[p] & kRestMask);
+    }
+}
+
+// A cell of finer particles against the 3x3 cells of one coarser level around it (see
+// MultiLevelGrid). The coarse particles follow the finer ones in the block; only the
+// finer ones are tested, and only against the coarse ones, since pairs within a level
+// belong to that level's own search.
+void Nsolver::collideAcross(const CellSpan& finerCell, const CellSpan (&coarse)[3][3]) {
+    thread_local NeighborhoodBlock block;
+    float* px = particles.x.data();
+    float* py = particles.y.data();
+    const float* pr = particles.radius.data();
+
+    size_t total = finerCell.size();
+    bool resting = sleepEnabled() && allResting(finerCell);
+    for (const auto& row : coarse) {
+        for (const CellSpan& cell : row) {
+            total += cell.size();
+            resting = resting && allResting(cell);
         }
     }
+    // Cross-level pairs are only tested from the finer side, so this runs unless both
+    // sides are resting
+    if (total == finerCell.size() || resting) return;
+
+    block.reset(static_cast<uint32_t>(total));
+    block.append(finerCell.begin(), finerCell.end(), px, py, pr);
+    for (const auto& row : coarse) {
+        for (const CellSpan& cell : row) block.append(cell.begin(), cell.end(), px, py, pr);
+    }
+    block.seal();
+
+    const uint32_t finerCount = static_cast<uint32_t>(finerCell.size());
+    for (uint32_t k = 0; k < finerCount; ++k) {
+        collideKernel(k, finerCount, block.count(), block.x.data(), block.y.data(), block.r.data());
+    }
+    block.writeBack(px, py);
 }
 
-// Process a range of cells (for a single thread slice)
+// Neighbour order shared by all broad phases: left, right, below, above, then diagonals.
+namespace {
+const int32_t kNeighborDx[8] = { -1, 1, 0, 0, -1, 1, -1, 1 };
+const int32_t kNeighborDy[8] = { 0, 0, -1, 1, -1, -1, 1, 1 };
+
+// Cells (row, col - 1 .. col + 1) of a sparse grid into out[0..2], advancing the row's
+// cursor; cursors only move forward while the caller walks columns left to right.
+void gatherSparseRow(const SparseCollisionGrid& sg, uint32_t& cursor, int32_t row, int32_t col, CellSpan (&out)[3]) {
+    const uint32_t occupied = static_cast<uint32_t>(sg.occupiedCount());
+    while (cursor < occupied && sg.cellRow[cursor] == row && sg.cellCol[cursor] < col - 1) ++cursor;
+    for (int d = 0; d < 3; ++d) out[d] = CellSpan();
+    for (uint32_t k = cursor; k < occupied && sg.cellRow[k] == row && sg.cellCol[k] <= col + 1; ++k) {
+        out[sg.cellCol[k] - (col - 1)] = sg.cell(k);
+    }
+}
+}
+
+// Process a range of cells within one grid row (for a single tile)
 void Nsolver::processCellRange(uint32_t start, uint32_t end) {
+    const int32_t w = grid.width;
+    int32_t gx = static_cast<int32_t>(start % w);
+    int32_t gy = static_cast<int32_t>(start / w);
+
     for (uint32_t cellIdx = start; cellIdx < end; ++cellIdx) {
-        int x = cellIdx % GRID_WIDTH;
-        int y = cellIdx / GRID_WIDTH;
-        
-        Cell& cell = grid.cells[cellIdx];
-        if (cell.size() == 0) continue;
-        
-        // Internal collisions within this cell
-        for (size_t i = 0; i < cell.size(); ++i) {
-            uint32_t idx1 = cell.objects[i];
-            for (size_t j = i + 1; j < cell.size(); ++j) {
-                solveCollision(idx1, cell.objects[j]);
+        const CellSpan cell = grid.cell(cellIdx);
+        if (!cell.empty()) {
+            // Neighbours off the grid edge stay empty rather than wrapping to the next row
+            CellSpan neighbors[8];
+            for (int n = 0; n < 8; ++n) {
+                const int32_t nx = gx + kNeighborDx[n];
+                const int32_t ny = gy + kNeighborDy[n];
+                if (grid.isValidCell(nx, ny)) neighbors[n] = grid.getCell(nx, ny);
             }
+            collideNeighborhood(cell, neighbors);
+        }
+        if (++gx == w) {
+            gx = 0;
+            ++gy;
         }
-        
-        // Check 9 neighbors using helper function (safer)
-        checkCellCollisions(cellIdx, cellIdx - 1);                    // Left
-        checkCellCollisions(cellIdx, cellIdx + 1);                    // Right
-        checkCellCollisions(cellIdx, cellIdx - GRID_WIDTH);           // Top
-        checkCellCollisions(cellIdx, cellIdx + GRID_WIDTH);           // Bottom
-        checkCellCollisions(cellIdx, cellIdx - GRID_WIDTH - 1);      // Top-left
-        checkCellCollisions(cellIdx, cellIdx - GRID_WIDTH + 1);      // Top-right
-        checkCellCollisions(cellIdx, cellIdx + GRID_WIDTH - 1);      // Bottom-left
-        checkCellCollisions(cellIdx, cellIdx + GRID_WIDTH + 1);      // Bottom-right
     }
 }
 
-// THREADED collision solving with spatial slicing (TWO-PASS to avoid race conditions)
-void Nsolver::solveCollisions(){
-    const uint32_t thread_count = static_cast<uint32_t>(threadPool.getThreadCount());
-    if (thread_count == 0) return;
-    
-    const uint32_t total_cells = GRID_WIDTH * GRID_HEIGHT;
-    const uint32_t slice_count = thread_count * 2;
-    const uint32_t slice_size = (GRID_WIDTH / slice_count) * GRID_HEIGHT;
-    const uint32_t last_slice_start = (2 * (thread_count - 1) + 2) * slice_size;
-    
-    // FIRST PASS: Process even slices (0, 2, 4, ...)
-    {
-        std::vector<std::future<void>> futures;
-        for (uint32_t i = 0; i < thread_count; ++i) {
-            futures.push_back(threadPool.enqueue([this, i, slice_size]() {
-                const uint32_t start = 2 * i * slice_size;
-                const uint32_t end = start + slice_size;
-                processCellRange(start, end);
-            }));
+// Same as processCellRange over occupied cells [first, last) of one row of the sparse
+// grid. Cells are row-major, so the left and right neighbours are the adjacent entries
+// when present, and two cursors walk forward through the rows below and above, starting
+// at `below` and `above` (the first cells of those rows that can touch `first`).
+void Nsolver::processSparseCellRange(const SparseCollisionGrid& sg, uint32_t first, uint32_t last,
+                                     uint32_t below, uint32_t above) {
+    const uint32_t occupied = static_cast<uint32_t>(sg.occupiedCount());
+
+    for (uint32_t c = first; c < last; ++c) {
+        const int32_t row = sg.cellRow[c];
+        const int32_t col = sg.cellCol[c];
+        CellSpan belowCells[3], aboveCells[3];
+        gatherSparseRow(sg, below, row - 1, col, belowCells);
+        gatherSparseRow(sg, above, row + 1, col, aboveCells);
+
+        CellSpan neighbors[8];
+        if (c > 0 && sg.cellRow[c - 1] == row && sg.cellCol[c - 1] == col - 1) neighbors[0] = sg.cell(c - 1);
+        if (c + 1 < occupied && sg.cellRow[c + 1] == row && sg.cellCol[c + 1] == col + 1) neighbors[1] = sg.cell(c + 1);
+        neighbors[2] = belowCells[1];
+        neighbors[3] = aboveCells[1];
+        neighbors[4] = belowCells[0];
+        neighbors[5] = belowCells[2];
+        neighbors[6] = aboveCells[0];
+        neighbors[7] = aboveCells[2];
+        collideNeighborhood(sg.cell(c), neighbors);
+    }
+}
+
+// Cells [col0, col1) x [row0, row1) of a sparse grid. Only occupied rows are visited,
+// and the column window and the neighbouring rows' cursors are searched within each
+// row's range only.
+void Nsolver::solveSparseTile(const SparseCollisionGrid& sg, int32_t col0, int32_t row0, int32_t col1, int32_t row1){
+    const uint32_t occupied = static_cast<uint32_t>(sg.occupiedCount());
+    uint32_t rowFirst = sg.firstCellInRow(row0);
+    while (rowFirst < occupied && sg.cellRow[rowFirst] < row1) {
+        const int32_t row = sg.cellRow[rowFirst];
+        const uint32_t rowLast = sg.firstCellInRow(row + 1);
+        const uint32_t first = sg.firstCellInColumns(rowFirst, rowLast, col0);
+        const uint32_t last = sg.firstCellInColumns(first, rowLast, col1);
+        if (first != last) {
+            const uint32_t belowFirst = sg.firstCellInRow(row - 1);
+            const uint32_t aboveLast = sg.firstCellInRow(row + 2);
+            const uint32_t below = sg.firstCellInColumns(belowFirst, rowFirst, col0 - 1);
+            const uint32_t above = sg.firstCellInColumns(rowLast, aboveLast, col0 - 1);
+            processSparseCellRange(sg, first, last, below, above);
         }
-        
-        // Handle remainder if grid not evenly divisible
-        if (last_slice_start < total_cells) {
-            futures.push_back(threadPool.enqueue([this, last_slice_start, total_cells]() {
-                processCellRange(last_slice_start, total_cells);
-            }));
+        rowFirst = rowLast;
+    }
+}
+
+// The finer particles' cells of one level within the tile, each against the level's own
+// 3x3 cells around it (see collideAcross), walked with the same forward cursors.
+void Nsolver::solveAcrossTile(const MultiLevelGrid::Level& level, int32_t col0, int32_t row0, int32_t col1, int32_t row1){
+    const SparseCollisionGrid& finer = level.finer;
+    const SparseCollisionGrid& own = level.own;
+    const uint32_t occupied = static_cast<uint32_t>(finer.occupiedCount());
+    if (own.firstCellInRow(row0 - 1) == own.firstCellInRow(row1 + 1)) return;
+
+    uint32_t rowFirst = finer.firstCellInRow(row0);
+    while (rowFirst < occupied && finer.cellRow[rowFirst] < row1) {
+        const int32_t row = finer.cellRow[rowFirst];
+        const uint32_t rowLast = finer.firstCellInRow(row + 1);
+        const uint32_t first = finer.firstCellInColumns(rowFirst, rowLast, col0);
+        const uint32_t last = finer.firstCellInColumns(first, rowLast, col1);
+        rowFirst = rowLast;
+        if (first == last) continue;
+
+        uint32_t cursor[3];
+        for (int d = 0; d < 3; ++d) {
+            const uint32_t start = own.firstCellInRow(row - 1 + d);
+            const uint32_t end = own.firstCellInRow(row + d);
+            cursor[d] = own.firstCellInColumns(start, end, col0 - 1);
         }
-        
-        // Wait for first pass to complete
-        for (auto& f : futures) {
-            f.wait();
+        for (uint32_t c = first; c < last; ++c) {
+            const int32_t col = finer.cellCol[c];
+            CellSpan coarse[3][3];
+            for (int d = 0; d < 3; ++d) gatherSparseRow(own, cursor[d], row - 1 + d, col, coarse[d]);
+            collideAcross(finer.cell(c), coarse);
         }
     }
-    
-    // SECOND PASS: Process odd slices (1, 3, 5, ...)
-    {
-        std::vector<std::future<void>> futures;
-        for (uint32_t i = 0; i < thread_count; ++i) {
-            futures.push_back(threadPool.enqueue([this, i, slice_size]() {
-                const uint32_t start = (2 * i + 1) * slice_size;
-                const uint32_t end = start + slice_size;
-                processCellRange(start, end);
-            }));
-        }
-        
-        // Wait for second pass to complete
-        for (auto& f : futures) {
-            f.wait();
+}
+
+void Nsolver::solveTile(int level, int color, int index){
+    int32_t col0, row0, col1, row1;
+    tiles[level].tileCells(color, index, col0, row0, col1, row1);
+
+    if (usesMultiLevel()) {
+        // Own cells first, then the finer particles lying in the tile's cells
+        const MultiLevelGrid::Level& cells = multiGrid.levels[level];
+        solveSparseTile(cells.own, col0, row0, col1, row1);
+        solveAcrossTile(cells, col0, row0, col1, row1);
+        return;
+    }
+    if (usesSparseGrid()) {
+        solveSparseTile(sparseGrid, col0, row0, col1, row1);
+        return;
+    }
+
+    col0 = std::max(col0, 0);
+    col1 = std::min(col1, grid.width);
+    row0 = std::max(row0, 0);
+    row1 = std::min(row1, grid.height);
+    for (int32_t row = row0; row < row1; ++row) {
+        const uint32_t rowStart = static_cast<uint32_t>(row * grid.width);
+        processCellRange(rowStart + col0, rowStart + col1);
+    }
+}
+
+// Threaded collision solving over colored tiles: the four colors run one after another
+// and each color's tiles are independent, handed out one per task so idle workers steal
+// them wherever the particles have piled up. Multi-level grids repeat this per level.
+void Nsolver::solveCollisions(){
+    for (int level = 0; level < static_cast<int>(tiles.size()); ++level) {
+        for (int color = 0; color < TileSchedule::kColors; ++color) {
+            const int count = static_cast<int>(tiles[level].tileCount(color));
+            threadPool.parallelFor(0, count, 1, [this, level, color](int first, int last) {
+                const auto t0 = std::chrono::steady_clock::now();
+                for (int i = first; i < last; ++i) solveTile(level, color, i);
+                workerLoad[threadPool.currentSlot()].busyNs += elapsedNs(t0);
+            });
         }
     }
 }
@@ -212,10 +732,10 @@ Particle Nsolver::createParticle(glm::vec2 position, glm::vec2 velocity, float r
     particle.id = static_cast<int>(particles.size());
 
     // Initialize grid coordinates
-    particle.gridX = static_cast<int>((particle.position.x - WORLD_LEFT) / CELL_SIZE);
-    particle.gridY = static_cast<int>((particle.position.y - WORLD_BOTTOM) / CELL_SIZE);
-    particle.gridX = std::max(0, std::min(particle.gridX, GRID_WIDTH - 1));
-    particle.gridY = std::max(0, std::min(particle.gridY, GRID_HEIGHT - 1));
+    particle.gridX = static_cast<int>((particle.position.x - config.worldLeft) / cellSize);
+    particle.gridY = static_cast<int>((particle.position.y - config.worldBottom) / cellSize);
+    particle.gridX = std::max(0, std::min(particle.gridX, gridWidth - 1));
+    particle.gridY = std::max(0, std::min(particle.gridY, gridHeight - 1));
 
     particle.setVelocity(velocity, dt);
     particle.acceleration = glm::vec2(0.0f);
@@ -223,41 +743,42 @@ Particle Nsolver::createParticle(glm::vec2 position, glm::vec2 velocity, float r
     return particle;
 }
 
-void Nsolver::addParticle(const Particle& particle){
-    if (std::find_if(particles.begin(), particles.end(),
-        [&particle](const Particle& p) { return p.id == particle.id; }) != particles.end()) {
-        return;
+bool Nsolver::addParticle(const Particle& particle){
+    if (particles.size() >= config.maxParticles) {
+        return false;
     }
-    particles.push_back(particle);
-
-    if (particle.gridX >= 0 && particle.gridX < GRID_WIDTH &&
-        particle.gridY >= 0 && particle.gridY < GRID_HEIGHT) {
-        if (!grid.cellContainsParticle(particle.gridX, particle.gridY, particle.id)){
-            grid.addParticle(particle.gridX, particle.gridY, static_cast<uint32_t>(particle.id));
-        }
+    if (std::find(particles.id.begin(), particles.id.end(), particle.id) != particles.id.end()) {
+        return false;
     }
+    // The grid is rebuilt from positions at the start of every substep (and resized at
+    // the start of update() if this radius needs larger cells).
+    particles.push(particle);
+    maxRadius = std::max(maxRadius, particle.radius);
+    minRadius = minRadius > 0.0f ? std::min(minRadius, particle.radius) : particle.radius;
+    return true;
 }
 
 void Nsolver::clearParticles(){
     particles.clear();
     grid.clear();
+    sparseGrid.clear();
+    multiGrid.clear();
+    maxRadius = 0.0f;
+    minRadius = 0.0f;
+    awakeCount = 0;
+    // Restart the reorder cadence so a re-spawned scene replays identically
+    framesSinceReorder = 0;
 }
 
-inline void partitionThreads(int count, TPThreadPool &threadPool, std::function<void(int, int)> work) {
-    int numThreads = static_cast<int>(threadPool.getThreadCount());
-    if (numThreads <= 0) numThreads = 1;
-    int slice = (numThreads > 0) ? (count / numThreads) : count;
-    if (slice == 0) {
+// Run work(start, end) over [0, count) on the pool. Ranges are split about four times
+// finer than the thread count so workers that finish early can steal from slow ones.
+template <typename Work>
+void partitionThreads(int count, WorkStealingPool &threadPool, const Work& work) {
+    const int numThreads = std::max(1, static_cast<int>(threadPool.getThreadCount()));
+    if (count < numThreads) {
         work(0, count);
-    } else {
-        std::vector<std::future<void>> futures;
-        futures.reserve(numThreads + 1);
-        for (int t = 0; t < numThreads; ++t) {
-            int start = t * slice;
-            int end = (t == numThreads - 1) ? count : (start + slice);
-            auto workCopy = work;
-            futures.push_back(threadPool.enqueue([workCopy, start, end]() { workCopy(start, end); }));
-        }
-        for (auto &f : futures) f.wait();
+        return;
     }
-}
\ No newline at end of file
+    const int grain = std::max(1, count / (numThreads * 4));
+    threadPool.parallelFor(0, count, grain, work);
+}
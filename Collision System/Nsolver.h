@@ -1,49 +1,171 @@
 #ifndef NEW_SOLVER_H
 #define NEW_SOLVER_H
 
-#include "thread_pool.h"
+#include "../work_stealing_pool.h"
+#include "persistent_team.h"
 #include "constants.h"
 #include "particle.h"
 #include "grid.h"
+#include "sparse_grid.h"
+#include "multilevel_grid.h"
+#include "particle_store.h"
+#include "narrow_phase.h"
+#include "solver_config.h"
+#include "tile_schedule.h"
+#include "snapshot.h"
 #include <glm/glm.hpp>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 
-using Cell = CollisionCell;
-
 class Nsolver {
 public:
-    Nsolver();
+    explicit Nsolver(const SolverConfig& config = SolverConfig());
     ~Nsolver();
     
 
     void update(float dt);
     void updateParticleGrid();
     void updateParticles(float dt);
+    void reorderParticles();
 
-    void solveCollision(int i, int j);
-    void checkPCellCollisions(int idx, Cell &cell);
-    void solveCellCollisions(Cell &cell, int idx);
     void solveCollisions();
-    void checkCellCollisions(uint32_t cellIndex, uint32_t neighborIndex);
     void processCellRange(uint32_t start, uint32_t end);
+    void processSparseCellRange(const SparseCollisionGrid& sg, uint32_t first, uint32_t last,
+                                uint32_t below, uint32_t above);
+    void solveTile(int level, int color, int index);
 
     Particle createParticle(glm::vec2 position, glm::vec2 velocity, float r, float dt, bool noColor);
-    void addParticle(const Particle& particle);
+    // Returns false when the particle's id already exists or maxParticles is reached.
+    bool addParticle(const Particle& particle);
     void clearParticles();
 
     float getLastPhysicsTime() const { return lastPhysicsTime; }
-    std::vector<Particle>& getParticles() { return particles; }
+    ParticleView getParticles() { return ParticleView(particles); }
+    const ParticleStore& getParticleStore() const { return particles; }
     size_t getParticleCount() const { return particles.size(); }
+    // Particles not asleep after the last update() (see SolverConfig::sleepSpeed)
+    size_t getAwakeCount() const { return awakeCount; }
+    size_t getThreadCount() const { return threadPool.getThreadCount(); }
+    // The solver's workers, for other per-frame parallel passes (never call from inside update())
+    WorkStealingPool& getThreadPool() { return threadPool; }
+    const SolverConfig& getConfig() const { return config; }
+    float getCellSize() const { return cellSize; }
+    int getGridWidth() const { return gridWidth; }
+    int getGridHeight() const { return gridHeight; }
+
+    // Requested grid cell edge (0 = auto, see tuneCellSize) and narrow-phase tile edge
+    void setCellSize(float size);
+    void setTileSize(int cells) { config.tileSize = std::max(2, cells); }
+
+    // Dense grid, sparse cells or multi-level cells (see BroadPhase); takes effect immediately.
+    void setBroadPhase(BroadPhase broadPhase);
+    BroadPhase getBroadPhase() const { return config.broadPhase; }
+    // Speed below which particles may fall asleep (<= 0 disables sleeping and wakes everyone)
+    void setSleepSpeed(float speed);
+    // Cells holding at least one particle after the last grid build (sparse and
+    // multi-level broad phases only, summed over levels)
+    size_t getOccupiedCellCount() const;
+    // Grid levels in use (1 unless the broad phase is MultiLevel) and their cell edges
+    int getLevelCount() const { return static_cast<int>(tiles.size()); }
+    float getLevelCellSize(int level) const { return usesMultiLevel() ? multiGrid.levels[level].cellSize : cellSize; }
+
+    // Write the particle arrays, config, frame counters and randomFloat() engine to a
+    // binary snapshot (format in snapshot.h), plus caller state in `extras`.
+    bool saveSnapshot(const std::string& path, const SnapshotExtras& extras = SnapshotExtras()) const;
+    // Replace the solver state with a snapshot; the thread count stays as constructed.
+    // On failure the solver is unchanged and false is returned.
+    bool loadSnapshot(const std::string& path, SnapshotExtras* extras = nullptr);
+
+    // Narrow-phase load balance over the last update(): each worker's busy time in the
+    // tile passes, and the busiest worker over the mean (1.0 = perfectly even).
+    const std::vector<double>& getWorkerBusyMs() const { return workerBusyMs; }
+    float getLoadImbalance() const { return loadImbalance; }
+
+    // Particles are re-sorted into grid-cell order every `frames` calls to update() (0 disables).
+    void setReorderInterval(int frames) { reorderInterval = frames; }
+
+    // Narrow-phase instruction set; defaults to the best one the CPU supports.
+    void setSimdLevel(SimdLevel level);
+    SimdLevel getSimdLevel() const { return simdLevel; }
+
+    // Fixed-point narrow phase (see SolverConfig::deterministic)
+    void setDeterministic(bool enabled);
+    bool isDeterministic() const { return config.deterministic; }
+
+    // Run substeps on a persistent team parked on a barrier instead of dispatching
+    // each phase through the pool. Results are identical either way.
+    void setPersistentTeam(bool enabled);
+    bool usesPersistentTeam() const { return team != nullptr; }
 
 
 private:
+    void updateWithTeam(float dt, bool reorder);
+    void integrateRange(size_t start, size_t end, float dt);
+    void binGridChunk(int chunk, int chunks);
+    void chunkRange(int chunk, int chunks, size_t& start, size_t& end) const;
+    void configureGrid(float cellSize);
+    void collideNeighborhood(const CellSpan& cell, const CellSpan (&neighbors)[8]);
+    void collideAcross(const CellSpan& finerCell, const CellSpan (&coarse)[3][3]);
+    bool allResting(const CellSpan& span) const;
+    void setAsleep(const CellSpan& span, bool asleep);
+    void countAwake();
+    void solveSparseTile(const SparseCollisionGrid& sg, int32_t col0, int32_t row0, int32_t col1, int32_t row1);
+    void solveAcrossTile(const MultiLevelGrid::Level& level, int32_t col0, int32_t row0, int32_t col1, int32_t row1);
+    float tunedCellSize() const;
+    float multiLevelTopCell() const;
+    bool usesSparseGrid() const { return config.broadPhase == BroadPhase::SparseHash; }
+    bool usesMultiLevel() const { return config.broadPhase == BroadPhase::MultiLevel; }
+    bool sleepEnabled() const { return config.sleepSpeed > 0.0f; }
+    void buildTileSchedule(int chunks);
+    void recordLoadBalance();
+
+    // ParticleStore::rest: substeps spent resting in the low bits, kAsleep while asleep
+    static constexpr uint16_t kAsleep = 0x8000;
+    static constexpr uint16_t kRestMask = 0x7fff;
+
+    struct ChunkBounds {
+        float minX = std::numeric_limits<float>::max();
+        float minY = std::numeric_limits<float>::max();
+        float maxX = std::numeric_limits<float>::lowest();
+        float maxY = std::numeric_limits<float>::lowest();
+    };
+    // One per worker, padded so workers never share a cache line
+    struct alignas(64) WorkerLoad {
+        int64_t busyNs = 0;
+    };
+
+    SolverConfig config;
     CollisionGrid grid;
-    std::vector<Particle> particles;
-    TPThreadPool threadPool;
-    int iterations = 8;
+    SparseCollisionGrid sparseGrid;
+    MultiLevelGrid multiGrid;
+    std::vector<uint32_t> levelOrder;
+    float cellSize = 0.0f;
+    int gridWidth = 1;      // nominal world size in cells
+    int gridHeight = 1;
+    ParticleStore particles;
+    ParticleStore reorderScratch;
+    WorkStealingPool threadPool;
+    std::unique_ptr<PersistentTeam> team;
+    std::vector<TileSchedule> tiles;    // one per grid level
+    std::atomic<int> tileCursor[MultiLevelGrid::kMaxLevels * TileSchedule::kColors] = {};
+    std::vector<ChunkBounds> chunkBounds;
+    std::vector<WorkerLoad> workerLoad;
+    std::vector<double> workerBusyMs;
+    float loadImbalance = 1.0f;
+    size_t awakeCount = 0;
     float DAMPENING = 0.9f;
+    SimdLevel simdLevel = SimdLevel::Scalar;
+    CollideFn collideKernel = collideParticleScalar;
+    int reorderInterval = 16;
+    int framesSinceReorder = 0;
+    float maxRadius = 0.0f;
+    float minRadius = 0.0f;
     mutable float lastPhysicsTime = 0.0f;
 };
 #endif // NEW_SOLVER_H
 
-inline void partitionThreads(int count, TPThreadPool &threadPool, std::function<void(int, int)> work);
\ No newline at end of file
+template <typename Work>
+void partitionThreads(int count, WorkStealingPool &threadPool, const Work& work);
\ No newline at end of file
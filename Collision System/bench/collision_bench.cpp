@@ -0,0 +1,359 @@
+// Headless collision solver benchmark. Runs the same fixed-step stream spawning as the
+// windowed app (STREAM_COUNT particles every AUTO_SPAWN_INTERVAL, launched with
+// CONSTANT_VELOCITY, capped at MAX_PARTICLES) without any OpenGL, then reports the
+// per-step physics time distribution, throughput, and a checksum of the final state.
+//
+// Usage: CollisionBench [--steps N] [--threads N] [--team] [--simd scalar|sse41|avx2]
+//                       [--substeps N] [--max-particles N] [--cell-size S]
+//                       [--sweep-cells S1,S2,...] [--sparse] [--world-scale K]
+//                       [--tile N] [--load-snapshot FILE] [--save-snapshot FILE]
+//                       [--multilevel] [--radius R] [--boulders R,FRACTION] [--sleep SPEED]
+//                       [--deterministic]
+//
+// --cell-size 0 (the default) lets the solver size cells from the particle radius.
+// --sweep-cells reruns the whole benchmark once per cell size and prints one summary
+// row each, to compare throughput against grid resolution in a single invocation.
+// --sparse uses the sparse broad phase instead of the dense grid, and --world-scale
+// grows the world K times in each direction around the same spawn stream (a mostly
+// empty world). --tile sets the narrow-phase tile edge in cells.
+// --radius sets the spawn radius (0.07 by default) and --boulders spawns that FRACTION
+// of particles (the same ones every run) with radius R instead, for sand-plus-boulders
+// scenes; --multilevel selects the multi-level broad phase built for such mixes.
+// Compare both with e.g. --radius 0.01 --boulders 0.1,0.05.
+// --sleep sets SolverConfig::sleepSpeed (0 disables sleeping); the particle count line
+// shows how many were awake at the end.
+// --deterministic selects the fixed-point narrow phase, whose checksum is the same for
+// every --simd level (and machine), not only for every thread count.
+//
+// --load-snapshot starts from a saved state (for example a settled pile) instead of an
+// empty world and runs --steps more steps; --save-snapshot writes the final state. The
+// snapshot's config is used, except for an explicit --cell-size, --tile, --sparse,
+// --multilevel, --sleep or --deterministic.
+// Loading a snapshot saved after N steps and running M more gives the same checksum as
+// running N + M steps in one go with the same options.
+//
+// "imbalance" is the busiest worker's narrow-phase time over the mean, averaged over
+// steps (1.00 = every worker equally busy).
+//
+// The checksum covers every particle's position in id order, so two runs with the same
+// options must print the same value; a change means the simulation itself changed.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+#include "Nsolver.h"
+#include "stream_spawner.h"
+
+namespace {
+
+const float kFixedDeltaTime = 1.0f / 120.0f;
+
+struct Options {
+    int steps = 3000;
+    int threads = 0;
+    bool team = false;
+    bool simdSet = false;
+    SimdLevel simd = SimdLevel::Scalar;
+    SolverConfig config;
+    std::vector<float> sweepCells;
+    bool tileSet = false;
+    bool sleepSet = false;
+    std::string loadPath;
+    std::string savePath;
+    float radius = 0.07f;
+    float boulderRadius = 0.0f;
+    float boulderFraction = 0.0f;
+};
+
+struct RunResult {
+    std::vector<double> stepMs;
+    double totalMs = 0.0;
+    size_t particles = 0;
+    size_t awake = 0;
+    size_t threads = 0;
+    bool team = false;
+    SimdLevel simd = SimdLevel::Scalar;
+    bool deterministic = false;
+    float cellSize = 0.0f;
+    int gridWidth = 0;
+    int gridHeight = 0;
+    size_t occupiedCells = 0;
+    int levels = 1;
+    float topCellSize = 0.0f;
+    double imbalanceSum = 0.0;
+    std::vector<double> workerBusyMs;
+    uint64_t checksum = 0;
+};
+
+void printUsage() {
+    std::cerr << "Usage: CollisionBench [--steps N] [--threads N] [--team] "
+                 "[--simd scalar|sse41|avx2]\n"
+                 "                      [--substeps N] [--max-particles N] [--cell-size S]\n"
+                 "                      [--sweep-cells S1,S2,...] [--sparse] [--world-scale K]\n"
+                 "                      [--tile N] [--load-snapshot FILE] [--save-snapshot FILE]\n"
+                 "                      [--multilevel] [--radius R] [--boulders R,FRACTION] [--sleep SPEED]\n"
+                 "                      [--deterministic]\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--steps" && hasValue) {
+            options.steps = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--substeps" && hasValue) {
+            options.config.substeps = std::atoi(argv[++i]);
+            if (options.config.substeps <= 0) return false;
+        } else if (arg == "--max-particles" && hasValue) {
+            const long count = std::atol(argv[++i]);
+            if (count <= 0) return false;
+            options.config.maxParticles = static_cast<size_t>(count);
+        } else if (arg == "--cell-size" && hasValue) {
+            options.config.cellSize = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--sweep-cells" && hasValue) {
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                const float size = static_cast<float>(std::atof(item.c_str()));
+                if (size <= 0.0f) return false;
+                options.sweepCells.push_back(size);
+            }
+            if (options.sweepCells.empty()) return false;
+        } else if (arg == "--world-scale" && hasValue) {
+            const float scale = static_cast<float>(std::atof(argv[++i]));
+            if (scale < 1.0f) return false;
+            SolverConfig& config = options.config;
+            config.worldRight = config.worldLeft + config.width() * scale;
+            config.worldBottom = config.worldTop - config.height() * scale;
+        } else if (arg == "--tile" && hasValue) {
+            options.config.tileSize = std::atoi(argv[++i]);
+            options.tileSet = true;
+            if (options.config.tileSize < 2) return false;
+        } else if (arg == "--load-snapshot" && hasValue) {
+            options.loadPath = argv[++i];
+        } else if (arg == "--save-snapshot" && hasValue) {
+            options.savePath = argv[++i];
+        } else if (arg == "--radius" && hasValue) {
+            options.radius = static_cast<float>(std::atof(argv[++i]));
+            if (options.radius <= 0.0f) return false;
+        } else if (arg == "--boulders" && hasValue) {
+            const std::string mix = argv[++i];
+            const size_t comma = mix.find(',');
+            if (comma == std::string::npos) return false;
+            options.boulderRadius = static_cast<float>(std::atof(mix.substr(0, comma).c_str()));
+            options.boulderFraction = static_cast<float>(std::atof(mix.substr(comma + 1).c_str()));
+            if (options.boulderRadius <= 0.0f || options.boulderFraction < 0.0f || options.boulderFraction > 1.0f) {
+                return false;
+            }
+        } else if (arg == "--sleep" && hasValue) {
+            options.config.sleepSpeed = static_cast<float>(std::atof(argv[++i]));
+            options.sleepSet = true;
+        } else if (arg == "--deterministic") {
+            options.config.deterministic = true;
+        } else if (arg == "--sparse") {
+            options.config.broadPhase = BroadPhase::SparseHash;
+        } else if (arg == "--multilevel") {
+            options.config.broadPhase = BroadPhase::MultiLevel;
+        } else if (arg == "--team") {
+            options.team = true;
+        } else if (arg == "--simd" && hasValue) {
+            const std::string level = argv[++i];
+            options.simdSet = true;
+            if (level == "scalar") options.simd = SimdLevel::Scalar;
+            else if (level == "sse41") options.simd = SimdLevel::SSE41;
+            else if (level == "avx2") options.simd = SimdLevel::AVX2;
+            else return false;
+        } else {
+            return false;
+        }
+    }
+    options.config.threads = options.threads;
+    return options.steps > 0;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    const size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// FNV-1a over the bit patterns of every position, visited in particle id order
+uint64_t positionChecksum(Nsolver& solver) {
+    const ParticleView particles = solver.getParticles();
+    std::vector<glm::vec2> byId(particles.size());
+    for (const auto& p : particles) {
+        byId[static_cast<size_t>(p.id)] = p.position;
+    }
+
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int b = 0; b < 4; ++b) {
+            hash ^= (bits >> (8 * b)) & 0xFFu;
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const glm::vec2& position : byId) {
+        mix(position.x);
+        mix(position.y);
+    }
+    return hash;
+}
+
+// Radius of the n-th spawned particle. Boulders are picked by hashing n alone, so the
+// choice does not consume randomFloat() draws or depend on the run.
+float spawnRadius(const Options& options, size_t n) {
+    if (options.boulderFraction <= 0.0f) return options.radius;
+    uint32_t h = static_cast<uint32_t>(n) * 2654435761u;
+    h ^= h >> 16;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    const float u = static_cast<float>(h >> 8) / 16777216.0f;
+    return u < options.boulderFraction ? options.boulderRadius : options.radius;
+}
+
+bool runBench(const Options& options, const SolverConfig& config, RunResult& result) {
+    Nsolver solver(config);
+    if (options.simdSet) solver.setSimdLevel(options.simd);
+    solver.setPersistentTeam(options.team);
+
+    SnapshotExtras extras;
+    if (!options.loadPath.empty()) {
+        if (!solver.loadSnapshot(options.loadPath, &extras)) return false;
+        if (config.cellSize > 0.0f) solver.setCellSize(config.cellSize);
+        if (options.tileSet) solver.setTileSize(config.tileSize);
+        if (config.broadPhase != BroadPhase::DenseGrid) solver.setBroadPhase(config.broadPhase);
+        if (options.sleepSet) solver.setSleepSpeed(config.sleepSpeed);
+        if (config.deterministic) solver.setDeterministic(true);
+    }
+
+    const SolverConfig& world = solver.getConfig();
+    StreamSpawner spawner(world.worldLeft, world.worldBottom, world.worldTop);
+    spawner.timer = extras.spawnTimer;
+    result.stepMs.reserve(options.steps);
+
+    for (int step = 0; step < options.steps; ++step) {
+        spawner.step(kFixedDeltaTime, [&solver, &options](glm::vec2 spawnPos) {
+            const float radius = spawnRadius(options, solver.getParticleCount());
+            return solver.addParticle(solver.createParticle(spawnPos, CONSTANT_VELOCITY, radius,
+                                                            kFixedDeltaTime, true));
+        });
+
+        const auto t0 = std::chrono::steady_clock::now();
+        solver.update(kFixedDeltaTime);
+        const auto t1 = std::chrono::steady_clock::now();
+        result.stepMs.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+
+        const std::vector<double>& busy = solver.getWorkerBusyMs();
+        result.workerBusyMs.resize(busy.size());
+        for (size_t w = 0; w < busy.size(); ++w) result.workerBusyMs[w] += busy[w];
+        result.imbalanceSum += solver.getLoadImbalance();
+    }
+
+    for (double ms : result.stepMs) result.totalMs += ms;
+    result.particles = solver.getParticleCount();
+    result.awake = solver.getAwakeCount();
+    result.threads = solver.getThreadCount();
+    result.team = solver.usesPersistentTeam();
+    result.simd = solver.getSimdLevel();
+    result.deterministic = solver.isDeterministic();
+    result.gridWidth = solver.getGridWidth();
+    result.gridHeight = solver.getGridHeight();
+    result.occupiedCells = solver.getOccupiedCellCount();
+    result.levels = solver.getLevelCount();
+    result.cellSize = solver.getLevelCellSize(0);
+    result.topCellSize = solver.getLevelCellSize(result.levels - 1);
+    result.checksum = positionChecksum(solver);
+
+    if (!options.savePath.empty()) {
+        extras.step += static_cast<uint64_t>(options.steps);
+        extras.spawnTimer = spawner.timer;
+        if (!solver.saveSnapshot(options.savePath, extras)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    if (!options.sweepCells.empty()) {
+        std::cout << "CollisionBench cell-size sweep (" << options.steps << " steps)\n"
+                  << "   cell   grid       particles   mean ms    p99 ms   steps/sec  imbalance  checksum\n";
+        for (float cellSize : options.sweepCells) {
+            SolverConfig config = options.config;
+            config.cellSize = cellSize;
+            RunResult run;
+            if (!runBench(options, config, run)) return 1;
+            std::vector<double> sorted = run.stepMs;
+            std::sort(sorted.begin(), sorted.end());
+            std::ostringstream grid;
+            grid << run.gridWidth << "x" << run.gridHeight;
+            std::cout << std::fixed << std::setprecision(3)
+                      << std::setw(7) << run.cellSize << "   " << std::left << std::setw(9) << grid.str()
+                      << std::right << std::setw(11) << run.particles
+                      << std::setw(10) << run.totalMs / options.steps
+                      << std::setw(10) << percentile(sorted, 0.99)
+                      << std::setprecision(1) << std::setw(12) << (options.steps * 1000.0 / run.totalMs)
+                      << std::setprecision(2) << std::setw(11) << run.imbalanceSum / options.steps
+                      << "  0x" << std::hex << std::setw(16) << std::setfill('0') << run.checksum
+                      << std::dec << std::setfill(' ') << "\n";
+        }
+        return 0;
+    }
+
+    RunResult run;
+    if (!runBench(options, options.config, run)) return 1;
+    std::vector<double> sorted = run.stepMs;
+    std::sort(sorted.begin(), sorted.end());
+    const double totalMs = run.totalMs;
+
+    std::cout << "CollisionBench\n"
+              << "  threads     : " << run.threads
+              << (run.team ? " (persistent team)" : " (work-stealing pool)") << "\n"
+              << "  narrow phase: " << simdLevelName(run.simd)
+              << (run.deterministic ? " (fixed point)" : "") << "\n"
+              << "  grid        : " << run.gridWidth << "x" << run.gridHeight
+              << " cells of " << run.cellSize;
+    if (options.config.broadPhase == BroadPhase::SparseHash) {
+        std::cout << ", sparse (" << run.occupiedCells << " occupied)";
+    } else if (options.config.broadPhase == BroadPhase::MultiLevel) {
+        std::cout << " to " << run.topCellSize << ", " << run.levels << " levels ("
+                  << run.occupiedCells << " occupied)";
+    }
+    std::cout << "\n"
+              << "  steps       : " << options.steps << "\n"
+              << "  particles   : " << run.particles << " (" << run.awake << " awake)\n"
+              << std::fixed << std::setprecision(3)
+              << "  physics ms  : total " << totalMs
+              << " | mean " << totalMs / options.steps
+              << " | p50 " << percentile(sorted, 0.50)
+              << " | p90 " << percentile(sorted, 0.90)
+              << " | p99 " << percentile(sorted, 0.99)
+              << " | max " << sorted.back() << "\n"
+              << std::setprecision(1)
+              << "  steps/sec   : " << (options.steps * 1000.0 / totalMs) << "\n"
+              << std::setprecision(2)
+              << "  imbalance   : " << run.imbalanceSum / options.steps << " (busy ms per worker:";
+    for (double ms : run.workerBusyMs) std::cout << " " << std::setprecision(0) << ms;
+    std::cout << ")\n"
+              << "  checksum    : 0x" << std::hex << std::setw(16) << std::setfill('0')
+              << run.checksum << std::dec << std::endl;
+    return 0;
+}
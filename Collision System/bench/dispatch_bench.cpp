@@ -0,0 +1,147 @@
+// Task dispatch overhead benchmark: TPThreadPool (one mutex-guarded std::function queue)
+// vs WorkStealingPool (per-worker Chase-Lev deques) vs PersistentTeam (barrier lockstep).
+// Task bodies are empty, so the timings are pure scheduling cost.
+//
+//   per-index   parallelFor with one task per index (TPThreadPool::parallelFor's model)
+//   fork/join   one task per thread, the shape of Nsolver's partitionThreads and each
+//               solveCollisions pass (24+ of these run every frame)
+//   substep     the synchronization one Nsolver substep pays: five fork/joins
+//               (integrate, count, scatter, even, odd) on the pools, or five team
+//               barriers plus the frame's start/end crossings spread over 8 substeps
+//
+// Usage: CollisionDispatchBench [threads]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "persistent_team.h"
+#include "thread_pool.h"
+#include "work_stealing_pool.h"
+
+namespace {
+
+constexpr int kIndexTasks = 20000;
+constexpr int kIndexRepeats = 5;
+constexpr int kForkJoinLoops = 20000;
+constexpr int kFrames = 2000;
+constexpr int kSubsteps = 8;
+constexpr int kPhasesPerSubstep = 5;
+
+std::atomic<int> sink{0};
+
+template <typename Fn>
+double timeNs(Fn&& fn) {
+    fn(); // warm-up
+    auto t0 = std::chrono::high_resolution_clock::now();
+    fn();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count();
+}
+
+void printRow(const char* name, double tpNs, double wsNs, const char* unit) {
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(12) << name << std::setw(16) << tpNs << std::setw(16) << wsNs
+              << std::setw(9) << (tpNs / wsNs) << "x  " << unit << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (argc > 1) threads = std::atoi(argv[1]);
+    threads = std::max(1, threads);
+
+    TPThreadPool tp(threads);
+    WorkStealingPool ws(threads);
+
+    std::cout << "Dispatch overhead benchmark (" << threads << " threads)\n";
+    std::cout << std::setw(12) << "case" << std::setw(16) << "TPThreadPool"
+              << std::setw(16) << "WorkStealing" << std::setw(10) << "speedup" << "\n";
+
+    // One task per index
+    const double tpIndex = timeNs([&] {
+        for (int r = 0; r < kIndexRepeats; ++r) {
+            tp.parallelFor(0, kIndexTasks, [](int i) { sink.fetch_add(i & 1, std::memory_order_relaxed); });
+        }
+    }) / (static_cast<double>(kIndexTasks) * kIndexRepeats);
+    const double wsIndex = timeNs([&] {
+        for (int r = 0; r < kIndexRepeats; ++r) {
+            ws.parallelFor(0, kIndexTasks, 1, [](int first, int last) {
+                for (int i = first; i < last; ++i) sink.fetch_add(i & 1, std::memory_order_relaxed);
+            });
+        }
+    }) / (static_cast<double>(kIndexTasks) * kIndexRepeats);
+    printRow("per-index", tpIndex, wsIndex, "ns/task");
+
+    // One task per thread, waited on as a batch
+    const double tpForkJoin = timeNs([&] {
+        std::vector<std::future<void>> futures;
+        for (int loop = 0; loop < kForkJoinLoops; ++loop) {
+            futures.clear();
+            for (int t = 0; t < threads; ++t) {
+                futures.push_back(tp.enqueue([t]() { sink.fetch_add(t & 1, std::memory_order_relaxed); }));
+            }
+            for (auto& f : futures) f.wait();
+        }
+    }) / kForkJoinLoops;
+    const double wsForkJoin = timeNs([&] {
+        for (int loop = 0; loop < kForkJoinLoops; ++loop) {
+            ws.parallelFor(0, threads, 1, [](int first, int last) {
+                for (int t = first; t < last; ++t) sink.fetch_add(t & 1, std::memory_order_relaxed);
+            });
+        }
+    }) / kForkJoinLoops;
+    printRow("fork/join", tpForkJoin, wsForkJoin, "ns/loop");
+
+    // One substep's worth of phases
+    const double tpSubstep = timeNs([&] {
+        std::vector<std::future<void>> futures;
+        for (int step = 0; step < kFrames * kSubsteps; ++step) {
+            for (int phase = 0; phase < kPhasesPerSubstep; ++phase) {
+                futures.clear();
+                for (int t = 0; t < threads; ++t) {
+                    futures.push_back(tp.enqueue([t]() { sink.fetch_add(t & 1, std::memory_order_relaxed); }));
+                }
+                for (auto& f : futures) f.wait();
+            }
+        }
+    }) / (kFrames * kSubsteps);
+    const double wsSubstep = timeNs([&] {
+        for (int step = 0; step < kFrames * kSubsteps; ++step) {
+            for (int phase = 0; phase < kPhasesPerSubstep; ++phase) {
+                ws.parallelFor(0, threads, 1, [](int first, int last) {
+                    for (int t = first; t < last; ++t) sink.fetch_add(t & 1, std::memory_order_relaxed);
+                });
+            }
+        }
+    }) / (kFrames * kSubsteps);
+
+    PersistentTeam team(threads);
+    const double teamSubstep = timeNs([&] {
+        for (int frame = 0; frame < kFrames; ++frame) {
+            team.run([&team](int worker) {
+                for (int step = 0; step < kSubsteps; ++step) {
+                    for (int phase = 0; phase < kPhasesPerSubstep; ++phase) {
+                        sink.fetch_add(worker & 1, std::memory_order_relaxed);
+                        team.sync();
+                    }
+                }
+            });
+        }
+    }) / (kFrames * kSubsteps);
+
+    std::cout << "\nPer-substep sync overhead (" << kPhasesPerSubstep << " phases, ns/substep)\n";
+    std::cout << std::setw(12) << "" << std::setw(16) << "TPThreadPool"
+              << std::setw(16) << "WorkStealing" << std::setw(16) << "PersistentTeam" << "\n";
+    std::cout << std::fixed << std::setprecision(1) << std::setw(12) << "substep"
+              << std::setw(16) << tpSubstep << std::setw(16) << wsSubstep
+              << std::setw(16) << teamSubstep << "\n";
+
+    return sink.load() == -1 ? 1 : 0;
+}
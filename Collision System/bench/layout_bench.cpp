@@ -0,0 +1,190 @@
+// Particle layout benchmark: AoS (std::vector<Particle>) vs SoA (ParticleStore).
+// Both paths run the same single-threaded substep (Verlet + walls, grid rebuild,
+// cell-vs-neighbour collisions) so the memory layout is the only variable.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "constants.h"
+#include "grid.h"
+#include "particle.h"
+#include "particle_store.h"
+
+namespace {
+
+constexpr int kSubsteps = 64;
+constexpr float kSubDt = (1.0f / 120.0f) / 8.0f;
+constexpr float kRestitution = 0.8f;
+
+template <typename PairFn>
+void collideGrid(CollisionGrid& grid, PairFn&& solve) {
+    const int total = GRID_WIDTH * GRID_HEIGHT;
+    for (int c = 0; c < total; ++c) {
+        const CellSpan cell = grid.cell(c);
+        if (cell.empty()) continue;
+        for (size_t i = 0; i < cell.size(); ++i)
+            for (size_t j = i + 1; j < cell.size(); ++j)
+                solve(cell[i], cell[j]);
+
+        const int offsets[8] = { -1, 1, -GRID_WIDTH, GRID_WIDTH,
+                                 -GRID_WIDTH - 1, -GRID_WIDTH + 1, GRID_WIDTH - 1, GRID_WIDTH + 1 };
+        for (int o : offsets) {
+            const int n = c + o;
+            if (n < 0 || n >= total) continue;
+            const CellSpan other = grid.cell(n);
+            for (uint32_t a : cell)
+                for (uint32_t b : other)
+                    solve(a, b);
+        }
+    }
+}
+
+void substepAoS(std::vector<Particle>& particles, CollisionGrid& grid) {
+    const glm::vec2 g(0.0f, -GRAVITY);
+    for (auto& p : particles) {
+        p.accelerate(g);
+        p.update(kSubDt);
+        glm::vec2 vel = p.position - p.previous_position;
+        if (p.position.x - p.radius < WORLD_LEFT) {
+            p.position.x = WORLD_LEFT + p.radius;
+            p.previous_position.x = p.position.x + vel.x * kRestitution;
+        } else if (p.position.x + p.radius > WORLD_RIGHT) {
+            p.position.x = WORLD_RIGHT - p.radius;
+            p.previous_position.x = p.position.x + vel.x * kRestitution;
+        }
+        if (p.position.y - p.radius < WORLD_BOTTOM) {
+            p.position.y = WORLD_BOTTOM + p.radius;
+            p.previous_position.y = p.position.y + vel.y * kRestitution;
+        } else if (p.position.y + p.radius > WORLD_TOP) {
+            p.position.y = WORLD_TOP - p.radius;
+            p.previous_position.y = p.position.y + vel.y * kRestitution;
+        }
+    }
+
+    grid.particleCell.resize(particles.size());
+    for (size_t i = 0; i < particles.size(); ++i) {
+        grid.particleCell[i] = grid.cellIndexFor(particles[i].position.x, particles[i].position.y);
+    }
+    grid.build(particles.size());
+
+    collideGrid(grid, [&particles](uint32_t i, uint32_t j) {
+        Particle& a = particles[i];
+        Particle& b = particles[j];
+        glm::vec2 delta = b.position - a.position;
+        float distSq = glm::dot(delta, delta);
+        float minDist = a.radius + b.radius;
+        if (distSq < minDist * minDist && distSq > 1e-9f) {
+            float dist = std::sqrt(distSq);
+            glm::vec2 normal = delta * (1.0f / dist);
+            float overlap = 0.5f * (minDist - dist);
+            a.position -= normal * overlap;
+            b.position += normal * overlap;
+        }
+    });
+}
+
+void substepSoA(ParticleStore& s, CollisionGrid& grid) {
+    float* px = s.x.data();
+    float* py = s.y.data();
+    float* ppx = s.prevX.data();
+    float* ppy = s.prevY.data();
+    const float* pr = s.radius.data();
+    const size_t n = s.size();
+
+    const float gravityStep = -GRAVITY * kSubDt * kSubDt;
+    for (size_t i = 0; i < n; ++i) {
+        const float x = px[i];
+        const float y = py[i];
+        px[i] = x + (x - ppx[i]);
+        py[i] = y + (y - ppy[i]) + gravityStep;
+        ppx[i] = x;
+        ppy[i] = y;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const float r = pr[i];
+        const float velX = px[i] - ppx[i];
+        const float velY = py[i] - ppy[i];
+        if (px[i] - r < WORLD_LEFT) { px[i] = WORLD_LEFT + r; ppx[i] = px[i] + velX * kRestitution; }
+        else if (px[i] + r > WORLD_RIGHT) { px[i] = WORLD_RIGHT - r; ppx[i] = px[i] + velX * kRestitution; }
+        if (py[i] - r < WORLD_BOTTOM) { py[i] = WORLD_BOTTOM + r; ppy[i] = py[i] + velY * kRestitution; }
+        else if (py[i] + r > WORLD_TOP) { py[i] = WORLD_TOP - r; ppy[i] = py[i] + velY * kRestitution; }
+    }
+
+    grid.particleCell.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        grid.particleCell[i] = grid.cellIndexFor(px[i], py[i]);
+    }
+    grid.build(n);
+
+    collideGrid(grid, [px, py, pr](uint32_t i, uint32_t j) {
+        const float dx = px[j] - px[i];
+        const float dy = py[j] - py[i];
+        const float distSq = dx * dx + dy * dy;
+        const float minDist = pr[i] + pr[j];
+        if (distSq < minDist * minDist && distSq > 1e-9f) {
+            const float dist = std::sqrt(distSq);
+            const float scale = 0.5f * (minDist - dist) / dist;
+            px[i] -= dx * scale;
+            py[i] -= dy * scale;
+            px[j] += dx * scale;
+            py[j] += dy * scale;
+        }
+    });
+}
+
+std::vector<Particle> makeParticles(int count) {
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<float> xs(WORLD_LEFT + MAX_PARTICLE_RADIUS, WORLD_RIGHT - MAX_PARTICLE_RADIUS);
+    std::uniform_real_distribution<float> ys(WORLD_BOTTOM + MAX_PARTICLE_RADIUS, WORLD_TOP - MAX_PARTICLE_RADIUS);
+    std::vector<Particle> out(count);
+    for (int i = 0; i < count; ++i) {
+        out[i].position = glm::vec2(xs(gen), ys(gen));
+        out[i].previous_position = out[i].position;
+        out[i].radius = MAX_PARTICLE_RADIUS;
+        out[i].id = i;
+    }
+    return out;
+}
+
+template <typename Fn>
+double nsPerParticleSubstep(int count, Fn&& substep) {
+    substep(); // warm-up
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int s = 0; s < kSubsteps; ++s) substep();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    return ns / (static_cast<double>(count) * kSubsteps);
+}
+
+} // namespace
+
+int main() {
+    const int counts[] = { 5000, MAX_PARTICLES, 100000 };
+
+    std::cout << "Particle layout benchmark (" << kSubsteps << " substeps, single thread)\n";
+    std::cout << std::setw(10) << "particles" << std::setw(14) << "AoS ns/p/s"
+              << std::setw(14) << "SoA ns/p/s" << std::setw(10) << "speedup" << "\n";
+
+    for (int count : counts) {
+        std::vector<Particle> aos = makeParticles(count);
+        ParticleStore soa;
+        soa.reserve(aos.size());
+        for (const auto& p : aos) soa.push(p);
+
+        CollisionGrid gridA(GRID_WIDTH, GRID_HEIGHT, CELL_SIZE, WORLD_LEFT, WORLD_BOTTOM);
+        CollisionGrid gridB(GRID_WIDTH, GRID_HEIGHT, CELL_SIZE, WORLD_LEFT, WORLD_BOTTOM);
+
+        double aosNs = nsPerParticleSubstep(count, [&] { substepAoS(aos, gridA); });
+        double soaNs = nsPerParticleSubstep(count, [&] { substepSoA(soa, gridB); });
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(10) << count << std::setw(14) << aosNs
+                  << std::setw(14) << soaNs << std::setw(9) << (aosNs / soaNs) << "x\n";
+    }
+    return 0;
+}
@@ -34,3 +34,9 @@ const float CELL_SIZE_X = WORLD_WIDTH  / GRID_WIDTH;
 const float CELL_SIZE_Y = WORLD_HEIGHT / GRID_HEIGHT;
 
 const float GRAVITY = 9.81f;
+
+// Particles slower than SLEEP_SPEED (world units per second) on average over SLEEP_STEPS
+// substeps may sleep; a contact push faster than WAKE_SPEED wakes them (see SolverConfig)
+const float SLEEP_SPEED = 0.15f;
+const float WAKE_SPEED = 0.6f;
+const int SLEEP_STEPS = 240;
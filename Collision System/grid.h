@@ -3,70 +3,137 @@
 #include <cstdint>
 #include <vector>
 #include <algorithm>
-#include <array> 
-#include <cstdint>
-
-struct CollisionCell {
-    static constexpr size_t CELL_CAPACITY = 16; 
+#include <numeric>
 
-    std::array<uint32_t, CELL_CAPACITY> objects;
-    size_t count = 0;
-
-    void addParticle(uint32_t id) {
-        if (count < CELL_CAPACITY) {
-            objects[count] = id;
-            count++;
-        }
-    }
+// Contiguous run of particle indices belonging to one grid cell.
+struct CellSpan {
+    const uint32_t* first = nullptr;
+    const uint32_t* last = nullptr;
 
-    void clear() {
-        count = 0;
-    }
-
-    size_t size() const {
-        return count;
-    }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    uint32_t operator[](size_t i) const { return first[i]; }
 
     // Iterators
-    uint32_t* begin() { return objects.data(); }
-    uint32_t* end() { return objects.data() + count; }
-    const uint32_t* begin() const { return objects.data(); }
-    const uint32_t* end() const { return objects.data() + count; }
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
 };
 
 
+// Compact uniform grid built with a counting sort:
+//   1. countChunk   - every chunk of particles builds its own per-cell histogram
+//   2. computeOffsets - prefix sum over (cell, chunk) gives each chunk its write cursor
+//   3. scatterChunk - every chunk writes its particle indices into the flat array
+// Chunks touch disjoint histogram rows and disjoint output slots, so passes 1 and 3
+// can run on separate threads. Cells have no capacity limit and the result is stable
+// (particles within a cell stay in index order) regardless of the chunk count.
+// Every chunk costs a full cellCount() row to clear and a serial pass to scan, so use
+// chunksFor to pick the count: a mostly empty grid is not worth splitting.
 struct CollisionGrid {
     int32_t width, height;
     float cell_size;
-    std::vector<CollisionCell> cells;
-    
-    CollisionGrid(int32_t w, int32_t h, float cs) 
-        : width(w), height(h), cell_size(cs) {
-        cells.resize(w * h);
+    float originX, originY;
+
+    std::vector<uint32_t> cellStart;    // width*height + 1 offsets into objects
+    std::vector<uint32_t> objects;      // particle indices grouped by cell
+    std::vector<uint32_t> particleCell; // cell of each particle, filled by the caller before counting
+    std::vector<uint32_t> chunkCounts;  // chunk-major histograms, reused as scatter cursors
+    int32_t chunkCount = 1;
+
+    CollisionGrid(int32_t w, int32_t h, float cs, float ox = 0.0f, float oy = 0.0f)
+        : width(w), height(h), cell_size(cs), originX(ox), originY(oy) {
+        cellStart.assign(static_cast<size_t>(w) * h + 1, 0);
     }
-    
+
+    size_t cellCount() const { return static_cast<size_t>(width) * height; }
+
     void clear() {
-        for (auto& cell : cells) cell.clear();
+        objects.clear();
+        particleCell.clear();
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+    }
+
+    // Cell index for a world position, clamped to the grid.
+    uint32_t cellIndexFor(float x, float y) const {
+        int32_t gx = static_cast<int32_t>((x - originX) / cell_size);
+        int32_t gy = static_cast<int32_t>((y - originY) / cell_size);
+        gx = std::max(0, std::min(gx, width - 1));
+        gy = std::max(0, std::min(gy, height - 1));
+        return static_cast<uint32_t>(gy * width + gx);
     }
 
-    bool cellContainsParticle(int32_t x, int32_t y, uint32_t particleID) const {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            const CollisionCell &cell = cells[y * width + x];
-            return std::find(cell.objects.begin(), cell.objects.end(), particleID) != cell.objects.end();
+    // Histogram chunks worth using for particleCount particles, at most maxChunks: the
+    // rows beyond the first together cost no more than one pass over the particles.
+    int32_t chunksFor(size_t particleCount, int32_t maxChunks) const {
+        const size_t extra = particleCount / std::max<size_t>(cellCount(), 1);
+        return static_cast<int32_t>(std::min<size_t>(std::max(1, maxChunks), 1 + extra));
+    }
+
+    // Size the build buffers. Must run (single-threaded) before the counting passes.
+    void resize(size_t particleCount, int32_t chunks) {
+        chunkCount = std::max(1, chunks);
+        objects.resize(particleCount);
+        particleCell.resize(particleCount);
+        chunkCounts.resize(cellCount() * chunkCount);
+    }
+
+    // Pass 1: histogram of particleCell[start, end) into this chunk's row.
+    void countChunk(int32_t chunk, size_t start, size_t end) {
+        uint32_t* counts = chunkCounts.data() + cellCount() * chunk;
+        std::fill(counts, counts + cellCount(), 0u);
+        for (size_t i = start; i < end; ++i) {
+            counts[particleCell[i]]++;
         }
-        return false;
     }
 
-    void addParticle(int32_t x, int32_t y, uint32_t particleID) {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            cells[y * width + x].addParticle(particleID);
+    // Pass 2: exclusive prefix sum in (cell, chunk) order. Fills cellStart and turns
+    // each histogram entry into that chunk's first write slot for the cell.
+    void computeOffsets() {
+        const size_t cells = cellCount();
+        uint32_t running = 0;
+        for (size_t c = 0; c < cells; ++c) {
+            cellStart[c] = running;
+            for (int32_t k = 0; k < chunkCount; ++k) {
+                uint32_t& slot = chunkCounts[cells * k + c];
+                const uint32_t count = slot;
+                slot = running;
+                running += count;
+            }
         }
+        cellStart[cells] = running;
     }
-    
-    CollisionCell& getCell(int32_t x, int32_t y) {
-        return cells[y * width + x];
+
+    // Pass 3: write particle indices [start, end) to their cell slots.
+    void scatterChunk(int32_t chunk, size_t start, size_t end) {
+        uint32_t* cursor = chunkCounts.data() + cellCount() * chunk;
+        for (size_t i = start; i < end; ++i) {
+            objects[cursor[particleCell[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Single-threaded build over particleCell[0, particleCount).
+    void build(size_t particleCount) {
+        resize(particleCount, 1);
+        countChunk(0, 0, particleCount);
+        computeOffsets();
+        scatterChunk(0, 0, particleCount);
     }
-    
+
+    // After the particle storage has been permuted into objects order, every cell
+    // holds a contiguous index range and objects becomes the identity.
+    void adoptSortedOrder() {
+        std::iota(objects.begin(), objects.end(), 0u);
+    }
+
+    CellSpan cell(uint32_t index) const {
+        const uint32_t* base = objects.data();
+        return CellSpan{ base + cellStart[index], base + cellStart[index + 1] };
+    }
+
+    CellSpan getCell(int32_t x, int32_t y) const {
+        return cell(static_cast<uint32_t>(y * width + x));
+    }
+
     bool isValidCell(int32_t x, int32_t y) const {
         return x >= 0 && x < width && y >= 0 && y < height;
     }
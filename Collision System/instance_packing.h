@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "particle_store.h"
+
+// Per-particle attributes streamed to the GPU for instanced circle rendering.
+// 16 bytes: world position, radius and an RGBA8 color (normalized in the shader).
+struct ParticleInstance {
+    float x;
+    float y;
+    float radius;
+    uint32_t color;
+};
+static_assert(sizeof(ParticleInstance) == 16, "ParticleInstance must stay 16 bytes");
+
+// Quantize a [0, 1] color to RGBA8 with opaque alpha (R in the lowest byte, matching
+// GL_UNSIGNED_BYTE attribute order on little-endian machines).
+inline uint32_t packInstanceColor(const glm::vec3& color) {
+    auto channel = [](float c) {
+        return static_cast<uint32_t>(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+    };
+    return channel(color.x) | (channel(color.y) << 8) | (channel(color.z) << 16) | (0xFFu << 24);
+}
+
+// Fill out[0, count) from the particle store, where count = min(store.size(), capacity).
+// Plain CPU code with no GL dependency; the renderer points it straight at mapped
+// buffer memory. Returns the number of instances written.
+inline size_t packParticleInstances(const ParticleStore& store, ParticleInstance* out, size_t capacity) {
+    const size_t count = std::min(store.size(), capacity);
+    const float* px = store.x.data();
+    const float* py = store.y.data();
+    const float* pr = store.radius.data();
+    const glm::vec3* pc = store.color.data();
+    for (size_t i = 0; i < count; ++i) {
+        out[i].x = px[i];
+        out[i].y = py[i];
+        out[i].radius = pr[i];
+        out[i].color = packInstanceColor(pc[i]);
+    }
+    return count;
+}
@@ -2,68 +2,197 @@
 #define MAP_PIXEL_H
 
 #include <array>
-#include <map>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <stb_image.h>
-#include "particle.h"
+#include "particle_store.h"
+#include "../work_stealing_pool.h"
 
 using PixelData = std::array<float, 3>;
 
+enum class PixelFilter {
+    Nearest,    // the single texel under the particle center
+    Bilinear,   // 2x2 texels around the center, weighted
+    Box         // mean over the texels the particle's disk bounding square covers
+};
+
+// Image-to-particle color mapping. The image is decoded once and kept, together with a
+// summed-area table for box filtering, so mapping the same scene to a new image costs one
+// decode plus one parallel pass over the particles. Results live in a flat array indexed
+// by particle id, ready to copy into Particle::color.
 struct MapPixel {
-    std::map<int, PixelData> idToColor;
+    std::vector<PixelData> idToColor;       // id -> color in [0, 1]
 
-    void addParticles(const std::vector<Particle>& particles, const std::string& imagePath, 
-                     float worldWidth, float worldHeight) {
-        idToColor.clear();
-        int imgWidth, imgHeight, channels;
+    // Nearest matches the original per-texel lookup; Box averages what a particle covers
+    PixelFilter filter = PixelFilter::Nearest;
+
+    // Decode an image file (flipped so row 0 is the bottom, like world space)
+    void loadImage(const std::string& imagePath) {
+        int w, h, channels;
         stbi_set_flip_vertically_on_load(true);
-        unsigned char* imgData = stbi_load(imagePath.c_str(), &imgWidth, &imgHeight, &channels, 3);
-        if (!imgData) throw std::runtime_error("Failed to load image");
-        
+        unsigned char* data = stbi_load(imagePath.c_str(), &w, &h, &channels, 3);
+        if (!data) throw std::runtime_error("Failed to load image");
+        setImage(w, h, data);
+        stbi_image_free(data);
+    }
+
+    // Use an RGB8 buffer of w*h texels, row 0 at the bottom.
+    void setImage(int w, int h, const unsigned char* rgb) {
+        if (w <= 0 || h <= 0) throw std::runtime_error("Empty image");
+        imgWidth = w;
+        imgHeight = h;
+        texels.assign(rgb, rgb + static_cast<size_t>(w) * h * 3);
+
+        // Summed-area table with a zero border: sat[(y+1)*(w+1) + x+1] = sum of [0..x]x[0..y]
+        const size_t stride = static_cast<size_t>(w) + 1;
+        sat.assign(stride * (h + 1) * 3, 0.0);
+        for (int y = 0; y < h; ++y) {
+            double row[3] = { 0.0, 0.0, 0.0 };
+            for (int x = 0; x < w; ++x) {
+                const size_t t = (static_cast<size_t>(y) * w + x) * 3;
+                const size_t s = ((y + 1) * stride + x + 1) * 3;
+                const size_t above = (y * stride + x + 1) * 3;
+                for (int c = 0; c < 3; ++c) {
+                    row[c] += texels[t + c];
+                    sat[s + c] = sat[above + c] + row[c];
+                }
+            }
+        }
+    }
+
+    bool hasImage() const { return imgWidth > 0; }
+
+    // Sample every particle's color from the current image and store it by particle id.
+    // The world rectangle [worldLeft, worldLeft + worldWidth] x [worldBottom, ...] is
+    // stretched over the whole image. Runs on `pool` when given.
+    void mapParticles(const ParticleStore& particles, float worldLeft, float worldBottom,
+                      float worldWidth, float worldHeight, WorkStealingPool* pool = nullptr) {
+        if (!hasImage()) throw std::runtime_error("No image loaded");
+
+        int maxId = -1;
+        for (int id : particles.id) maxId = std::max(maxId, id);
+        const size_t slots = static_cast<size_t>(maxId + 1);
+        idToColor.assign(slots, defaultColor());
+        mappedCount = particles.size();
+
+        const float toPixelX = imgWidth / worldWidth;
+        const float toPixelY = imgHeight / worldHeight;
+        auto mapRange = [&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                const float px = (particles.x[i] - worldLeft) * toPixelX;
+                const float py = (particles.y[i] - worldBottom) * toPixelY;
+                const float pr = particles.radius[i] * std::max(toPixelX, toPixelY);
+                idToColor[particles.id[i]] = sample(px, py, pr);
+            }
+        };
+
+        const int count = static_cast<int>(particles.size());
+        if (pool) {
+            pool->parallelFor(0, count, 1024, mapRange);
+        } else {
+            mapRange(0, count);
+        }
+    }
+
+    // Load an image and map particles to it (world centered on the origin)
+    void addParticles(const ParticleStore& particles, const std::string& imagePath,
+                      float worldWidth, float worldHeight, WorkStealingPool* pool = nullptr) {
+        loadImage(imagePath);
         std::cout << "Image: " << imgWidth << "x" << imgHeight << ", World: " << worldWidth << "x" << worldHeight << std::endl;
         std::cout << "Mapping " << particles.size() << " particles spatially..." << std::endl;
-        
-        // Map each particle directly based on its world position to image position
-        for (const auto& p : particles) {
-            // Normalize particle position to [0, 1] range
-            float normX = (p.position.x - (-worldWidth/2.0f)) / worldWidth;
-            float normY = (p.position.y - (-worldHeight/2.0f)) / worldHeight;
-            
-            // Clamp to [0, 1]
-            normX = std::max(0.0f, std::min(1.0f, normX));
-            normY = std::max(0.0f, std::min(1.0f, normY));
-            
-            // Convert to pixel coordinates
-            int pixelX = std::min((int)(normX * imgWidth), imgWidth - 1);
-            int pixelY = std::min((int)(normY * imgHeight), imgHeight - 1);
-            
-            // Sample image
-            int index = (pixelY * imgWidth + pixelX) * 3;
-            PixelData color = {
-                imgData[index] / 255.0f,
-                imgData[index + 1] / 255.0f,
-                imgData[index + 2] / 255.0f
-            };
-            
-            // Store by particle ID
-            idToColor[p.id] = color;
-        }
-        
-        stbi_image_free(imgData);
-        std::cout << "Mapped " << idToColor.size() << " particles spatially by ID" << std::endl;
+        mapParticles(particles, -worldWidth / 2.0f, -worldHeight / 2.0f, worldWidth, worldHeight, pool);
+        std::cout << "Mapped " << mappedCount << " particles spatially by ID" << std::endl;
     }
 
     PixelData getColorById(int id) const {
-        auto it = idToColor.find(id);
-        return (it != idToColor.end()) ? it->second : PixelData{0.5f, 0.5f, 0.5f};
+        return (id >= 0 && static_cast<size_t>(id) < idToColor.size()) ? idToColor[id] : defaultColor();
+    }
+
+    void clear() {
+        idToColor.clear();
+        mappedCount = 0;
+    }
+
+    bool hasColors() const { return mappedCount > 0; }
+    size_t size() const { return mappedCount; }
+
+    // Color at image position (x, y) in texels (texel k spans [k, k + 1)), with `radius`
+    // in texels used by the box filter.
+    PixelData sample(float x, float y, float radius) const {
+        switch (filter) {
+            case PixelFilter::Nearest: return sampleNearest(x, y);
+            case PixelFilter::Bilinear: return sampleBilinear(x, y);
+            case PixelFilter::Box: default: return sampleBox(x, y, radius);
+        }
+    }
+
+private:
+    int imgWidth = 0;
+    int imgHeight = 0;
+    size_t mappedCount = 0;
+    std::vector<unsigned char> texels;      // RGB8, row 0 at the bottom
+    std::vector<double> sat;                // (w+1) x (h+1) x RGB summed-area table
+
+    static PixelData defaultColor() { return PixelData{ 0.5f, 0.5f, 0.5f }; }
+
+    int clampX(int x) const { return std::max(0, std::min(x, imgWidth - 1)); }
+    int clampY(int y) const { return std::max(0, std::min(y, imgHeight - 1)); }
+
+    const unsigned char* texel(int x, int y) const {
+        return texels.data() + (static_cast<size_t>(clampY(y)) * imgWidth + clampX(x)) * 3;
+    }
+
+    static int floorToInt(float v) {
+        const int i = static_cast<int>(v);
+        return (v < 0.0f && static_cast<float>(i) != v) ? i - 1 : i;
+    }
+
+    PixelData sampleNearest(float x, float y) const {
+        const unsigned char* t = texel(floorToInt(x), floorToInt(y));
+        return PixelData{ t[0] / 255.0f, t[1] / 255.0f, t[2] / 255.0f };
+    }
+
+    PixelData sampleBilinear(float x, float y) const {
+        // Texel centers sit at k + 0.5
+        const float fx = x - 0.5f;
+        const float fy = y - 0.5f;
+        const int x0 = floorToInt(fx);
+        const int y0 = floorToInt(fy);
+        const float tx = fx - x0;
+        const float ty = fy - y0;
+        const unsigned char* a = texel(x0, y0);
+        const unsigned char* b = texel(x0 + 1, y0);
+        const unsigned char* c = texel(x0, y0 + 1);
+        const unsigned char* d = texel(x0 + 1, y0 + 1);
+        PixelData out;
+        for (int k = 0; k < 3; ++k) {
+            const float bottom = a[k] + (b[k] - a[k]) * tx;
+            const float top = c[k] + (d[k] - c[k]) * tx;
+            out[k] = (bottom + (top - bottom) * ty) / 255.0f;
+        }
+        return out;
+    }
+
+    // Mean of the texels overlapping [x - r, x + r] x [y - r, y + r], in O(1) from the SAT
+    PixelData sampleBox(float x, float y, float radius) const {
+        const int x0 = clampX(floorToInt(x - radius));
+        const int y0 = clampY(floorToInt(y - radius));
+        const int x1 = clampX(floorToInt(x + radius)) + 1;
+        const int y1 = clampY(floorToInt(y + radius)) + 1;
+        const size_t stride = static_cast<size_t>(imgWidth) + 1;
+        const double area = static_cast<double>(x1 - x0) * (y1 - y0);
+        PixelData out;
+        for (int k = 0; k < 3; ++k) {
+            const double sum = sat[(y1 * stride + x1) * 3 + k] - sat[(y0 * stride + x1) * 3 + k]
+                             - sat[(y1 * stride + x0) * 3 + k] + sat[(y0 * stride + x0) * 3 + k];
+            out[k] = static_cast<float>(sum / (area * 255.0));
+        }
+        return out;
     }
-    
-    bool hasColors() const { return !idToColor.empty(); }
-    size_t size() const { return idToColor.size(); }
 };
 
 #endif
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "sparse_grid.h"
+
+// Broad phase for polydisperse particles (radii spanning several times). A single grid
+// must use cells of the largest diameter, so a small particle next to a boulder shares
+// its cell with dozens of other small ones. Here the top level has cells of the largest
+// diameter, every level below half the size of the one above down to the smallest
+// diameter, and every particle lives only in the finest level whose cells fit it.
+//
+// Pairs are found once each:
+//   - same level: the usual cell + 8 neighbours search within that level
+//   - across levels, from the finer particle only: a particle of level a that lies in
+//     cell c of a coarser level b is tested against level b's particles in the 3x3 cells
+//     around c. Its radius is at most half of level a's cell and the coarse one's at most
+//     half of level b's, so any contact is within one level-b cell.
+// For that second search each level also keys the particles of every finer level by its
+// own cells (`finer`). Everything a level-b cell's search writes then lies in the 3x3
+// level-b cells around it, so level b runs on its own tile schedule exactly like the
+// single-level grids, and the levels run one after another.
+//
+// Each level is a SparseCollisionGrid, so empty levels and empty space cost nothing.
+struct MultiLevelGrid {
+    static constexpr int kMaxLevels = 8;
+
+    struct Level {
+        float cellSize = 1.0f;
+        SparseCollisionGrid own{ 1.0f };    // particles whose radius belongs to this level
+        SparseCollisionGrid finer{ 1.0f };  // particles of all finer levels, in this level's cells
+        std::vector<uint32_t> ownIndex;     // particle index of every own / finer entry
+        std::vector<uint32_t> finerIndex;
+    };
+
+    float originX = 0.0f;
+    float originY = 0.0f;
+    std::vector<Level> levels;
+    std::vector<uint8_t> particleLevel;  // level of every particle after build()
+
+    MultiLevelGrid() : levels(1) {}
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+
+    // Level cells from topCellSize (the largest diameter) halving down to the last size
+    // still >= minCellSize (the smallest diameter), at most kMaxLevels of them.
+    void configure(float minCellSize, float topCellSize, float ox, float oy) {
+        originX = ox;
+        originY = oy;
+        topCellSize = std::max(topCellSize, minCellSize);
+        int count = 1;
+        while (count < kMaxLevels && topCellSize / static_cast<float>(1 << count) >= minCellSize) ++count;
+        levels.resize(count);
+        float size = topCellSize;
+        for (int l = count - 1; l >= 0; --l) {
+            levels[l].cellSize = size;
+            levels[l].own = SparseCollisionGrid(size, ox, oy);
+            levels[l].finer = SparseCollisionGrid(size, ox, oy);
+            size *= 0.5f;
+        }
+    }
+
+    // Finest level whose cells are at least the particle's diameter
+    int levelFor(float radius) const {
+        const int last = levelCount() - 1;
+        int level = 0;
+        while (level < last && 2.0f * radius > levels[level].cellSize) ++level;
+        return level;
+    }
+
+    // Bin particles [0, count) into their levels and sort every level into cells.
+    // Entries keep ascending particle index within a cell, so results do not depend on
+    // how the caller split any earlier work. Finer particles are only searched against
+    // a level's own particles, so empty levels get no finer entries either.
+    void build(const float* x, const float* y, const float* radius, size_t count) {
+        particleLevel.resize(count);
+        int ownCount[kMaxLevels] = {};
+        for (size_t i = 0; i < count; ++i) {
+            const int l = levelFor(radius[i]);
+            particleLevel[i] = static_cast<uint8_t>(l);
+            ++ownCount[l];
+        }
+        size_t finerCount = 0;
+        for (int l = 0; l < levelCount(); ++l) {
+            Level& level = levels[l];
+            level.ownIndex.clear();
+            level.finerIndex.clear();
+            level.ownIndex.reserve(ownCount[l]);
+            if (ownCount[l] > 0) level.finerIndex.reserve(finerCount);
+            finerCount += ownCount[l];
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            const int l = particleLevel[i];
+            levels[l].ownIndex.push_back(i);
+            for (int coarser = l + 1; coarser < levelCount(); ++coarser) {
+                if (ownCount[coarser] > 0) levels[coarser].finerIndex.push_back(i);
+            }
+        }
+        for (Level& level : levels) {
+            buildSubset(level.own, level.ownIndex, x, y);
+            buildSubset(level.finer, level.finerIndex, x, y);
+        }
+    }
+
+    // Every particle once, level by level in cell order (for Nsolver::reorderParticles)
+    void cellOrder(std::vector<uint32_t>& order) const {
+        order.clear();
+        for (const Level& level : levels) {
+            order.insert(order.end(), level.own.objects.begin(), level.own.objects.end());
+        }
+    }
+
+    size_t occupiedCount() const {
+        size_t total = 0;
+        for (const Level& level : levels) total += level.own.occupiedCount();
+        return total;
+    }
+
+    void clear() {
+        for (Level& level : levels) {
+            level.own.clear();
+            level.finer.clear();
+            level.ownIndex.clear();
+            level.finerIndex.clear();
+        }
+        particleLevel.clear();
+    }
+
+private:
+    static void buildSubset(SparseCollisionGrid& grid, const std::vector<uint32_t>& index,
+                            const float* x, const float* y) {
+        grid.resize(index.size());
+        for (size_t k = 0; k < index.size(); ++k) {
+            grid.particleKey[k] = grid.keyFor(x[index[k]], y[index[k]]);
+        }
+        grid.build(index.size(), index.data());
+    }
+};
@@ -0,0 +1,337 @@
+#include "narrow_phase.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NARROW_PHASE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NARROW_PHASE_TARGET(isa)
+#else
+#define NARROW_PHASE_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace {
+constexpr float kMinDistSq = 1e-9f;
+constexpr float kFixedScale = 1.0f / kFixedStep;
+}
+
+void collideParticleScalar(uint32_t i, uint32_t begin, uint32_t end,
+                           float* x, float* y, const float* r) {
+    const float xi = x[i];
+    const float yi = y[i];
+    const float ri = r[i];
+    float accX = 0.0f;
+    float accY = 0.0f;
+
+    for (uint32_t j = begin; j < end; ++j) {
+        const float dx = x[j] - xi;
+        const float dy = y[j] - yi;
+        const float distSq = dx * dx + dy * dy;
+        const float minDist = ri + r[j];
+
+        if (distSq < minDist * minDist && distSq > kMinDistSq) {
+            const float dist = std::sqrt(distSq);
+            const float scale = 0.5f * (minDist - dist) / dist;
+            const float offX = dx * scale;
+            const float offY = dy * scale;
+            x[j] += offX;
+            y[j] += offY;
+            accX += offX;
+            accY += offY;
+        }
+    }
+
+    x[i] -= accX;
+    y[i] -= accY;
+}
+
+void collideParticleFixedScalar(uint32_t i, uint32_t begin, uint32_t end,
+                                float* x, float* y, const float* r) {
+    const float xi = x[i];
+    const float yi = y[i];
+    const float ri = r[i];
+    int32_t accX = 0;
+    int32_t accY = 0;
+
+    for (uint32_t j = begin; j < end; ++j) {
+        const float dx = x[j] - xi;
+        const float dy = y[j] - yi;
+        const float distSq = dx * dx + dy * dy;
+        const float minDist = ri + r[j];
+
+        if (distSq < minDist * minDist && distSq > kMinDistSq) {
+            const float dist = std::sqrt(distSq);
+            const float scale = 0.5f * (minDist - dist) / dist;
+            // Rounded like cvtps2dq under the default rounding mode
+            const int32_t offX = static_cast<int32_t>(std::lrint(dx * scale * kFixedScale));
+            const int32_t offY = static_cast<int32_t>(std::lrint(dy * scale * kFixedScale));
+            x[j] += static_cast<float>(offX) * kFixedStep;
+            y[j] += static_cast<float>(offY) * kFixedStep;
+            accX += offX;
+            accY += offY;
+        }
+    }
+
+    x[i] -= static_cast<float>(accX) * kFixedStep;
+    y[i] -= static_cast<float>(accY) * kFixedStep;
+}
+
+#ifdef NARROW_PHASE_X86
+
+namespace {
+
+NARROW_PHASE_TARGET("sse4.1")
+void collideParticleSSE41(uint32_t i, uint32_t begin, uint32_t end,
+                          float* x, float* y, const float* r) {
+    const __m128 xi = _mm_set1_ps(x[i]);
+    const __m128 yi = _mm_set1_ps(y[i]);
+    const __m128 ri = _mm_set1_ps(r[i]);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minDistSq = _mm_set1_ps(kMinDistSq);
+    __m128 accX = _mm_setzero_ps();
+    __m128 accY = _mm_setzero_ps();
+
+    // Lanes past `end` read sentinel padding and never overlap
+    for (uint32_t j = begin; j < end; j += 4) {
+        const __m128 xj = _mm_loadu_ps(x + j);
+        const __m128 yj = _mm_loadu_ps(y + j);
+        const __m128 rj = _mm_loadu_ps(r + j);
+
+        const __m128 dx = _mm_sub_ps(xj, xi);
+        const __m128 dy = _mm_sub_ps(yj, yi);
+        const __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        const __m128 minDist = _mm_add_ps(ri, rj);
+        const __m128 hit = _mm_and_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(minDist, minDist)),
+                                      _mm_cmpgt_ps(distSq, minDistSq));
+        if (_mm_movemask_ps(hit) == 0) continue;
+
+        const __m128 dist = _mm_sqrt_ps(_mm_blendv_ps(one, distSq, hit));
+        const __m128 scale = _mm_and_ps(hit, _mm_div_ps(_mm_mul_ps(half, _mm_sub_ps(minDist, dist)), dist));
+        const __m128 offX = _mm_mul_ps(dx, scale);
+        const __m128 offY = _mm_mul_ps(dy, scale);
+
+        _mm_storeu_ps(x + j, _mm_add_ps(xj, offX));
+        _mm_storeu_ps(y + j, _mm_add_ps(yj, offY));
+        accX = _mm_add_ps(accX, offX);
+        accY = _mm_add_ps(accY, offY);
+    }
+
+    alignas(16) float sumX[4];
+    alignas(16) float sumY[4];
+    _mm_store_ps(sumX, accX);
+    _mm_store_ps(sumY, accY);
+    x[i] -= (sumX[0] + sumX[1]) + (sumX[2] + sumX[3]);
+    y[i] -= (sumY[0] + sumY[1]) + (sumY[2] + sumY[3]);
+}
+
+NARROW_PHASE_TARGET("sse4.1")
+void collideParticleFixedSSE41(uint32_t i, uint32_t begin, uint32_t end,
+                               float* x, float* y, const float* r) {
+    const __m128 xi = _mm_set1_ps(x[i]);
+    const __m128 yi = _mm_set1_ps(y[i]);
+    const __m128 ri = _mm_set1_ps(r[i]);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minDistSq = _mm_set1_ps(kMinDistSq);
+    const __m128 fixedScale = _mm_set1_ps(kFixedScale);
+    const __m128 fixedStep = _mm_set1_ps(kFixedStep);
+    __m128i accX = _mm_setzero_si128();
+    __m128i accY = _mm_setzero_si128();
+
+    for (uint32_t j = begin; j < end; j += 4) {
+        const __m128 xj = _mm_loadu_ps(x + j);
+        const __m128 yj = _mm_loadu_ps(y + j);
+        const __m128 rj = _mm_loadu_ps(r + j);
+
+        const __m128 dx = _mm_sub_ps(xj, xi);
+        const __m128 dy = _mm_sub_ps(yj, yi);
+        const __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        const __m128 minDist = _mm_add_ps(ri, rj);
+        const __m128 hit = _mm_and_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(minDist, minDist)),
+                                      _mm_cmpgt_ps(distSq, minDistSq));
+        if (_mm_movemask_ps(hit) == 0) continue;
+
+        const __m128 dist = _mm_sqrt_ps(_mm_blendv_ps(one, distSq, hit));
+        const __m128 scale = _mm_and_ps(hit, _mm_div_ps(_mm_mul_ps(half, _mm_sub_ps(minDist, dist)), dist));
+        const __m128i offX = _mm_cvtps_epi32(_mm_mul_ps(_mm_mul_ps(dx, scale), fixedScale));
+        const __m128i offY = _mm_cvtps_epi32(_mm_mul_ps(_mm_mul_ps(dy, scale), fixedScale));
+
+        // Only hit lanes are written, as in the scalar kernel (x + 0 would turn -0 into +0)
+        const __m128 newX = _mm_add_ps(xj, _mm_mul_ps(_mm_cvtepi32_ps(offX), fixedStep));
+        const __m128 newY = _mm_add_ps(yj, _mm_mul_ps(_mm_cvtepi32_ps(offY), fixedStep));
+        _mm_storeu_ps(x + j, _mm_blendv_ps(xj, newX, hit));
+        _mm_storeu_ps(y + j, _mm_blendv_ps(yj, newY, hit));
+        accX = _mm_add_epi32(accX, offX);
+        accY = _mm_add_epi32(accY, offY);
+    }
+
+    alignas(16) int32_t sumX[4];
+    alignas(16) int32_t sumY[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(sumX), accX);
+    _mm_store_si128(reinterpret_cast<__m128i*>(sumY), accY);
+    x[i] -= static_cast<float>(sumX[0] + sumX[1] + sumX[2] + sumX[3]) * kFixedStep;
+    y[i] -= static_cast<float>(sumY[0] + sumY[1] + sumY[2] + sumY[3]) * kFixedStep;
+}
+
+NARROW_PHASE_TARGET("avx2")
+void collideParticleAVX2(uint32_t i, uint32_t begin, uint32_t end,
+                         float* x, float* y, const float* r) {
+    const __m256 xi = _mm256_set1_ps(x[i]);
+    const __m256 yi = _mm256_set1_ps(y[i]);
+    const __m256 ri = _mm256_set1_ps(r[i]);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minDistSq = _mm256_set1_ps(kMinDistSq);
+    __m256 accX = _mm256_setzero_ps();
+    __m256 accY = _mm256_setzero_ps();
+
+    // Lanes past `end` read sentinel padding and never overlap
+    for (uint32_t j = begin; j < end; j += 8) {
+        const __m256 xj = _mm256_loadu_ps(x + j);
+        const __m256 yj = _mm256_loadu_ps(y + j);
+        const __m256 rj = _mm256_loadu_ps(r + j);
+
+        const __m256 dx = _mm256_sub_ps(xj, xi);
+        const __m256 dy = _mm256_sub_ps(yj, yi);
+        const __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        const __m256 minDist = _mm256_add_ps(ri, rj);
+        const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(minDist, minDist), _CMP_LT_OQ),
+                                         _mm256_cmp_ps(distSq, minDistSq, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(hit) == 0) continue;
+
+        const __m256 dist = _mm256_sqrt_ps(_mm256_blendv_ps(one, distSq, hit));
+        const __m256 scale = _mm256_and_ps(hit, _mm256_div_ps(_mm256_mul_ps(half, _mm256_sub_ps(minDist, dist)), dist));
+        const __m256 offX = _mm256_mul_ps(dx, scale);
+        const __m256 offY = _mm256_mul_ps(dy, scale);
+
+        // Masked-out lanes add zero, so the whole vector is written back
+        _mm256_storeu_ps(x + j, _mm256_add_ps(xj, offX));
+        _mm256_storeu_ps(y + j, _mm256_add_ps(yj, offY));
+        accX = _mm256_add_ps(accX, offX);
+        accY = _mm256_add_ps(accY, offY);
+    }
+
+    const __m128 sum4X = _mm_add_ps(_mm256_castps256_ps128(accX), _mm256_extractf128_ps(accX, 1));
+    const __m128 sum4Y = _mm_add_ps(_mm256_castps256_ps128(accY), _mm256_extractf128_ps(accY, 1));
+    alignas(16) float sumX[4];
+    alignas(16) float sumY[4];
+    _mm_store_ps(sumX, sum4X);
+    _mm_store_ps(sumY, sum4Y);
+    x[i] -= (sumX[0] + sumX[1]) + (sumX[2] + sumX[3]);
+    y[i] -= (sumY[0] + sumY[1]) + (sumY[2] + sumY[3]);
+}
+
+NARROW_PHASE_TARGET("avx2")
+void collideParticleFixedAVX2(uint32_t i, uint32_t begin, uint32_t end,
+                              float* x, float* y, const float* r) {
+    const __m256 xi = _mm256_set1_ps(x[i]);
+    const __m256 yi = _mm256_set1_ps(y[i]);
+    const __m256 ri = _mm256_set1_ps(r[i]);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minDistSq = _mm256_set1_ps(kMinDistSq);
+    const __m256 fixedScale = _mm256_set1_ps(kFixedScale);
+    const __m256 fixedStep = _mm256_set1_ps(kFixedStep);
+    __m256i accX = _mm256_setzero_si256();
+    __m256i accY = _mm256_setzero_si256();
+
+    for (uint32_t j = begin; j < end; j += 8) {
+        const __m256 xj = _mm256_loadu_ps(x + j);
+        const __m256 yj = _mm256_loadu_ps(y + j);
+        const __m256 rj = _mm256_loadu_ps(r + j);
+
+        const __m256 dx = _mm256_sub_ps(xj, xi);
+        const __m256 dy = _mm256_sub_ps(yj, yi);
+        const __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        const __m256 minDist = _mm256_add_ps(ri, rj);
+        const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(minDist, minDist), _CMP_LT_OQ),
+                                         _mm256_cmp_ps(distSq, minDistSq, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(hit) == 0) continue;
+
+        const __m256 dist = _mm256_sqrt_ps(_mm256_blendv_ps(one, distSq, hit));
+        const __m256 scale = _mm256_and_ps(hit, _mm256_div_ps(_mm256_mul_ps(half, _mm256_sub_ps(minDist, dist)), dist));
+        const __m256i offX = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_mul_ps(dx, scale), fixedScale));
+        const __m256i offY = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_mul_ps(dy, scale), fixedScale));
+
+        const __m256 newX = _mm256_add_ps(xj, _mm256_mul_ps(_mm256_cvtepi32_ps(offX), fixedStep));
+        const __m256 newY = _mm256_add_ps(yj, _mm256_mul_ps(_mm256_cvtepi32_ps(offY), fixedStep));
+        _mm256_storeu_ps(x + j, _mm256_blendv_ps(xj, newX, hit));
+        _mm256_storeu_ps(y + j, _mm256_blendv_ps(yj, newY, hit));
+        accX = _mm256_add_epi32(accX, offX);
+        accY = _mm256_add_epi32(accY, offY);
+    }
+
+    alignas(32) int32_t sumX[8];
+    alignas(32) int32_t sumY[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sumX), accX);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sumY), accY);
+    int32_t totalX = 0;
+    int32_t totalY = 0;
+    for (int k = 0; k < 8; ++k) {
+        totalX += sumX[k];
+        totalY += sumY[k];
+    }
+    x[i] -= static_cast<float>(totalX) * kFixedStep;
+    y[i] -= static_cast<float>(totalY) * kFixedStep;
+}
+
+} // namespace
+
+#endif // NARROW_PHASE_X86
+
+SimdLevel detectSimdLevel() {
+#ifdef NARROW_PHASE_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    if (avx2) return SimdLevel::AVX2;
+    if (sse41) return SimdLevel::SSE41;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE41;
+#endif
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSE41: return "SSE4.1";
+        default: return "Scalar";
+    }
+}
+
+SimdLevel resolveSimdLevel(SimdLevel level) {
+    const SimdLevel supported = detectSimdLevel();
+    if (level == SimdLevel::AVX2 && supported == SimdLevel::AVX2) return SimdLevel::AVX2;
+    if (level != SimdLevel::Scalar && supported != SimdLevel::Scalar) return SimdLevel::SSE41;
+    return SimdLevel::Scalar;
+}
+
+CollideFn selectCollideKernel(SimdLevel level, bool fixedPoint) {
+#ifdef NARROW_PHASE_X86
+    switch (resolveSimdLevel(level)) {
+        case SimdLevel::AVX2: return fixedPoint ? collideParticleFixedAVX2 : collideParticleAVX2;
+        case SimdLevel::SSE41: return fixedPoint ? collideParticleFixedSSE41 : collideParticleSSE41;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    return fixedPoint ? collideParticleFixedScalar : collideParticleScalar;
+}
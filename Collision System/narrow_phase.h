@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Narrow-phase kernels: resolve one particle against a run of candidate particles.
+//
+// Kernels work on a NeighborhoodBlock, a small contiguous SoA copy of one cell and its
+// neighbours, so candidates are read with plain vector loads instead of gathers.
+// Semantics are identical for every kernel: overlaps are measured from particle i's
+// position at entry, each overlapping candidate is pushed away immediately, and the
+// opposite displacements are summed and applied to particle i once at the end. The SIMD
+// variants test 4 (SSE4.1) or 8 (AVX2) candidates per iteration and mask out pairs that
+// do not overlap; only the summation order differs from the scalar kernel.
+//
+// The fixed-point kernels (SolverConfig::deterministic) round every pair's offset to a
+// multiple of kFixedStep and sum particle i's offsets as integers, so the summation order
+// no longer matters: all three levels give bit-identical results. Together with a build
+// that does not contract multiply-adds into FMA (-ffp-contract=off, see CMakeLists.txt)
+// this makes trajectories reproducible across machines, not just across thread counts.
+
+enum class SimdLevel {
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+// Resolve block entry i against block entries [begin, end).
+using CollideFn = void (*)(uint32_t i, uint32_t begin, uint32_t end,
+                           float* x, float* y, const float* r);
+
+// Best instruction set supported by the running CPU (and by this build).
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// The requested level if the CPU and build support it, else the best supported one below it.
+SimdLevel resolveSimdLevel(SimdLevel level);
+
+// Kernel for resolveSimdLevel(level), in float or fixed-point arithmetic.
+CollideFn selectCollideKernel(SimdLevel level, bool fixedPoint = false);
+
+// Resolution of the fixed-point offsets, in world units (2^-24)
+constexpr float kFixedStep = 1.0f / 16777216.0f;
+
+void collideParticleScalar(uint32_t i, uint32_t begin, uint32_t end,
+                           float* x, float* y, const float* r);
+void collideParticleFixedScalar(uint32_t i, uint32_t begin, uint32_t end,
+                                float* x, float* y, const float* r);
+
+// Local copy of the particles taking part in one cell's narrow phase.
+// Entries past count() are far-away sentinels so kernels can read whole vectors.
+// Buffers only grow, so a thread_local block stops allocating after warm-up.
+struct NeighborhoodBlock {
+    static constexpr uint32_t kPadding = 8;
+    static constexpr float kSentinel = 1e18f;
+
+    std::vector<uint32_t> index;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> r;
+    uint32_t size = 0;
+
+    uint32_t count() const { return size; }
+
+    // Start a new block that will hold up to `capacity` particles.
+    void reset(uint32_t capacity) {
+        if (x.size() < capacity + kPadding) {
+            index.resize(capacity);
+            x.resize(capacity + kPadding);
+            y.resize(capacity + kPadding);
+            r.resize(capacity + kPadding);
+        }
+        size = 0;
+    }
+
+    void append(const uint32_t* first, const uint32_t* last,
+                const float* px, const float* py, const float* pr) {
+        for (const uint32_t* it = first; it != last; ++it, ++size) {
+            index[size] = *it;
+            x[size] = px[*it];
+            y[size] = py[*it];
+            r[size] = pr[*it];
+        }
+    }
+
+    // Write the sentinel padding; call once after the last append.
+    void seal() {
+        for (uint32_t k = size; k < size + kPadding; ++k) {
+            x[k] = kSentinel;
+            y[k] = kSentinel;
+            r[k] = 0.0f;
+        }
+    }
+
+    void writeBack(float* px, float* py) const {
+        for (uint32_t k = 0; k < size; ++k) {
+            px[index[k]] = x[k];
+            py[index[k]] = y[k];
+        }
+    }
+};
@@ -0,0 +1,155 @@
+#include "particle_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr size_t kInitialCapacity = 4096;
+constexpr GLuint64 kFenceTimeoutNs = 1000000000ull;
+}
+
+InstancedParticleRenderer::InstancedParticleRenderer(int segments)
+    : shader("shaders/particle_instanced.vs", "shaders/particle_instanced.fs") {
+    // Unit circle as a triangle fan: center, then the rim closed back on itself
+    std::vector<glm::vec2> fan;
+    fan.reserve(segments + 2);
+    fan.push_back(glm::vec2(0.0f));
+    const float step = 6.28318530718f / static_cast<float>(segments);
+    for (int i = 0; i <= segments; ++i) {
+        fan.push_back(glm::vec2(std::cos(i * step), std::sin(i * step)));
+    }
+    circleVertexCount = static_cast<GLsizei>(fan.size());
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &circleVBO);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, circleVBO);
+    glBufferData(GL_ARRAY_BUFFER, fan.size() * sizeof(glm::vec2), fan.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    persistent = GLAD_GL_VERSION_4_4 != 0;
+    allocate(kInitialCapacity);
+}
+
+InstancedParticleRenderer::~InstancedParticleRenderer() {
+    releaseInstanceBuffer();
+    if (circleVBO) glDeleteBuffers(1, &circleVBO);
+    if (vao) glDeleteVertexArrays(1, &vao);
+}
+
+void InstancedParticleRenderer::allocate(size_t instances) {
+    releaseInstanceBuffer();
+    capacity = instances;
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(capacity * kRegions * sizeof(ParticleInstance));
+
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+        mapped = static_cast<ParticleInstance*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags));
+        if (!mapped) {
+            // Driver refused the persistent mapping: fall back to per-frame mapping
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &instanceVBO);
+            persistent = false;
+            glGenBuffers(1, &instanceVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        }
+    }
+    if (!persistent) {
+        glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindVertexArray(vao);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    region = 0;
+}
+
+void InstancedParticleRenderer::releaseInstanceBuffer() {
+    for (GLsync& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (instanceVBO) {
+        if (mapped) {
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &instanceVBO);
+        instanceVBO = 0;
+    }
+}
+
+void InstancedParticleRenderer::waitForRegion(int index) {
+    GLsync& fence = fences[index];
+    if (!fence) return;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void InstancedParticleRenderer::draw(const ParticleStore& particles, const glm::mat4& projection) {
+    if (particles.empty()) return;
+    if (particles.size() > capacity) {
+        allocate(std::max(particles.size(), capacity * 2));
+    }
+
+    region = (region + 1) % kRegions;
+    waitForRegion(region);
+
+    const size_t offsetBytes = region * capacity * sizeof(ParticleInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    size_t count = 0;
+    if (persistent) {
+        count = packParticleInstances(particles, mapped + region * capacity, capacity);
+    } else {
+        // The fence above already guarantees the GPU is done with this region
+        void* dst = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(offsetBytes),
+                                     static_cast<GLsizeiptr>(capacity * sizeof(ParticleInstance)),
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!dst) {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return;
+        }
+        count = packParticleInstances(particles, static_cast<ParticleInstance*>(dst), capacity);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+
+    // Point the instance attributes at this frame's region
+    glBindVertexArray(vao);
+    const GLsizei stride = static_cast<GLsizei>(sizeof(ParticleInstance));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void*)(offsetBytes + offsetof(ParticleInstance, x)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          (void*)(offsetBytes + offsetof(ParticleInstance, color)));
+
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setVec3("lightAmbient", glm::vec3(0.7f));
+    shader.setVec3("lightDiffuse", glm::vec3(0.3f));
+    shader.setVec3("lightSpecular", glm::vec3(0.1f));
+
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, circleVertexCount, static_cast<GLsizei>(count));
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include "../shader.h"
+#include "instance_packing.h"
+#include "particle_store.h"
+
+// Draws every particle as an instanced circle in a single call.
+//
+// Instance data (ParticleInstance) is packed straight into a buffer split into three
+// regions that are used round-robin, so the CPU writes frame N+1 while the GPU may
+// still read frames N and N-1. Each region is guarded by a fence and only waited on
+// when the ring wraps. On GL 4.4+ the buffer is allocated with glBufferStorage and
+// stays persistently mapped; older contexts map each region unsynchronized per frame.
+class InstancedParticleRenderer {
+public:
+    explicit InstancedParticleRenderer(int segments = 16);
+    ~InstancedParticleRenderer();
+
+    InstancedParticleRenderer(const InstancedParticleRenderer&) = delete;
+    InstancedParticleRenderer& operator=(const InstancedParticleRenderer&) = delete;
+
+    void draw(const ParticleStore& particles, const glm::mat4& projection);
+
+    bool isPersistentlyMapped() const { return persistent; }
+
+private:
+    static constexpr int kRegions = 3;
+
+    void allocate(size_t instances);
+    void releaseInstanceBuffer();
+    void waitForRegion(int index);
+
+    Shader shader;
+    GLuint vao = 0;
+    GLuint circleVBO = 0;
+    GLuint instanceVBO = 0;
+    GLsizei circleVertexCount = 0;
+
+    size_t capacity = 0;            // instances per region
+    int region = 0;
+    bool persistent = false;
+    ParticleInstance* mapped = nullptr;
+    GLsync fences[kRegions] = {};
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "particle.h"
+
+// Structure-of-arrays particle storage used internally by Nsolver.
+// Hot fields (position, previous position, radius) live in their own arrays so the
+// integration and narrow-phase loops only stream what they touch. Color and id are
+// cold data kept for rendering and image mapping. Acceleration is not stored: the
+// solver only applies gravity, which is folded into the integration step.
+// rest, restX and restY are the solver's sleep state: substeps spent near the anchor
+// position (restX, restY), plus a flag while asleep.
+struct ParticleStore {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> prevX;
+    std::vector<float> prevY;
+    std::vector<float> radius;
+    std::vector<glm::vec3> color;
+    std::vector<int> id;
+    std::vector<uint16_t> rest;
+    std::vector<float> restX;
+    std::vector<float> restY;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void reserve(size_t n) {
+        x.reserve(n);
+        y.reserve(n);
+        prevX.reserve(n);
+        prevY.reserve(n);
+        radius.reserve(n);
+        color.reserve(n);
+        id.reserve(n);
+        rest.reserve(n);
+        restX.reserve(n);
+        restY.reserve(n);
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        prevX.clear();
+        prevY.clear();
+        radius.clear();
+        color.clear();
+        id.clear();
+        rest.clear();
+        restX.clear();
+        restY.clear();
+    }
+
+    void push(const Particle& p) {
+        x.push_back(p.position.x);
+        y.push_back(p.position.y);
+        prevX.push_back(p.previous_position.x);
+        prevY.push_back(p.previous_position.y);
+        radius.push_back(p.radius);
+        color.push_back(p.color);
+        id.push_back(p.id);
+        rest.push_back(0);
+        restX.push_back(p.position.x);
+        restY.push_back(p.position.y);
+    }
+
+    // Permute storage so slot k holds the particle previously at order[k]. The gather
+    // goes through scratch, whose buffers are swapped in and kept for reuse.
+    void reorder(const std::vector<uint32_t>& order, ParticleStore& scratch) {
+        gather(x, scratch.x, order);
+        gather(y, scratch.y, order);
+        gather(prevX, scratch.prevX, order);
+        gather(prevY, scratch.prevY, order);
+        gather(radius, scratch.radius, order);
+        gather(color, scratch.color, order);
+        gather(id, scratch.id, order);
+        gather(rest, scratch.rest, order);
+        gather(restX, scratch.restX, order);
+        gather(restY, scratch.restY, order);
+    }
+
+    // Materialize an AoS copy of particle i (grid coordinates are left at zero).
+    Particle get(size_t i) const {
+        Particle p;
+        p.position = glm::vec2(x[i], y[i]);
+        p.previous_position = glm::vec2(prevX[i], prevY[i]);
+        p.radius = radius[i];
+        p.color = color[i];
+        p.id = id[i];
+        return p;
+    }
+
+private:
+    template <typename T>
+    static void gather(std::vector<T>& field, std::vector<T>& scratch, const std::vector<uint32_t>& order) {
+        scratch.resize(order.size());
+        for (size_t k = 0; k < order.size(); ++k) {
+            scratch[k] = field[order[k]];
+        }
+        field.swap(scratch);
+    }
+};
+
+// Lightweight per-particle view handed out by ParticleView. Position and radius are
+// snapshots; color is a reference into the store so callers can recolor in place.
+struct ParticleRef {
+    glm::vec2 position;
+    float radius;
+    int id;
+    glm::vec3& color;
+};
+
+// Read-mostly adapter over ParticleStore for code that used to walk std::vector<Particle>
+// (window2d.cpp rendering, MapPixel). Iterate with `for (const auto& p : view)`.
+class ParticleView {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ParticleRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = ParticleRef;
+
+        iterator(ParticleStore* store, size_t index) : store(store), index(index) {}
+
+        ParticleRef operator*() const {
+            return ParticleRef{ glm::vec2(store->x[index], store->y[index]),
+                                store->radius[index], store->id[index], store->color[index] };
+        }
+        iterator& operator++() { ++index; return *this; }
+        iterator operator++(int) { iterator tmp = *this; ++index; return tmp; }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        ParticleStore* store;
+        size_t index;
+    };
+
+    explicit ParticleView(ParticleStore& store) : store(&store) {}
+
+    size_t size() const { return store->size(); }
+    bool empty() const { return store->empty(); }
+
+    ParticleRef operator[](size_t i) const { return *iterator(store, i); }
+
+    iterator begin() const { return iterator(store, 0); }
+    iterator end() const { return iterator(store, store->size()); }
+
+private:
+    ParticleStore* store;
+};
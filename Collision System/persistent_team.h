@@ -0,0 +1,174 @@
+#ifndef PERSISTENT_TEAM_H
+#define PERSISTENT_TEAM_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define TEAM_FUTEX_LINUX 1
+#elif defined(_WIN32)
+#include <windows.h>
+#pragma comment(lib, "Synchronization.lib")
+#define TEAM_FUTEX_WINDOWS 1
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define TEAM_CPU_RELAX() _mm_pause()
+#else
+#define TEAM_CPU_RELAX() std::this_thread::yield()
+#endif
+
+// Reusable barrier for a fixed number of threads. Arrivals spin on the generation word
+// for a short while, then yield, then sleep on it (futex on Linux, WaitOnAddress on
+// Windows, a condition variable elsewhere). The last arrival bumps the generation and
+// only pays for a wake-up syscall when somebody actually went to sleep. When there are
+// more participants than cores, spinning only delays the thread being waited for, so
+// arrivals go straight to yielding.
+class SpinFutexBarrier {
+public:
+    explicit SpinFutexBarrier(uint32_t participants)
+        : participants(participants),
+          spinIterations(participants <= std::thread::hardware_concurrency() ? kSpinIterations : 0) {
+        if (participants == 0) {
+            throw std::invalid_argument("Barrier needs at least one participant");
+        }
+    }
+
+    void arriveAndWait() {
+        const uint32_t gen = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == participants) {
+            arrived.store(0, std::memory_order_relaxed);
+            generation.store(gen + 1, std::memory_order_seq_cst);
+            if (sleepers.load(std::memory_order_seq_cst) > 0) wakeAll();
+            return;
+        }
+
+        for (int spin = 0; spin < spinIterations; ++spin) {
+            if (generation.load(std::memory_order_acquire) != gen) return;
+            TEAM_CPU_RELAX();
+        }
+        for (int spin = 0; spin < kYieldIterations; ++spin) {
+            if (generation.load(std::memory_order_acquire) != gen) return;
+            std::this_thread::yield();
+        }
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        while (generation.load(std::memory_order_seq_cst) == gen) {
+            sleepWhile(gen);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    uint32_t size() const { return participants; }
+
+private:
+    static constexpr int kSpinIterations = 2000;
+    static constexpr int kYieldIterations = 8;
+
+    void sleepWhile(uint32_t gen) {
+#if defined(TEAM_FUTEX_LINUX)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&generation), FUTEX_WAIT_PRIVATE, gen,
+                nullptr, nullptr, 0);
+#elif defined(TEAM_FUTEX_WINDOWS)
+        WaitOnAddress(&generation, &gen, sizeof(gen), INFINITE);
+#else
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this, gen] { return generation.load() != gen; });
+#endif
+    }
+
+    void wakeAll() {
+#if defined(TEAM_FUTEX_LINUX)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&generation), FUTEX_WAKE_PRIVATE, INT32_MAX,
+                nullptr, nullptr, 0);
+#elif defined(TEAM_FUTEX_WINDOWS)
+        WakeByAddressAll(&generation);
+#else
+        { std::lock_guard<std::mutex> lock(mutex); }
+        cv.notify_all();
+#endif
+    }
+
+    const uint32_t participants;
+    const int spinIterations;
+    alignas(64) std::atomic<uint32_t> arrived{0};
+    alignas(64) std::atomic<uint32_t> generation{0};
+    std::atomic<uint32_t> sleepers{0};
+#if !defined(TEAM_FUTEX_LINUX) && !defined(TEAM_FUTEX_WINDOWS)
+    std::mutex mutex;
+    std::condition_variable cv;
+#endif
+};
+
+// Fixed team of threads that run one body in lockstep. run(body) executes body(worker)
+// on every member (the caller is worker 0) and returns when all of them are done;
+// inside the body, sync() is a full barrier across the team. Between runs the workers
+// stay parked on the barrier, so a run costs two barrier crossings and no allocation.
+class PersistentTeam {
+public:
+    explicit PersistentTeam(int n = static_cast<int>(std::thread::hardware_concurrency()))
+        : numThreads(n > 0 ? n : 1), barrier(static_cast<uint32_t>(n > 0 ? n : 1)) {
+        threads.reserve(numThreads - 1);
+        for (int i = 1; i < numThreads; ++i) {
+            threads.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    ~PersistentTeam() {
+        stopping = true;
+        barrier.arriveAndWait();
+        for (auto& thread : threads) {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    PersistentTeam(const PersistentTeam&) = delete;
+    PersistentTeam& operator=(const PersistentTeam&) = delete;
+
+    // body(int worker) must call sync() the same number of times on every worker.
+    template <typename Body>
+    void run(const Body& body) {
+        invoke = &invokeBody<Body>;
+        context = &body;
+        barrier.arriveAndWait(); // release the parked workers
+        body(0);
+        barrier.arriveAndWait(); // wait for the team to finish
+    }
+
+    void sync() { barrier.arriveAndWait(); }
+
+    int size() const { return numThreads; }
+
+private:
+    template <typename Body>
+    static void invokeBody(const void* body, int worker) {
+        (*static_cast<const Body*>(body))(worker);
+    }
+
+    void workerLoop(int worker) {
+        while (true) {
+            barrier.arriveAndWait();
+            if (stopping) break;
+            invoke(context, worker);
+            barrier.arriveAndWait();
+        }
+    }
+
+    int numThreads;
+    SpinFutexBarrier barrier;
+    std::vector<std::thread> threads;
+    // Written by the caller before the release barrier, read by workers after it
+    void (*invoke)(const void*, int) = nullptr;
+    const void* context = nullptr;
+    bool stopping = false;
+};
+
+#endif // PERSISTENT_TEAM_H
@@ -0,0 +1,185 @@
+#include "Nsolver.h"
+#include "snapshot.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+template <typename T>
+void writeArray(std::ofstream& out, const std::vector<T>& values) {
+    if (!values.empty()) {
+        out.write(reinterpret_cast<const char*>(values.data()),
+                  static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+}
+
+template <typename T>
+bool readArray(std::ifstream& in, std::vector<T>& values, size_t count) {
+    values.resize(count);
+    if (count == 0) return true;
+    in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(in);
+}
+
+} // namespace
+
+bool Nsolver::saveSnapshot(const std::string& path, const SnapshotExtras& extras) const {
+    std::ostringstream rng;
+    rng << randomEngine();
+    const std::string rngState = rng.str();
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.byteOrder = kSnapshotByteOrder;
+    header.worldLeft = config.worldLeft;
+    header.worldRight = config.worldRight;
+    header.worldBottom = config.worldBottom;
+    header.worldTop = config.worldTop;
+    header.cellSize = config.cellSize;
+    header.expectedMaxRadius = config.expectedMaxRadius;
+    header.broadPhase = static_cast<int32_t>(config.broadPhase);
+    header.tileSize = config.tileSize;
+    header.substeps = config.substeps;
+    header.maxParticles = config.maxParticles;
+    header.sleepSpeed = config.sleepSpeed;
+    header.wakeSpeed = config.wakeSpeed;
+    header.sleepSteps = config.sleepSteps;
+    header.deterministic = config.deterministic ? 1 : 0;
+    header.reorderInterval = reorderInterval;
+    header.framesSinceReorder = framesSinceReorder;
+    header.maxRadius = maxRadius;
+    header.step = extras.step;
+    header.spawnTimer = extras.spawnTimer;
+    header.particleCount = particles.size();
+    header.rngStateBytes = static_cast<uint32_t>(rngState.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write snapshot: " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(out, particles.x);
+    writeArray(out, particles.y);
+    writeArray(out, particles.prevX);
+    writeArray(out, particles.prevY);
+    writeArray(out, particles.radius);
+    writeArray(out, particles.color);
+    writeArray(out, particles.id);
+    writeArray(out, particles.rest);
+    writeArray(out, particles.restX);
+    writeArray(out, particles.restY);
+    out.write(rngState.data(), static_cast<std::streamsize>(rngState.size()));
+    out.close();
+
+    if (!out) {
+        std::cerr << "Failed writing snapshot: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Nsolver::loadSnapshot(const std::string& path, SnapshotExtras* extras) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Snapshot not found: " << path << std::endl;
+        return false;
+    }
+
+    SnapshotHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0) {
+        std::cerr << "Not an Nsolver snapshot: " << path << std::endl;
+        return false;
+    }
+    if (header.version != kSnapshotVersion || header.byteOrder != kSnapshotByteOrder) {
+        std::cerr << "Unsupported snapshot version or byte order: " << path << std::endl;
+        return false;
+    }
+
+    if (header.broadPhase < static_cast<int32_t>(BroadPhase::DenseGrid) ||
+        header.broadPhase > static_cast<int32_t>(BroadPhase::MultiLevel)) {
+        std::cerr << "Unknown broad phase " << header.broadPhase << " in snapshot: " << path << std::endl;
+        return false;
+    }
+    if (header.particleCount > header.maxParticles) {
+        std::cerr << "Snapshot holds " << header.particleCount << " particles, more than its maximum of "
+                  << header.maxParticles << ": " << path << std::endl;
+        return false;
+    }
+
+    // Check the counts against what is left of the file before allocating anything
+    const std::streamoff bodyStart = in.tellg();
+    in.seekg(0, std::ios::end);
+    const uint64_t bodyBytes = static_cast<uint64_t>(in.tellg() - bodyStart);
+    in.seekg(bodyStart);
+    // x, y, prevX, prevY, radius, restX, restY, then color, id and rest
+    const uint64_t particleBytes = 7 * sizeof(float) + sizeof(glm::vec3) + sizeof(int) + sizeof(uint16_t);
+    if (!in || header.particleCount > bodyBytes / particleBytes ||
+        header.particleCount * particleBytes + header.rngStateBytes > bodyBytes) {
+        std::cerr << "Truncated snapshot: " << path << std::endl;
+        return false;
+    }
+
+    // Read into a fresh store so a failed read leaves the solver untouched
+    ParticleStore loaded;
+    const size_t count = static_cast<size_t>(header.particleCount);
+    std::string rngState(header.rngStateBytes, '\0');
+    bool ok = readArray(in, loaded.x, count) && readArray(in, loaded.y, count) &&
+              readArray(in, loaded.prevX, count) && readArray(in, loaded.prevY, count) &&
+              readArray(in, loaded.radius, count) && readArray(in, loaded.color, count) &&
+              readArray(in, loaded.id, count) && readArray(in, loaded.rest, count) &&
+              readArray(in, loaded.restX, count) && readArray(in, loaded.restY, count);
+    if (ok && !rngState.empty()) {
+        in.read(&rngState[0], static_cast<std::streamsize>(rngState.size()));
+        ok = static_cast<bool>(in);
+    }
+    if (!ok) {
+        std::cerr << "Truncated snapshot: " << path << std::endl;
+        return false;
+    }
+
+    std::istringstream rng(rngState);
+    std::mt19937 engine;
+    if (!(rng >> engine)) {
+        std::cerr << "Corrupt RNG state in snapshot: " << path << std::endl;
+        return false;
+    }
+    randomEngine() = engine;
+
+    config.worldLeft = header.worldLeft;
+    config.worldRight = header.worldRight;
+    config.worldBottom = header.worldBottom;
+    config.worldTop = header.worldTop;
+    config.cellSize = header.cellSize;
+    config.expectedMaxRadius = header.expectedMaxRadius;
+    config.broadPhase = static_cast<BroadPhase>(header.broadPhase);
+    config.tileSize = std::max(2, static_cast<int>(header.tileSize));
+    config.substeps = std::max(1, static_cast<int>(header.substeps));
+    config.maxParticles = static_cast<size_t>(header.maxParticles);
+    config.sleepSpeed = header.sleepSpeed;
+    config.wakeSpeed = header.wakeSpeed;
+    config.sleepSteps = std::max(1, std::min(static_cast<int>(header.sleepSteps), static_cast<int>(kRestMask)));
+    config.deterministic = header.deterministic != 0;
+    reorderInterval = header.reorderInterval;
+    framesSinceReorder = header.framesSinceReorder;
+    maxRadius = header.maxRadius;
+
+    particles = std::move(loaded);
+    minRadius = particles.empty() ? 0.0f : *std::min_element(particles.radius.begin(), particles.radius.end());
+    configureGrid(tunedCellSize());
+    setSimdLevel(simdLevel);
+    countAwake();
+
+    if (extras) {
+        extras->step = header.step;
+        extras->spawnTimer = header.spawnTimer;
+    }
+    return true;
+}
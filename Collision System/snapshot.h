@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary Nsolver snapshot (see Nsolver::saveSnapshot / loadSnapshot).
+//
+// Layout, native little-endian, no padding between fields:
+//   header    SnapshotHeader below
+//   particles x, y, prevX, prevY, radius : particleCount floats each
+//             color                      : particleCount * 3 floats (r, g, b)
+//             id                         : particleCount int32
+//             rest                       : particleCount uint16 (sleep state)
+//             restX, restY               : particleCount floats each (sleep anchor)
+//   rng       rngStateBytes bytes of the randomFloat() engine in std::mt19937 text form
+//
+// Every array is written and read in one call straight from/to the ParticleStore
+// vectors, so saving or loading a full scene costs about one memcpy of its size.
+// Particles are stored in their current memory order, which together with the frame
+// counters makes a resumed run bit-identical to one that never stopped.
+
+constexpr char kSnapshotMagic[8] = { 'N', 'S', 'O', 'L', 'V', 'S', 'N', 'P' };
+constexpr uint32_t kSnapshotVersion = 3;   // 2: sleep state, 3: deterministic flag
+constexpr uint32_t kSnapshotByteOrder = 0x01020304u;
+
+// Caller state saved alongside the solver, so a driver can resume its own clock and
+// spawner exactly.
+struct SnapshotExtras {
+    uint64_t step = 0;          // fixed steps simulated so far
+    float spawnTimer = 0.0f;    // StreamSpawner::timer
+};
+
+#pragma pack(push, 1)
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+
+    // SolverConfig (threads are not saved: they do not change results)
+    float worldLeft, worldRight, worldBottom, worldTop;
+    float cellSize;
+    float expectedMaxRadius;
+    int32_t broadPhase;
+    int32_t tileSize;
+    int32_t substeps;
+    uint64_t maxParticles;
+    float sleepSpeed;
+    float wakeSpeed;
+    int32_t sleepSteps;
+    int32_t deterministic;
+
+    // Solver frame state
+    int32_t reorderInterval;
+    int32_t framesSinceReorder;
+    float maxRadius;
+
+    // Caller state
+    uint64_t step;
+    float spawnTimer;
+
+    uint64_t particleCount;
+    uint32_t rngStateBytes;
+};
+#pragma pack(pop)
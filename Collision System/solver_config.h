@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "constants.h"
+
+// Broad-phase structure. DenseGrid allocates every cell of the world up front;
+// SparseHash stores only occupied cells (see SparseCollisionGrid) and suits large or
+// mostly empty worlds. Both give identical results.
+// MultiLevel keeps sparse grids of doubling cell sizes and files each particle by its
+// radius (see MultiLevelGrid), for radii spanning several times. It finds the same
+// contacts but resolves them in a different order, so its results differ slightly.
+enum class BroadPhase {
+    DenseGrid,
+    SparseHash,
+    MultiLevel
+};
+
+// Runtime world, grid and threading parameters for Nsolver. Defaults are the values in
+// constants.h. That includes SLEEP_SPEED, so a default solver puts resting particles to
+// sleep; set sleepSpeed = 0 to keep every particle awake, as before sleeping was added.
+struct SolverConfig {
+    // World extents (simulation units)
+    float worldLeft = WORLD_LEFT;
+    float worldRight = WORLD_RIGHT;
+    float worldBottom = WORLD_BOTTOM;
+    float worldTop = WORLD_TOP;
+
+    // Grid cell edge. <= 0 auto-tunes from the largest particle radius (see tuneCellSize).
+    // An explicit size smaller than the largest particle diameter is raised to it,
+    // because the 3x3 neighbourhood search would otherwise miss contacts.
+    // For MultiLevel this bounds the finest level's edge (see tuneBaseCellSize).
+    float cellSize = 0.0f;
+
+    // Radius assumed by the auto-tuner before any particle has been added
+    float expectedMaxRadius = MAX_PARTICLE_RADIUS;
+
+    BroadPhase broadPhase = BroadPhase::DenseGrid;
+
+    int tileSize = 8;                   // narrow-phase tile edge in cells (see TileSchedule), >= 2
+    int substeps = 8;
+    int threads = 0;                    // <= 0 uses every hardware thread
+    size_t maxParticles = MAX_PARTICLES;
+
+    // Sleeping: a particle that stays for sleepSteps substeps within the distance it would
+    // cover at sleepSpeed (world units per second) in that time is resting. A cell whose
+    // particles all rest falls asleep: they skip integration, and the narrow phase skips
+    // the cell once its neighbours rest as well. A contact push faster than wakeSpeed
+    // wakes a particle. Keep the window longer than 16 * sleepSpeed / GRAVITY seconds, or
+    // thrown particles can fall asleep at the top of their arc. sleepSpeed <= 0 disables
+    // sleeping.
+    float sleepSpeed = SLEEP_SPEED;
+    float wakeSpeed = WAKE_SPEED;
+    int sleepSteps = SLEEP_STEPS;       // 1 .. 32767
+
+    // Fixed-point narrow phase (see narrow_phase.h): trajectories are bit-identical for
+    // every SIMD level, so also across machines, at a small cost in speed. Results are
+    // identical for any thread count either way.
+    bool deterministic = false;
+
+    float width() const { return worldRight - worldLeft; }
+    float height() const { return worldTop - worldBottom; }
+};
+
+// Cap on dense grid cells; keeps tiny radii or cell sizes in a huge world from
+// allocating an enormous, mostly empty grid. The sparse broad phase is not capped.
+// Every grid rebuild still clears and scans each cell once per histogram chunk
+// (CollisionGrid::chunksFor keeps that to one chunk when particles are few), so a
+// world that hits the cap is better served by BroadPhase::SparseHash.
+constexpr size_t kMaxGridCells = size_t(1) << 22;
+
+// Cell size for a set of radii. Any pair of particles that can touch is at most
+// 2 * maxRadius apart, so that is the smallest cell the 3x3 search supports and the one
+// that keeps candidate lists shortest. Larger cells only grow the candidate lists;
+// smaller ones miss contacts.
+inline float tuneCellSize(const SolverConfig& config, float maxRadius) {
+    const float radius = maxRadius > 0.0f ? maxRadius : config.expectedMaxRadius;
+    float cell = config.cellSize > 0.0f ? std::max(config.cellSize, 2.0f * radius) : 2.0f * radius;
+
+    if (config.broadPhase == BroadPhase::SparseHash) return cell;
+    const float minCell = std::sqrt(config.width() * config.height() / static_cast<float>(kMaxGridCells));
+    return std::max(cell, minCell);
+}
+
+// Smallest MultiLevel cell: the smallest particle diameter, or the explicit size. The
+// top level always fits the largest diameter, so no explicit size can miss contacts.
+inline float tuneBaseCellSize(const SolverConfig& config, float minRadius) {
+    if (config.cellSize > 0.0f) return config.cellSize;
+    return 2.0f * (minRadius > 0.0f ? minRadius : config.expectedMaxRadius);
+}
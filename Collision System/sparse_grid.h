@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include "grid.h"
+
+// Broad phase for large or mostly empty worlds. Only occupied cells are stored:
+//   1. the caller fills particleKey with keyFor(x, y) (threadable, one chunk per thread)
+//   2. build() radix-sorts particle indices by their (row, column) key and records one
+//      entry per occupied cell, in key order
+// Memory and per-substep cost scale with particles and occupied cells, never with world
+// area, and cell coordinates are not clamped, so the world need not be bounded.
+// Neighbours are found by walking the sorted cell array (see firstCellInRow) rather than
+// by hashing: the narrow phase visits cells in order, so cursors into the rows above and
+// below only ever move forward. Where each row starts is looked up in a table over the
+// occupied row span, or binary-searched when that span is far larger than the cell count
+// (a few particles very far apart).
+//
+// Occupied cells come out in row-major order and particles within a cell stay in index
+// order, the same order CollisionGrid produces, so both broad phases feed the narrow
+// phase identical candidate lists.
+struct SparseCollisionGrid {
+    static constexpr uint64_t kNoKey = ~0ull;
+    static constexpr int kRadixBits = 11;
+
+    float cell_size;
+    float originX, originY;
+
+    std::vector<uint64_t> particleKey;  // packed (row, column) of each particle, filled by the caller
+    std::vector<uint32_t> objects;      // particle indices grouped by cell
+    std::vector<int32_t> cellRow;       // occupied cells, row-major
+    std::vector<int32_t> cellCol;
+    std::vector<uint32_t> cellStart;    // occupied + 1 offsets into objects
+    std::vector<uint32_t> rowFirstCell; // first cell of each row from firstRow on (may be empty)
+    int32_t firstRow = 0;
+
+    SparseCollisionGrid(float cs, float ox = 0.0f, float oy = 0.0f)
+        : cell_size(cs), originX(ox), originY(oy) {
+        cellStart.assign(1, 0);
+    }
+
+    size_t occupiedCount() const { return cellRow.size(); }
+
+    void clear() {
+        objects.clear();
+        particleKey.clear();
+        cellRow.clear();
+        cellCol.clear();
+        cellStart.assign(1, 0);
+        rowFirstCell.clear();
+    }
+
+    // Biasing by 2^31 makes unsigned order match signed (row, column) order.
+    static uint64_t packKey(int32_t row, int32_t col) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(row) ^ 0x80000000u) << 32) |
+               (static_cast<uint32_t>(col) ^ 0x80000000u);
+    }
+    static int32_t keyRow(uint64_t key) { return static_cast<int32_t>(static_cast<uint32_t>(key >> 32) ^ 0x80000000u); }
+    static int32_t keyCol(uint64_t key) { return static_cast<int32_t>(static_cast<uint32_t>(key) ^ 0x80000000u); }
+
+    uint64_t keyFor(float x, float y) const {
+        const int32_t col = static_cast<int32_t>(std::floor((x - originX) / cell_size));
+        const int32_t row = static_cast<int32_t>(std::floor((y - originY) / cell_size));
+        return packKey(row, col);
+    }
+
+    // Size the per-particle buffers. Must run before the caller fills particleKey.
+    void resize(size_t particleCount) {
+        particleKey.resize(particleCount);
+        objects.resize(particleCount);
+    }
+
+    // Sort particleKey[0, particleCount) into cells. When the keys belong to a subset of
+    // the particles, particleOf[k] names the particle of key k and objects holds those
+    // particle indices instead (adoptSortedOrder then no longer applies).
+    void build(size_t particleCount, const uint32_t* particleOf = nullptr) {
+        sortByCell(particleCount);
+
+        cellRow.clear();
+        cellCol.clear();
+        cellStart.clear();
+        uint64_t previous = kNoKey;
+        for (uint32_t k = 0; k < particleCount; ++k) {
+            const uint64_t key = particleKey[objects[k]];
+            if (key != previous) {
+                cellRow.push_back(keyRow(key));
+                cellCol.push_back(keyCol(key));
+                cellStart.push_back(k);
+                previous = key;
+            }
+        }
+        cellStart.push_back(static_cast<uint32_t>(particleCount));
+        buildRowIndex();
+        if (particleOf) {
+            for (uint32_t k = 0; k < particleCount; ++k) objects[k] = particleOf[objects[k]];
+        }
+    }
+
+    // After the particle storage has been permuted into objects order, every cell
+    // holds a contiguous index range and objects becomes the identity.
+    void adoptSortedOrder() {
+        for (uint32_t k = 0; k < objects.size(); ++k) {
+            sortScratchKey[k] = particleKey[objects[k]];
+        }
+        std::copy(sortScratchKey.begin(), sortScratchKey.begin() + objects.size(), particleKey.begin());
+        std::iota(objects.begin(), objects.end(), 0u);
+    }
+
+    CellSpan cell(uint32_t index) const {
+        const uint32_t* base = objects.data();
+        return CellSpan{ base + cellStart[index], base + cellStart[index + 1] };
+    }
+
+    // First occupied cell whose row is >= row.
+    uint32_t firstCellInRow(int32_t row) const {
+        if (rowFirstCell.empty()) {
+            return static_cast<uint32_t>(std::lower_bound(cellRow.begin(), cellRow.end(), row) - cellRow.begin());
+        }
+        if (row <= firstRow) return 0;
+        const int64_t offset = static_cast<int64_t>(row) - firstRow;
+        if (offset >= static_cast<int64_t>(rowFirstCell.size())) return static_cast<uint32_t>(cellRow.size());
+        return rowFirstCell[static_cast<size_t>(offset)];
+    }
+
+    // First cell in [first, last) (part of a single row) whose column is >= col.
+    uint32_t firstCellInColumns(uint32_t first, uint32_t last, int32_t col) const {
+        return static_cast<uint32_t>(std::lower_bound(cellCol.begin() + first, cellCol.begin() + last, col) - cellCol.begin());
+    }
+
+private:
+    // rowFirstCell over rows [first occupied, last occupied + 1], unless that span is
+    // much larger than the number of occupied cells
+    void buildRowIndex() {
+        rowFirstCell.clear();
+        if (cellRow.empty()) return;
+        firstRow = cellRow.front();
+        const int64_t span = static_cast<int64_t>(cellRow.back()) - firstRow + 2;
+        if (span > 4 * static_cast<int64_t>(cellRow.size()) + 1024) return;
+        rowFirstCell.resize(static_cast<size_t>(span));
+        uint32_t cell = 0;
+        for (int64_t r = 0; r < span; ++r) {
+            while (cell < cellRow.size() && cellRow[cell] < firstRow + r) ++cell;
+            rowFirstCell[static_cast<size_t>(r)] = cell;
+        }
+    }
+
+    std::vector<uint64_t> sortKey;      // radix sort buffers (compacted keys)
+    std::vector<uint64_t> sortScratchKey;
+    std::vector<uint32_t> sortScratchIndex;
+    std::vector<uint32_t> histogram;
+
+    // Stable LSD radix sort of particle indices by cell. Keys are first compacted to
+    // (row - minRow) * columns + (col - minCol), so a typical world needs two passes.
+    void sortByCell(size_t count) {
+        sortKey.resize(count);
+        sortScratchKey.resize(count);
+        sortScratchIndex.resize(count);
+        std::iota(objects.begin(), objects.begin() + count, 0u);
+        if (count == 0) return;
+
+        int32_t minRow = keyRow(particleKey[0]), maxRow = minRow;
+        int32_t minCol = keyCol(particleKey[0]), maxCol = minCol;
+        for (size_t i = 1; i < count; ++i) {
+            const int32_t row = keyRow(particleKey[i]);
+            const int32_t col = keyCol(particleKey[i]);
+            minRow = std::min(minRow, row);
+            maxRow = std::max(maxRow, row);
+            minCol = std::min(minCol, col);
+            maxCol = std::max(maxCol, col);
+        }
+        const uint64_t columns = static_cast<uint64_t>(static_cast<int64_t>(maxCol) - minCol) + 1;
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t row = static_cast<uint64_t>(static_cast<int64_t>(keyRow(particleKey[i])) - minRow);
+            const uint64_t col = static_cast<uint64_t>(static_cast<int64_t>(keyCol(particleKey[i])) - minCol);
+            sortKey[i] = row * columns + col;
+        }
+        const uint64_t maxKey = static_cast<uint64_t>(static_cast<int64_t>(maxRow) - minRow) * columns + (columns - 1);
+
+        const uint32_t buckets = 1u << kRadixBits;
+        histogram.resize(buckets);
+        uint64_t* keys = sortKey.data();
+        uint64_t* keysOut = sortScratchKey.data();
+        uint32_t* index = objects.data();
+        uint32_t* indexOut = sortScratchIndex.data();
+        for (int shift = 0; shift < 64 && (maxKey >> shift) != 0; shift += kRadixBits) {
+            std::fill(histogram.begin(), histogram.end(), 0u);
+            for (size_t i = 0; i < count; ++i) histogram[(keys[i] >> shift) & (buckets - 1)]++;
+            uint32_t running = 0;
+            for (uint32_t& h : histogram) {
+                const uint32_t c = h;
+                h = running;
+                running += c;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                const uint32_t slot = histogram[(keys[i] >> shift) & (buckets - 1)]++;
+                keysOut[slot] = keys[i];
+                indexOut[slot] = index[i];
+            }
+            std::swap(keys, keysOut);
+            std::swap(index, indexOut);
+        }
+        if (index != objects.data()) {
+            std::copy(index, index + count, objects.begin());
+        }
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "constants.h"
+
+// Fixed-step stream emitter: every AUTO_SPAWN_INTERVAL of simulated time it emits one
+// burst of up to STREAM_COUNT particles in a vertical column near the top-left corner
+// of the world (WORLD_* by default).
+// Driven only by the fixed timestep, so the spawn sequence is identical for the
+// windowed app and headless runs.
+struct StreamSpawner {
+    float timer = 0.0f;
+    float left = WORLD_LEFT;
+    float bottom = WORLD_BOTTOM;
+    float top = WORLD_TOP;
+
+    StreamSpawner() = default;
+    StreamSpawner(float worldLeft, float worldBottom, float worldTop)
+        : left(worldLeft), bottom(worldBottom), top(worldTop) {}
+
+    void reset() { timer = 0.0f; }
+
+    // Advance by one fixed step. emit(position) is called for each particle due and
+    // returns false to cut the current burst short (e.g. a particle budget is reached).
+    template <typename Emit>
+    void step(float dt, Emit&& emit) {
+        timer += dt;
+        while (timer >= AUTO_SPAWN_INTERVAL) {
+            const float baseY = top - TOP_MARGIN;
+            const float x = left + SPAWN_MARGIN_X;
+            for (int i = 0; i < STREAM_COUNT; ++i) {
+                const float y = baseY - i * STREAM_SPACING;
+                if (y - 0.2f < bottom) break;
+                if (!emit(glm::vec2(x, y))) break;
+            }
+            timer -= AUTO_SPAWN_INTERVAL;
+        }
+    }
+};
@@ -0,0 +1,148 @@
+// MapPixel: id-indexed color table, the three sampling filters, and the cost of
+// re-mapping a large scene. Uses synthetic images, so no image files are needed.
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "mapPixel.h"
+#include "particle_store.h"
+
+namespace {
+
+bool near(float a, float b, float eps = 1e-4f) { return std::fabs(a - b) <= eps; }
+
+// w x h RGB image whose red channel is the column, green the row, blue constant
+std::vector<unsigned char> makeGradient(int w, int h) {
+    std::vector<unsigned char> rgb(static_cast<size_t>(w) * h * 3);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            unsigned char* t = rgb.data() + (static_cast<size_t>(y) * w + x) * 3;
+            t[0] = static_cast<unsigned char>(x);
+            t[1] = static_cast<unsigned char>(y);
+            t[2] = 200;
+        }
+    }
+    return rgb;
+}
+
+ParticleStore makeGrid(int side, float worldSize) {
+    ParticleStore store;
+    store.reserve(static_cast<size_t>(side) * side);
+    for (int i = 0; i < side * side; ++i) {
+        Particle p;
+        p.position = glm::vec2(((i % side) + 0.5f) * worldSize / side, ((i / side) + 0.5f) * worldSize / side);
+        p.previous_position = p.position;
+        p.radius = 0.5f * worldSize / side;
+        // Scramble storage order against ids, like the solver's cell reordering does
+        p.id = (i * 7919) % (side * side);
+        store.push(p);
+    }
+    return store;
+}
+
+} // namespace
+
+// Each filter reproduces the gradient where it should.
+void testFilters() {
+    std::cout << "\n=== Test: Sampling Filters ===\n";
+
+    const std::vector<unsigned char> rgb = makeGradient(16, 8);
+    MapPixel map;
+    map.setImage(16, 8, rgb.data());
+
+    map.filter = PixelFilter::Nearest;
+    PixelData c = map.sample(3.7f, 5.2f, 0.0f);
+    assert(near(c[0], 3 / 255.0f) && near(c[1], 5 / 255.0f) && near(c[2], 200 / 255.0f));
+
+    // Halfway between texel centers 3.5 and 4.5 -> 3.5; linear data interpolates exactly
+    map.filter = PixelFilter::Bilinear;
+    c = map.sample(4.0f, 2.5f, 0.0f);
+    assert(near(c[0], 3.5f / 255.0f) && near(c[1], 2.0f / 255.0f));
+    c = map.sample(-10.0f, 100.0f, 0.0f);   // clamps to the corner texel
+    assert(near(c[0], 0.0f) && near(c[1], 7 / 255.0f));
+
+    // Box over columns 2..5 and rows 1..4 -> mean column 3.5, mean row 2.5
+    map.filter = PixelFilter::Box;
+    c = map.sample(4.0f, 3.0f, 1.9f);
+    assert(near(c[0], 3.5f / 255.0f) && near(c[1], 2.5f / 255.0f) && near(c[2], 200 / 255.0f));
+    c = map.sample(0.2f, 0.2f, 0.0f);       // zero radius = the texel itself
+    assert(near(c[0], 0.0f) && near(c[1], 0.0f));
+
+    std::cout << "PASSED: Sampling filters\n";
+}
+
+// Colors land at their particle's id regardless of storage order, pooled or not.
+void testIdIndexedTable() {
+    std::cout << "\n=== Test: Id Indexed Table ===\n";
+
+    const int side = 16;
+    const std::vector<unsigned char> rgb = makeGradient(side, side);
+    const ParticleStore store = makeGrid(side, 4.0f);
+
+    MapPixel serial;
+    serial.filter = PixelFilter::Nearest;
+    serial.setImage(side, side, rgb.data());
+    serial.mapParticles(store, 0.0f, 0.0f, 4.0f, 4.0f);
+    assert(serial.size() == store.size());
+    assert(serial.idToColor.size() == store.size());
+
+    for (size_t i = 0; i < store.size(); ++i) {
+        const int column = static_cast<int>(i) % side;
+        const int row = static_cast<int>(i) / side;
+        const PixelData c = serial.getColorById(store.id[i]);
+        assert(near(c[0], column / 255.0f) && near(c[1], row / 255.0f));
+    }
+
+    WorkStealingPool pool(4);
+    MapPixel pooled;
+    pooled.filter = PixelFilter::Nearest;
+    pooled.setImage(side, side, rgb.data());
+    pooled.mapParticles(store, 0.0f, 0.0f, 4.0f, 4.0f, &pool);
+    assert(pooled.idToColor == serial.idToColor);
+
+    const PixelData missing = serial.getColorById(side * side + 5);
+    assert(near(missing[0], 0.5f));
+    serial.clear();
+    assert(!serial.hasColors() && serial.size() == 0);
+
+    std::cout << "PASSED: Id indexed table\n";
+}
+
+// Not a pass/fail check: re-mapping cost for a 100k-particle scene.
+void timeRemap() {
+    std::cout << "\n=== Timing: Re-map 100k Particles ===\n";
+
+    const int side = 317;   // ~100k particles
+    const ParticleStore store = makeGrid(side, 20.0f);
+    const std::vector<unsigned char> rgb = makeGradient(1024, 1024);
+    WorkStealingPool pool;
+
+    const PixelFilter filters[] = { PixelFilter::Nearest, PixelFilter::Bilinear, PixelFilter::Box };
+    const char* names[] = { "nearest ", "bilinear", "box     " };
+    for (int f = 0; f < 3; ++f) {
+        MapPixel map;
+        map.filter = filters[f];
+        auto t0 = std::chrono::high_resolution_clock::now();
+        map.setImage(1024, 1024, rgb.data());
+        auto t1 = std::chrono::high_resolution_clock::now();
+        map.mapParticles(store, 0.0f, 0.0f, 20.0f, 20.0f, &pool);
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        std::cout << std::fixed << std::setprecision(2) << names[f]
+                  << ": image setup " << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms, map "
+                  << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms for "
+                  << store.size() << " particles (" << pool.getThreadCount() << " threads)\n";
+    }
+}
+
+int main() {
+    testFilters();
+    testIdIndexedTable();
+    timeRemap();
+    std::cout << "\nAll color map tests passed.\n";
+    return 0;
+}
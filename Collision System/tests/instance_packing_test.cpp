@@ -0,0 +1,116 @@
+// Instanced renderer CPU side: color quantization, instance packing, and packing cost.
+// Runs without a GL context.
+
+#include <cassert>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "constants.h"
+#include "instance_packing.h"
+#include "particle_store.h"
+
+namespace {
+
+ParticleStore makeStore(int count) {
+    ParticleStore store;
+    store.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Particle p;
+        p.position = glm::vec2(WORLD_LEFT + 0.01f * i, WORLD_BOTTOM + 0.02f * i);
+        p.previous_position = p.position;
+        p.radius = 0.05f + 0.0001f * (i % 100);
+        p.color = glm::vec3((i % 256) / 255.0f, 0.5f, 1.0f);
+        p.id = i;
+        store.push(p);
+    }
+    return store;
+}
+
+} // namespace
+
+// Channels round to the nearest byte, clamp to [0, 1], and alpha is always opaque.
+void testColorPacking() {
+    std::cout << "\n=== Test: Instance Color Packing ===\n";
+
+    assert(packInstanceColor(glm::vec3(0.0f)) == 0xFF000000u);
+    assert(packInstanceColor(glm::vec3(1.0f)) == 0xFFFFFFFFu);
+    assert(packInstanceColor(glm::vec3(1.0f, 0.0f, 0.0f)) == 0xFF0000FFu);
+    assert(packInstanceColor(glm::vec3(0.0f, 1.0f, 0.0f)) == 0xFF00FF00u);
+    assert(packInstanceColor(glm::vec3(0.0f, 0.0f, 1.0f)) == 0xFFFF0000u);
+    assert(packInstanceColor(glm::vec3(0.5f, 0.0f, 0.0f)) == 0xFF000080u);
+    assert(packInstanceColor(glm::vec3(-1.0f, 2.0f, 0.0f)) == 0xFF00FF00u);
+
+    std::cout << "PASSED: Instance color packing\n";
+}
+
+// Every field of every instance matches the store, in storage order.
+void testPackingMatchesStore() {
+    std::cout << "\n=== Test: Packing Matches Store ===\n";
+
+    const ParticleStore store = makeStore(1000);
+    std::vector<ParticleInstance> out(store.size());
+    const size_t written = packParticleInstances(store, out.data(), out.size());
+    assert(written == store.size());
+
+    for (size_t i = 0; i < store.size(); ++i) {
+        assert(out[i].x == store.x[i]);
+        assert(out[i].y == store.y[i]);
+        assert(out[i].radius == store.radius[i]);
+        assert(out[i].color == packInstanceColor(store.color[i]));
+    }
+
+    std::cout << "PASSED: Packing matches store\n";
+}
+
+// A buffer smaller than the store is filled completely and never overrun.
+void testPackingRespectsCapacity() {
+    std::cout << "\n=== Test: Packing Respects Capacity ===\n";
+
+    const ParticleStore store = makeStore(100);
+    std::vector<ParticleInstance> out(64 + 1);
+    out[64].x = -123.0f;
+    const size_t written = packParticleInstances(store, out.data(), 64);
+    assert(written == 64);
+    assert(out[63].x == store.x[63]);
+    assert(out[64].x == -123.0f);
+
+    ParticleStore empty;
+    assert(packParticleInstances(empty, out.data(), out.size()) == 0);
+
+    std::cout << "PASSED: Packing respects capacity\n";
+}
+
+// Not a pass/fail check: report the per-frame packing cost at typical particle counts.
+void timePacking() {
+    std::cout << "\n=== Timing: Instance Packing ===\n";
+
+    const int counts[] = { MAX_PARTICLES, 100000 };
+    for (int count : counts) {
+        const ParticleStore store = makeStore(count);
+        std::vector<ParticleInstance> out(store.size());
+        const int repeats = 200;
+
+        packParticleInstances(store, out.data(), out.size()); // warm-up
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            packParticleInstances(store, out.data(), out.size());
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        const double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / repeats;
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(8) << count << " particles: " << us << " us/frame ("
+                  << std::setprecision(2) << (us * 1000.0 / count) << " ns/particle)\n";
+    }
+}
+
+int main() {
+    testColorPacking();
+    testPackingMatchesStore();
+    testPackingRespectsCapacity();
+    timePacking();
+    std::cout << "\nAll instance packing tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+// Narrow-phase work split into fixed square tiles of cells, colored like a 2x2
+// checkerboard: color = (tileX & 1) | ((tileY & 1) << 1).
+//
+// A cell's neighbourhood reaches one cell in every direction, so with tiles at least two
+// cells wide, two tiles of the same color never write the same particles and all tiles
+// of one color can run concurrently in any order. The four colors run one after another.
+// Tiles are anchored at cell (0, 0), so the layout (and therefore the result) does not
+// depend on the thread count or on which tiles happen to be scheduled; only tiles that
+// can hold particles are listed.
+struct TileSchedule {
+    static constexpr int kColors = 4;
+
+    struct Tile {
+        int32_t x;
+        int32_t y;
+    };
+
+    int tileSize = 8;                   // cells per tile edge
+    std::vector<Tile> tiles[kColors];
+
+    size_t tileCount(int color) const { return tiles[color].size(); }
+
+    // Every tile overlapping cells [minCol, maxCol] x [minRow, maxRow] (inclusive).
+    // An empty range (min > max) schedules nothing.
+    void build(int32_t minCol, int32_t minRow, int32_t maxCol, int32_t maxRow) {
+        reset();
+        if (minCol > maxCol || minRow > maxRow) return;
+        const int32_t tx0 = floorDiv(minCol, tileSize);
+        const int32_t ty0 = floorDiv(minRow, tileSize);
+        const int32_t tx1 = floorDiv(maxCol, tileSize);
+        const int32_t ty1 = floorDiv(maxRow, tileSize);
+        for (int32_t ty = ty0; ty <= ty1; ++ty) {
+            for (int32_t tx = tx0; tx <= tx1; ++tx) {
+                tiles[colorOf(tx, ty)].push_back(Tile{ tx, ty });
+            }
+        }
+    }
+
+    // Only the tiles holding one of `count` occupied cells, given in row-major order.
+    void buildFromCells(const int32_t* rows, const int32_t* cols, size_t count) {
+        reset();
+        addCells(rows, cols, count);
+        finish();
+    }
+
+    // buildFromCells over several cell lists: reset(), addCells() per list, finish().
+    void reset() {
+        tileSize = std::max(2, tileSize);
+        for (std::vector<Tile>& list : tiles) list.clear();
+    }
+
+    void addCells(const int32_t* rows, const int32_t* cols, size_t count) {
+        Tile previous{ 0, 0 };
+        for (size_t c = 0; c < count; ++c) {
+            const Tile tile{ floorDiv(cols[c], tileSize), floorDiv(rows[c], tileSize) };
+            if (c > 0 && tile.x == previous.x && tile.y == previous.y) continue;
+            tiles[colorOf(tile.x, tile.y)].push_back(tile);
+            previous = tile;
+        }
+    }
+
+    // Rows of the same tile row (and later lists) revisit the same tiles
+    void finish() {
+        for (std::vector<Tile>& list : tiles) {
+            std::sort(list.begin(), list.end(), [](const Tile& a, const Tile& b) {
+                return a.y != b.y ? a.y < b.y : a.x < b.x;
+            });
+            list.erase(std::unique(list.begin(), list.end(), [](const Tile& a, const Tile& b) {
+                return a.x == b.x && a.y == b.y;
+            }), list.end());
+        }
+    }
+
+    // Cells [col0, col1) x [row0, row1) of tile `index` of `color`
+    void tileCells(int color, size_t index, int32_t& col0, int32_t& row0, int32_t& col1, int32_t& row1) const {
+        const Tile& tile = tiles[color][index];
+        col0 = tile.x * tileSize;
+        row0 = tile.y * tileSize;
+        col1 = col0 + tileSize;
+        row1 = row0 + tileSize;
+    }
+
+    static int colorOf(int32_t tx, int32_t ty) {
+        return (tx & 1) | ((ty & 1) << 1);
+    }
+
+    static int32_t floorDiv(int32_t a, int32_t b) {
+        const int32_t q = a / b;
+        return (a % b != 0 && a < 0) ? q - 1 : q;
+    }
+};
@@ -1,10 +1,14 @@
 #include "utils.h"
 
-float randomFloat(float min, float max) {
+std::mt19937& randomEngine() {
     static std::random_device rd;
     static std::mt19937 gen(rd());
+    return gen;
+}
+
+float randomFloat(float min, float max) {
     std::uniform_real_distribution<float> dis(min, max);
-    return dis(gen);
+    return dis(randomEngine());
 }
 
 // Utility functions
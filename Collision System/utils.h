@@ -6,4 +6,7 @@
 
 // Function declarations
 float randomFloat(float min, float max);
+// Engine behind randomFloat(); seeded from std::random_device on first use. Exposed so
+// solver snapshots can save and restore it.
+std::mt19937& randomEngine();
 glm::vec2 screenToWorld(double xpos, double ypos);
@@ -6,23 +6,24 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "../shader.h"
-#include "../mesh.h"
-#include "../geometry/circle.h"
 #include "constants.h"
 #include "Nsolver.h"
 #include "utils.h"
 #include <iostream>
+#include <memory>
 #include <random>
 #include <vector>
 #include <iomanip>
 #include <string>
 #include "mapPixel.h"
+#include "stream_spawner.h"
+#include "particle_renderer.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
-float autoSpawnTimer = 0.0f;
+StreamSpawner spawner;
 bool spawnEnabled = true;
 
 const float fixedDeltaTime = 1.0f / 120.0f;
@@ -30,7 +31,15 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 float accumulator = 0.0f;
 
-Nsolver solver;
+// The color mapping replays the first pass's trajectories, so the fixed-point narrow
+// phase keeps the mapped image the same on every machine
+SolverConfig windowSolverConfig() {
+    SolverConfig config;
+    config.deterministic = true;
+    return config;
+}
+
+Nsolver solver(windowSolverConfig());
 
 // Image mapping state machine
 enum class SpawnState {
@@ -52,11 +61,11 @@ bool awaitingPhase3Input = false;
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
         solver.clearParticles();
-        mapPixel.idToColor.clear();
+        mapPixel.clear();
         mapPixelIndex = 0;
         currentState = SpawnState::INITIAL_GENERATION;
         spawnEnabled = true;
-        autoSpawnTimer = 0.0f;
+        spawner.reset();
         debugPaused = false;
         awaitingPhase3Input = false;
         std::cout << "Particles cleared - restarting color mapping" << std::endl;
@@ -96,33 +105,24 @@ int main() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // Shader and mesh setup
+    // Shader and instance buffer setup; needs the GL context, and is released before it
     std::cout << "Loading shaders..." << std::endl;
-    Shader shader2D("shaders/vertex.vs", "shaders/simple_fragment.fs");
-    std::cout << "Shaders loaded successfully" << std::endl;
-    
-    std::cout << "Creating circle mesh..." << std::endl;
-    Circle baseCircle(16, 1.0f);
-    Mesh circleMesh = baseCircle.toMesh();
-    std::cout << "Circle mesh created successfully" << std::endl;
-
-    // Texture setup
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    unsigned char whitePixel[] = {255, 255, 255, 255};
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    auto particleRenderer = std::make_unique<InstancedParticleRenderer>(16);
+    std::cout << "Shaders loaded successfully ("
+              << (particleRenderer->isPersistentlyMapped() ? "persistently mapped" : "per-frame mapped")
+              << " instance buffer)" << std::endl;
 
     // Performance monitoring
     int frameCount = 0;
     float fpsTimer = 0.0f;
 
-    std::cout << "Physics engine ready! Generating initial particle layout for color mapping..." << std::endl;
+    std::cout << "Physics engine ready! Narrow phase: " << simdLevelName(solver.getSimdLevel())
+              << (solver.isDeterministic() ? " (fixed point)" : "") << std::endl;
+    std::cout << "Generating initial particle layout for color mapping..." << std::endl;
     std::cout << "Right-click or press C to clear and restart." << std::endl;
     std::cout << "Press P to toggle auto-spawning once the simulation is running." << std::endl;
     std::cout << "Press K to switch images" << std::endl;
+    std::cout << "Press T to toggle the persistent worker team (barrier-synchronized substeps)" << std::endl;
 
     std::cout << "Entering main loop..." << std::endl;
     while (!glfwWindowShouldClose(window)) {
@@ -169,38 +169,22 @@ int main() {
                         break;
                     }
 
-                    std::vector<Particle>& particles = solver.getParticles();
+                    ParticleView particles = solver.getParticles();
                     float worldWidth = WORLD_RIGHT - WORLD_LEFT;
                     float worldHeight = WORLD_TOP - WORLD_BOTTOM;
                     
-                    // CRITICAL CHECK: Are particles stored in ID order in the vector?
-                    // This matters because Phase 3 spawns assume sequential ID assignment
-                    bool idOrderMismatch = false;
-                    for (size_t i = 0; i < particles.size(); ++i) {
-                        if (particles[i].id != (int)i) {
-                            idOrderMismatch = true;
-                            break;
-                        }
-                    }
-                    
-                    if (idOrderMismatch) {
-                        std::cout << "\n!!! WARNING: Particle IDs do NOT match vector indices !!!" << std::endl;
-                        std::cout << "This means the ID-to-color mapping will be incorrect!" << std::endl;
-                        std::cout << "First 10 particles showing [index] vs ID:" << std::endl;
-                        for (int i = 0; i < std::min(10, (int)particles.size()); ++i) {
-                            std::cout << "  particles[" << i << "].id = " << particles[i].id;
-                            if (particles[i].id != i) std::cout << " *** MISMATCH ***";
-                            std::cout << std::endl;
-                        }
-                    }
+                    // Storage order follows grid cells (the solver re-sorts particles
+                    // periodically), so colors are mapped and looked up by particle ID.
                     
                     try {
                         if (useFirstImage) {
                             std::cout << "Mapping particles to colors from image: " << IMAGE_PATH1 << std::endl;
-                            mapPixel.addParticles(particles, IMAGE_PATH3, worldWidth, worldHeight);
+                            mapPixel.addParticles(solver.getParticleStore(), IMAGE_PATH3, worldWidth, worldHeight,
+                                                  &solver.getThreadPool());
                         } else {
                             std::cout << "Mapping particles to colors from image: " << IMAGE_PATH2 << std::endl;
-                            mapPixel.addParticles(particles, IMAGE_PATH2, worldWidth, worldHeight);
+                            mapPixel.addParticles(solver.getParticleStore(), IMAGE_PATH2, worldWidth, worldHeight,
+                                                  &solver.getThreadPool());
                         }
                         std::cout << "Color mapping complete. " << mapPixel.size() 
                                   << " colors stored." << std::endl;
@@ -208,7 +192,7 @@ int main() {
                         // DEBUG: Apply mapped colors to current particles for visualization
                         std::cout << "\n=== DEBUG MODE ===" << std::endl;
                         std::cout << "Applying mapped colors to settled particles for verification..." << std::endl;
-                        for (auto& p : particles) {
+                        for (const auto& p : particles) {
                             auto col = mapPixel.getColorById(p.id);
                             p.color = glm::vec3(col[0], col[1], col[2]);
                         }
@@ -219,13 +203,13 @@ int main() {
                         awaitingPhase3Input = true;
                         spawnEnabled = false;
                         accumulator = 0.0f;
-                        autoSpawnTimer = 0.0f;
+                        spawner.reset();
                         // Don't clear particles yet - stay in this state until user presses space
                     } catch (const std::exception& e) {
                         std::cerr << "Image mapping failed: " << e.what() << std::endl;
                         // Fall back to initial generation with default colors
                         currentState = SpawnState::INITIAL_GENERATION;
-                        mapPixel.idToColor.clear();
+                        mapPixel.clear();
                         awaitingPhase3Input = false;
                         debugPaused = false;
                         spawnEnabled = true;
@@ -253,39 +237,25 @@ int main() {
                 while (accumulator >= fixedDeltaTime) {
                     // 1) Deterministic spawning happens FIRST in each fixed step
                     if (spawnEnabled) {
-                        autoSpawnTimer += fixedDeltaTime;
-                        while (autoSpawnTimer >= AUTO_SPAWN_INTERVAL) {
-                            float baseY = WORLD_TOP - TOP_MARGIN;
-                            float x = WORLD_LEFT + SPAWN_MARGIN_X;
-                            for (int i = 0; i < STREAM_COUNT; ++i) {
-                                // Stop conditions per mode
-                                if (currentState == SpawnState::INITIAL_GENERATION) {
-                                    if (solver.getParticleCount() >= MAX_PARTICLES) break;
-                                } else if (currentState == SpawnState::SPAWNING_COLORED) {
-                                    if (mapPixelIndex >= mapPixel.size()) break;
-                                }
-
-                                float y = baseY - i * STREAM_SPACING;
-                                if (y - 0.2f < WORLD_BOTTOM) break;
-
-                                glm::vec2 spawnPos(x, y);
-
-                                if (currentState == SpawnState::INITIAL_GENERATION) {
-                                    Particle p = solver.createParticle(spawnPos, CONSTANT_VELOCITY, 0.07f,
-                                                                       fixedDeltaTime, true);
-                                    solver.addParticle(p);
-                                } else if (currentState == SpawnState::SPAWNING_COLORED) {
-                                    Particle p = solver.createParticle(spawnPos, CONSTANT_VELOCITY, 0.07f,
-                                                                       fixedDeltaTime, false);
-                                    auto col = mapPixel.getColorById(p.id);
-                                    p.color = glm::vec3(col[0], col[1], col[2]);
-
-                                    solver.addParticle(p);
-                                    ++mapPixelIndex;
-                                }
+                        spawner.step(fixedDeltaTime, [](glm::vec2 spawnPos) {
+                            // Stop conditions per mode
+                            if (currentState == SpawnState::INITIAL_GENERATION) {
+                                if (solver.getParticleCount() >= MAX_PARTICLES) return false;
+                                Particle p = solver.createParticle(spawnPos, CONSTANT_VELOCITY, 0.07f,
+                                                                   fixedDeltaTime, true);
+                                solver.addParticle(p);
+                            } else if (currentState == SpawnState::SPAWNING_COLORED) {
+                                if (mapPixelIndex >= mapPixel.size()) return false;
+                                Particle p = solver.createParticle(spawnPos, CONSTANT_VELOCITY, 0.07f,
+                                                                   fixedDeltaTime, false);
+                                auto col = mapPixel.getColorById(p.id);
+                                p.color = glm::vec3(col[0], col[1], col[2]);
+
+                                solver.addParticle(p);
+                                ++mapPixelIndex;
                             }
-                            autoSpawnTimer -= AUTO_SPAWN_INTERVAL;
-                        }
+                            return true;
+                        });
                     }
 
                     // 2) Then advance physics one fixed step
@@ -311,7 +281,9 @@ int main() {
                         std::cout << std::fixed << std::setprecision(1)
                                 << "FPS: " << fps
                                 << " | UPS: " << ups
-                                << " | Particles: " << particleCount 
+                                << " | Particles: " << particleCount
+                                << " | Awake: " << solver.getAwakeCount()
+                                << std::setprecision(2) << " | Imbalance: " << solver.getLoadImbalance()
                                 << " | State: ";
                         
                         switch(currentState) {
@@ -336,46 +308,14 @@ int main() {
         glClearColor(0.05f, 0.05f, 0.15f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        const std::vector<Particle>& particles = solver.getParticles();
-        
-        if (!particles.empty()) {
-            glm::mat4 projection = glm::ortho(WORLD_LEFT, WORLD_RIGHT, WORLD_BOTTOM, WORLD_TOP, -1.0f, 1.0f);
-            glm::mat4 view = glm::mat4(1.0f);
-
-            shader2D.use();
-            shader2D.setMat4("projection", projection);
-            shader2D.setMat4("view", view);
-
-            shader2D.setVec3("lightColor", glm::vec3(1.0f));
-            shader2D.setVec3("viewPos", glm::vec3(0.0f, 0.0f, 1.0f));
-            shader2D.setVec3("dirLight.direction", glm::vec3(0.0f, 0.0f, -1.0f));
-            shader2D.setVec3("dirLight.ambient", glm::vec3(0.7f));
-            shader2D.setVec3("dirLight.diffuse", glm::vec3(0.3f));
-            shader2D.setVec3("dirLight.specular", glm::vec3(0.1f));
-
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            shader2D.setInt("texture1", 0);
-
-            for (const Particle& particle : particles) {
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(particle.position.x, particle.position.y, 0.0f));
-                model = glm::scale(model, glm::vec3(particle.radius));
-
-                shader2D.setMat4("model", model);
-                shader2D.setVec3("material.ambient", particle.color * 0.6f);
-                shader2D.setVec3("material.diffuse", particle.color);
-                shader2D.setVec3("material.specular", glm::vec3(0.05f));
-                shader2D.setFloat("material.shininess", 8.0f);
-
-                circleMesh.Draw(shader2D);
-            }
-        }
+        // All particles in one instanced draw call
+        const glm::mat4 projection = glm::ortho(WORLD_LEFT, WORLD_RIGHT, WORLD_BOTTOM, WORLD_TOP, -1.0f, 1.0f);
+        particleRenderer->draw(solver.getParticleStore(), projection);
 
         glfwSwapBuffers(window);
     }
 
-    glDeleteTextures(1, &texture);
+    particleRenderer.reset();
     glfwTerminate();
     return 0;
 }
@@ -388,12 +328,12 @@ void processInput(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
         if (!cKeyPressed) {
             solver.clearParticles();
-            mapPixel.idToColor.clear();
+            mapPixel.clear();
             mapPixelIndex = 0;
             currentState = SpawnState::INITIAL_GENERATION;
             debugPaused = false;
             spawnEnabled = true;
-            autoSpawnTimer = 0.0f;
+            spawner.reset();
             awaitingPhase3Input = false;
             std::cout << "All particles cleared - restarting color mapping!" << std::endl;
             cKeyPressed = true;
@@ -424,6 +364,17 @@ void processInput(GLFWwindow *window) {
         kKeyPressed = false;
     }
 
+    static bool tKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS) {
+        if (!tKeyPressed) {
+            solver.setPersistentTeam(!solver.usesPersistentTeam());
+            std::cout << (solver.usesPersistentTeam() ? "Persistent worker team enabled" : "Work-stealing pool enabled") << std::endl;
+            tKeyPressed = true;
+        }
+    } else {
+        tKeyPressed = false;
+    }
+
     static bool spacePressed = false;
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
         if (!spacePressed) {
@@ -435,7 +386,7 @@ void processInput(GLFWwindow *window) {
                     solver.clearParticles();
                     mapPixelIndex = 0;
                     spawnEnabled = true;
-                    autoSpawnTimer = 0.0f;
+                    spawner.reset();
                     currentState = SpawnState::SPAWNING_COLORED;
                 }
             }
@@ -0,0 +1,246 @@
+#include "ChunkedMesher.h"
+#include "../work_stealing_pool.h"
+#include <algorithm>
+
+// Room to grow by a quarter before a chunk has to move. Index ranges stay whole
+// triangles so the filler after them stays aligned.
+static std::size_t vertexSlack(std::size_t count) { return count + count / 4 + 16; }
+static std::size_t indexSlack(std::size_t count) { return count + count / 12 * 3 + 48; }
+
+ChunkedMesher::ChunkedMesher(int chunkSize)
+    : chunkSize_(std::max(1, chunkSize))
+{
+}
+
+void ChunkedMesher::setMeshMode(MeshMode mode)
+{
+    if (mode == meshMode_) return;
+    meshMode_ = mode;
+    markAllDirty();
+}
+
+void ChunkedMesher::setIsoLevel(float isoLevel)
+{
+    if (isoLevel == isoLevel_) return;
+    isoLevel_ = isoLevel;
+    markAllDirty();
+}
+
+void ChunkedMesher::build(const ScalarFieldView& field, float isoLevel, WorkStealingPool* pool,
+                          const FieldBlockRanges* blocks)
+{
+    isoLevel_ = isoLevel;
+    sizeX_ = field.sizeX;
+    sizeY_ = field.sizeY;
+    sizeZ_ = field.sizeZ;
+    chunks_.clear();
+    vertices_.clear();
+    indices_.clear();
+    liveVertices_ = liveIndices_ = 0;
+    patch_ = Patch();
+    if (!field.hasCubes())
+    {
+        chunksX_ = chunksY_ = chunksZ_ = 0;
+        return;
+    }
+
+    const CubeRegion whole = CubeRegion::wholeField(field);
+    chunksX_ = (whole.x1 + chunkSize_ - 1) / chunkSize_;
+    chunksY_ = (whole.y1 + chunkSize_ - 1) / chunkSize_;
+    chunksZ_ = (whole.z1 + chunkSize_ - 1) / chunkSize_;
+    chunks_.resize(static_cast<std::size_t>(chunksX_) * chunksY_ * chunksZ_);
+    for (int cz = 0; cz < chunksZ_; ++cz)
+        for (int cy = 0; cy < chunksY_; ++cy)
+            for (int cx = 0; cx < chunksX_; ++cx)
+            {
+                Chunk& chunk = chunks_[(static_cast<std::size_t>(cz) * chunksY_ + cy) * chunksX_ + cx];
+                chunk.cubes.x0 = cx * chunkSize_;
+                chunk.cubes.y0 = cy * chunkSize_;
+                chunk.cubes.z0 = cz * chunkSize_;
+                chunk.cubes.x1 = std::min(chunk.cubes.x0 + chunkSize_, whole.x1);
+                chunk.cubes.y1 = std::min(chunk.cubes.y0 + chunkSize_, whole.y1);
+                chunk.cubes.z1 = std::min(chunk.cubes.z0 + chunkSize_, whole.z1);
+            }
+
+    std::vector<int> all(chunks_.size());
+    for (std::size_t i = 0; i < all.size(); ++i) all[i] = static_cast<int>(i);
+    meshChunks(field, all, pool, blocks);
+    relayout();
+}
+
+void ChunkedMesher::markAllDirty()
+{
+    for (Chunk& chunk : chunks_) chunk.dirty = true;
+}
+
+void ChunkedMesher::markDirty(int minX, int minY, int minZ, int maxX, int maxY, int maxZ)
+{
+    if (chunks_.empty()) return;
+
+    // Cube c has samples c and c+1 as corners. Shared-vertex normals also read the
+    // gradient at edge ends, which reaches one sample further on each side.
+    const int reach = meshMode_ == MeshMode::SharedVertices ? 2 : 1;
+    const int lastX = chunksX_ - 1, lastY = chunksY_ - 1, lastZ = chunksZ_ - 1;
+    const int cx0 = std::max(0, (minX - reach) / chunkSize_), cx1 = std::min(lastX, (maxX + reach - 1) / chunkSize_);
+    const int cy0 = std::max(0, (minY - reach) / chunkSize_), cy1 = std::min(lastY, (maxY + reach - 1) / chunkSize_);
+    const int cz0 = std::max(0, (minZ - reach) / chunkSize_), cz1 = std::min(lastZ, (maxZ + reach - 1) / chunkSize_);
+    for (int cz = cz0; cz <= cz1; ++cz)
+        for (int cy = cy0; cy <= cy1; ++cy)
+            for (int cx = cx0; cx <= cx1; ++cx)
+                chunks_[(static_cast<std::size_t>(cz) * chunksY_ + cy) * chunksX_ + cx].dirty = true;
+}
+
+int ChunkedMesher::update(const ScalarFieldView& field, WorkStealingPool* pool, const FieldBlockRanges* blocks)
+{
+    patch_ = Patch();
+    if (field.sizeX != sizeX_ || field.sizeY != sizeY_ || field.sizeZ != sizeZ_)
+    {
+        build(field, isoLevel_, pool, blocks);
+        return static_cast<int>(chunks_.size());
+    }
+
+    std::vector<int> dirty;
+    for (std::size_t i = 0; i < chunks_.size(); ++i)
+        if (chunks_[i].dirty) dirty.push_back(static_cast<int>(i));
+    if (dirty.empty()) return 0;
+
+    meshChunks(field, dirty, pool, blocks);
+
+    // Patch in chunk order so the layout does not depend on the thread count
+    for (const int index : dirty)
+    {
+        Chunk& chunk = chunks_[index];
+        if (chunk.vertices.size() > chunk.vertexCapacity || chunk.indices.size() > chunk.indexCapacity)
+        {
+            // Outgrew its ranges: retire them and move to the end
+            fillDegenerate(chunk.indexOffset, chunk.indexOffset + chunk.indexCapacity, 0);
+            touch(0, 0, chunk.indexOffset, chunk.indexOffset + chunk.indexCapacity);
+            chunk.vertexCapacity = vertexSlack(chunk.vertices.size());
+            chunk.indexCapacity = indexSlack(chunk.indices.size());
+            chunk.vertexOffset = vertices_.size();
+            chunk.indexOffset = indices_.size();
+            vertices_.resize(vertices_.size() + chunk.vertexCapacity);
+            indices_.resize(indices_.size() + chunk.indexCapacity);
+        }
+        writeChunk(chunk);
+    }
+
+    liveVertices_ = liveIndices_ = 0;
+    for (const Chunk& chunk : chunks_)
+    {
+        liveVertices_ += chunk.vertices.size();
+        liveIndices_ += chunk.indices.size();
+    }
+
+    // Moved chunks leave holes; repack once they are more than half the buffer
+    if (vertices_.size() > 2 * liveVertices_ + 4096 || indices_.size() > 2 * liveIndices_ + 12288)
+        relayout();
+    return static_cast<int>(dirty.size());
+}
+
+bool ChunkedMesher::chunkMayCross(const Chunk& chunk, const FieldBlockRanges* blocks) const
+{
+    if (!blocks) return true;
+    const int blockSize = FieldBlockRanges::kBlockSize;
+    const CubeRegion& c = chunk.cubes;
+    for (int bz = c.z0 / blockSize; bz <= (c.z1 - 1) / blockSize; ++bz)
+        for (int by = c.y0 / blockSize; by <= (c.y1 - 1) / blockSize; ++by)
+            for (int bx = c.x0 / blockSize; bx <= (c.x1 - 1) / blockSize; ++bx)
+                if (blocks->mayCross(blocks->blockIndex(bx, by, bz), isoLevel_)) return true;
+    return false;
+}
+
+void ChunkedMesher::meshChunks(const ScalarFieldView& field, const std::vector<int>& dirty,
+                               WorkStealingPool* pool, const FieldBlockRanges* blocks)
+{
+    if (blocks && !blocks->covers(field)) blocks = nullptr;
+
+    const std::size_t slots = pool ? pool->getThreadCount() : 1;
+    if (meshers_.size() < slots) meshers_.resize(slots);
+    for (CubeMarching& mesher : meshers_) mesher.setMeshMode(meshMode_);
+
+    auto meshRange = [&](int first, int last) {
+        CubeMarching& mesher = meshers_[pool ? pool->currentSlot() : 0];
+        for (int i = first; i < last; ++i)
+        {
+            Chunk& chunk = chunks_[dirty[i]];
+            chunk.dirty = false;
+            if (!chunkMayCross(chunk, blocks))
+            {
+                chunk.vertices.clear();
+                chunk.indices.clear();
+                continue;
+            }
+            mesher.generateRegion(field, isoLevel_, chunk.cubes, blocks);
+            chunk.vertices.assign(mesher.getVertices().begin(), mesher.getVertices().end());
+            chunk.indices.assign(mesher.getIndices().begin(), mesher.getIndices().end());
+        }
+    };
+
+    const int count = static_cast<int>(dirty.size());
+    if (pool)
+        pool->parallelFor(0, count, 1, meshRange);
+    else
+        meshRange(0, count);
+}
+
+void ChunkedMesher::relayout()
+{
+    std::size_t vertexCount = 0, indexCount = 0;
+    for (Chunk& chunk : chunks_)
+    {
+        chunk.vertexOffset = vertexCount;
+        chunk.indexOffset = indexCount;
+        chunk.vertexCapacity = chunk.vertices.empty() ? 0 : vertexSlack(chunk.vertices.size());
+        chunk.indexCapacity = chunk.indices.empty() ? 0 : indexSlack(chunk.indices.size());
+        vertexCount += chunk.vertexCapacity;
+        indexCount += chunk.indexCapacity;
+    }
+    vertices_.assign(vertexCount, Vertex{});
+    indices_.assign(indexCount, 0);
+
+    liveVertices_ = liveIndices_ = 0;
+    for (Chunk& chunk : chunks_)
+    {
+        writeChunk(chunk);
+        liveVertices_ += chunk.vertices.size();
+        liveIndices_ += chunk.indices.size();
+    }
+    patch_ = Patch{ 0, vertices_.size(), 0, indices_.size() };
+}
+
+void ChunkedMesher::writeChunk(Chunk& chunk)
+{
+    std::copy(chunk.vertices.begin(), chunk.vertices.end(), vertices_.begin() + chunk.vertexOffset);
+
+    const int base = static_cast<int>(chunk.vertexOffset);
+    int* out = indices_.data() + chunk.indexOffset;
+    for (const int index : chunk.indices) *out++ = base + index;
+    fillDegenerate(chunk.indexOffset + chunk.indices.size(), chunk.indexOffset + chunk.indexCapacity, base);
+
+    touch(chunk.vertexOffset, chunk.vertexOffset + chunk.vertices.size(),
+          chunk.indexOffset, chunk.indexOffset + chunk.indexCapacity);
+}
+
+void ChunkedMesher::fillDegenerate(std::size_t indexBegin, std::size_t indexEnd, int vertex)
+{
+    std::fill(indices_.begin() + indexBegin, indices_.begin() + indexEnd, vertex);
+}
+
+void ChunkedMesher::touch(std::size_t vertexBegin, std::size_t vertexEnd, std::size_t indexBegin, std::size_t indexEnd)
+{
+    // Grow each span to cover the new one; an empty span just takes it
+    auto grow = [](std::size_t& begin, std::size_t& end, std::size_t newBegin, std::size_t newEnd) {
+        if (newBegin >= newEnd) return;
+        if (begin >= end)
+        {
+            begin = newBegin;
+            end = newEnd;
+            return;
+        }
+        begin = std::min(begin, newBegin);
+        end = std::max(end, newEnd);
+    };
+    grow(patch_.vertexBegin, patch_.vertexEnd, vertexBegin, vertexEnd);
+    grow(patch_.indexBegin, patch_.indexEnd, indexBegin, indexEnd);
+}
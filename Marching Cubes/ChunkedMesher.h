@@ -0,0 +1,98 @@
+#ifndef CHUNKEDMESHER_H
+#define CHUNKEDMESHER_H
+
+#include <cstddef>
+#include <vector>
+#include "CubeMarching.h"
+#include "ScalarField.h"
+
+class WorkStealingPool;
+
+// Marching cubes over fixed-size chunks of cubes with one combined vertex/index buffer.
+//
+// Every chunk caches its own mesh and owns a range of each combined buffer, with some
+// slack. After an edit, markDirty() flags the chunks whose cubes can see the changed
+// samples and update() re-meshes only those. Each one is written back into its range,
+// or moved to the end of the buffers if it outgrew the range. The unused tail of a
+// range holds degenerate triangles, so the buffers can always be drawn as they are.
+// getPatch() gives the spans the last update() wrote, for partial re-uploads.
+//
+// Positions and normals are those of the whole-field mesh. In SharedVertices mode,
+// vertices on chunk faces are duplicated, one copy per chunk.
+class ChunkedMesher {
+public:
+    static constexpr int kDefaultChunkSize = 32; // cubes per axis
+
+    // Buffer spans written by the last update() or build(), in elements, [begin, end)
+    struct Patch {
+        std::size_t vertexBegin = 0, vertexEnd = 0;
+        std::size_t indexBegin = 0, indexEnd = 0;
+        bool empty() const { return vertexBegin >= vertexEnd && indexBegin >= indexEnd; }
+    };
+
+    explicit ChunkedMesher(int chunkSize = kDefaultChunkSize);
+
+    // Output layout of each chunk; changing it marks every chunk dirty.
+    void setMeshMode(MeshMode mode);
+    MeshMode getMeshMode() const { return meshMode_; }
+
+    // Lay chunks over the field and mesh all of them. With block ranges built for this
+    // field, chunks and cube rows holding no surface are skipped.
+    void build(const ScalarFieldView& field, float isoLevel, WorkStealingPool* pool = nullptr,
+               const FieldBlockRanges* blocks = nullptr);
+
+    // New iso level: every chunk is re-meshed on the next update().
+    void setIsoLevel(float isoLevel);
+    float getIsoLevel() const { return isoLevel_; }
+
+    // Samples in [min, max] (inclusive, clamped to the field) changed value.
+    void markDirty(int minX, int minY, int minZ, int maxX, int maxY, int maxZ);
+    void markAllDirty();
+
+    // Re-mesh the dirty chunks against `field` (same dimensions as at build time; the
+    // data may have moved) and patch the combined buffers. Returns the chunks re-meshed.
+    int update(const ScalarFieldView& field, WorkStealingPool* pool = nullptr,
+               const FieldBlockRanges* blocks = nullptr);
+
+    const std::vector<Vertex>& getVertices() const { return vertices_; }
+    const std::vector<int>& getIndices() const { return indices_; }
+    std::size_t getTriangleCount() const { return liveIndices_ / 3; } // without filler
+    const Patch& getPatch() const { return patch_; }
+
+    int getChunkSize() const { return chunkSize_; }
+    std::size_t getChunkCount() const { return chunks_.size(); }
+
+private:
+    struct Chunk {
+        CubeRegion cubes;
+        std::vector<Vertex> vertices; // cached mesh, indices local to the chunk
+        std::vector<int> indices;
+        std::size_t vertexOffset = 0, vertexCapacity = 0;
+        std::size_t indexOffset = 0, indexCapacity = 0;
+        bool dirty = true;
+    };
+
+    bool chunkMayCross(const Chunk& chunk, const FieldBlockRanges* blocks) const;
+    void meshChunks(const ScalarFieldView& field, const std::vector<int>& dirty,
+                    WorkStealingPool* pool, const FieldBlockRanges* blocks);
+    void relayout();               // pack every chunk from the start of the buffers
+    void writeChunk(Chunk& chunk); // copy the cached mesh into the chunk's ranges
+    void fillDegenerate(std::size_t indexBegin, std::size_t indexEnd, int vertex);
+    void touch(std::size_t vertexBegin, std::size_t vertexEnd, std::size_t indexBegin, std::size_t indexEnd);
+
+    int chunkSize_;
+    MeshMode meshMode_{MeshMode::FlatShaded};
+    float isoLevel_{0.0f};
+    int sizeX_{0}, sizeY_{0}, sizeZ_{0};
+    int chunksX_{0}, chunksY_{0}, chunksZ_{0};
+
+    std::vector<Chunk> chunks_{};
+    std::vector<CubeMarching> meshers_{}; // one per pool slot
+    std::vector<Vertex> vertices_{};
+    std::vector<int> indices_{};
+    std::size_t liveVertices_{0};
+    std::size_t liveIndices_{0};
+    Patch patch_{};
+};
+
+#endif // CHUNKEDMESHER_H
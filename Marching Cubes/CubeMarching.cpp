@@ -1,12 +1,50 @@
 /*Reference: https://github.com/nihaljn/marching-cubes/tree/main*/
 #include "CubeMarching.h"
 #include "tables.h"
+#include "../work_stealing_pool.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <iterator>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/norm.hpp>
 
+// One tables.h case, packed: the crossed edges in ascending order and the triTable row
+// without its -1 terminator, with both counts up front.
+struct MarchingCase {
+    unsigned char edgeCount;
+    unsigned char triangleCount;
+    unsigned char edges[12];
+    unsigned char triangles[15];
+};
+
+static constexpr std::array<MarchingCase, 256> buildMarchingCases()
+{
+    std::array<MarchingCase, 256> cases{};
+    for (int cubeIndex = 0; cubeIndex < 256; ++cubeIndex)
+    {
+        MarchingCase& packed = cases[cubeIndex];
+        for (int edge = 0; edge < 12; ++edge)
+            if (edgeTable[cubeIndex] & (1 << edge))
+                packed.edges[packed.edgeCount++] = static_cast<unsigned char>(edge);
+        int count = 0;
+        while (count < 15 && triTable[cubeIndex][count] != -1)
+        {
+            packed.triangles[count] = static_cast<unsigned char>(triTable[cubeIndex][count]);
+            ++count;
+        }
+        packed.triangleCount = static_cast<unsigned char>(count / 3);
+    }
+    return cases;
+}
+
+static constexpr std::array<MarchingCase, 256> kMarchingCases = buildMarchingCases();
+static_assert(kMarchingCases[0].triangleCount == 0 && kMarchingCases[255].triangleCount == 0,
+              "empty and full cubes have no triangles");
+static_assert(kMarchingCases[1].edgeCount == 3 && kMarchingCases[1].triangleCount == 1,
+              "a single corner inside cuts three edges with one triangle");
+
 // Compute face normal (cross of two edges) and normalize.
 static glm::vec3 calculateFaceNormal(const Vertex& v0, const Vertex& v1, const Vertex& v2)
 {
@@ -138,8 +176,24 @@ std::vector<std::array<int,3>> CubeMarching::triangulateField(const std::vector<
     return triangles;
 }
 
-void CubeMarching::generateMesh(const std::vector<std::vector<std::vector<float>>>& scalarField, float isoLevel)
+void CubeMarching::generateMesh(const std::vector<std::vector<std::vector<float>>>& scalarField, float isoLevel,
+                                WorkStealingPool* pool)
 {
+    if (meshMode_ == MeshMode::SharedVertices || pool)
+    {
+        // The edge caches walk a flat field; field[z][y][x] becomes x-fastest samples
+        const int sizeZ = static_cast<int>(scalarField.size());
+        const int sizeY = sizeZ > 0 ? static_cast<int>(scalarField[0].size()) : 0;
+        const int sizeX = sizeY > 0 ? static_cast<int>(scalarField[0][0].size()) : 0;
+        std::vector<float> flat;
+        flat.reserve(static_cast<std::size_t>(sizeX) * sizeY * sizeZ);
+        for (const auto& slice : scalarField)
+            for (const auto& row : slice)
+                flat.insert(flat.end(), row.begin(), row.end());
+        generateMesh(ScalarFieldView::dense(flat.data(), sizeX, sizeY, sizeZ), isoLevel, pool);
+        return;
+    }
+
     isoLevel_ = isoLevel;
     vertices_.clear();
     indices_.clear();
@@ -157,6 +211,462 @@ void CubeMarching::generateMesh(const std::vector<std::vector<std::vector<float>
     }
 }
 
+// Block mask for marchLayers: one flag per FieldBlockRanges block, x fastest
+struct BlockMask {
+    const unsigned char* active;
+    int blocksX;
+    int blocksY;
+};
+
+// Visit every cube of `cubes` that the surface crosses, two slices at a time:
+// emit(cubeValues, cubeIndex, x, y, z). With a mask, each cube row only walks the runs
+// of blocks that may hold surface.
+template <typename EmitFn>
+static void marchLayers(const ScalarFieldView& field, float isoLevel, const CubeRegion& cubes,
+                        const BlockMask* mask, EmitFn&& emit)
+{
+    const std::ptrdiff_t sx = field.strideX;
+    float cubeValues[GridCell::CornerCount];
+
+    for (int z = cubes.z0; z < cubes.z1; ++z)
+    {
+        for (int y = cubes.y0; y < cubes.y1; ++y)
+        {
+            // Rows (y, y+1) of slices z and z+1 hold all eight corners of this cube row
+            const float* bottomNear = field.row(y, z);
+            const float* bottomFar = field.row(y + 1, z);
+            const float* topNear = field.row(y, z + 1);
+            const float* topFar = field.row(y + 1, z + 1);
+
+            auto marchRun = [&](int xBegin, int xEnd) {
+                // Corners 1, 2, 5, 6 of one cube are corners 0, 3, 4, 7 of the next
+                const std::ptrdiff_t first = xBegin * sx;
+                float v1 = bottomNear[first], v2 = bottomFar[first], v5 = topNear[first], v6 = topFar[first];
+                for (int x = xBegin; x < xEnd; ++x)
+                {
+                    const float v0 = v1, v3 = v2, v4 = v5, v7 = v6;
+                    const std::ptrdiff_t next = (x + 1) * sx;
+                    v1 = bottomNear[next];
+                    v2 = bottomFar[next];
+                    v5 = topNear[next];
+                    v6 = topFar[next];
+
+                    const int cubeIndex = (v0 < isoLevel ? 1 : 0)   | (v1 < isoLevel ? 2 : 0)
+                                        | (v2 < isoLevel ? 4 : 0)   | (v3 < isoLevel ? 8 : 0)
+                                        | (v4 < isoLevel ? 16 : 0)  | (v5 < isoLevel ? 32 : 0)
+                                        | (v6 < isoLevel ? 64 : 0)  | (v7 < isoLevel ? 128 : 0);
+                    if (cubeIndex == 0 || cubeIndex == 255) continue; // no crossed edges
+
+                    cubeValues[0] = v0; cubeValues[1] = v1; cubeValues[2] = v2; cubeValues[3] = v3;
+                    cubeValues[4] = v4; cubeValues[5] = v5; cubeValues[6] = v6; cubeValues[7] = v7;
+                    emit(cubeValues, cubeIndex, x, y, z);
+                }
+            };
+
+            if (!mask)
+            {
+                marchRun(cubes.x0, cubes.x1);
+                continue;
+            }
+
+            const int blockSize = FieldBlockRanges::kBlockSize;
+            const unsigned char* blockRow =
+                mask->active + (static_cast<std::size_t>(z / blockSize) * mask->blocksY + y / blockSize) * mask->blocksX;
+            const int lastBlock = (cubes.x1 - 1) / blockSize;
+            for (int bx = cubes.x0 / blockSize; bx <= lastBlock; ++bx)
+            {
+                if (!blockRow[bx]) continue;
+                const int runBegin = bx;
+                while (bx < lastBlock && blockRow[bx + 1]) ++bx;
+                marchRun(std::max(runBegin * blockSize, cubes.x0), std::min((bx + 1) * blockSize, cubes.x1));
+            }
+        }
+    }
+}
+
+void CubeMarching::generateMesh(const ScalarFieldView& field, float isoLevel, WorkStealingPool* pool)
+{
+    generateMeshImpl(field, isoLevel, CubeRegion::wholeField(field), nullptr, pool, false);
+}
+
+void CubeMarching::generateMesh(const ScalarFieldView& field, float isoLevel, const FieldBlockRanges& blocks,
+                                WorkStealingPool* pool)
+{
+    generateMeshImpl(field, isoLevel, CubeRegion::wholeField(field), blocks.covers(field) ? &blocks : nullptr, pool,
+                     false);
+}
+
+void CubeMarching::generateRegion(const ScalarFieldView& field, float isoLevel, const CubeRegion& region,
+                                  const FieldBlockRanges* blocks, WorkStealingPool* pool)
+{
+    const CubeRegion whole = CubeRegion::wholeField(field);
+    CubeRegion clamped;
+    clamped.x0 = std::max(region.x0, whole.x0);
+    clamped.y0 = std::max(region.y0, whole.y0);
+    clamped.z0 = std::max(region.z0, whole.z0);
+    clamped.x1 = std::min(region.x1, whole.x1);
+    clamped.y1 = std::min(region.y1, whole.y1);
+    clamped.z1 = std::min(region.z1, whole.z1);
+    generateMeshImpl(field, isoLevel, clamped, blocks && blocks->covers(field) ? blocks : nullptr, pool,
+                     bottomFromBelow_);
+}
+
+int CubeMarching::getTopSliceVertex(std::size_t key) const
+{
+    if (topSlab_ < 0 || meshMode_ != MeshMode::SharedVertices) return -1;
+    const EdgeCache& top = slabs_[topSlab_].edges;
+    const std::size_t cell = key / 2;
+    if (cell >= top.x[1].size()) return -1;
+    const int local = (key % 2 == 0) ? top.x[1][cell] : top.y[1][cell];
+    return local < 0 ? -1 : static_cast<int>(topSlabBase_) + local;
+}
+
+void CubeMarching::generateMeshImpl(const ScalarFieldView& field, float isoLevel, const CubeRegion& region,
+                                    const FieldBlockRanges* blocks, WorkStealingPool* pool, bool bottomFromBelow)
+{
+    isoLevel_ = isoLevel;
+    vertices_.clear();
+    indices_.clear();
+    activeBlocks_.clear();
+    topSlab_ = -1;
+    if (!field.hasCubes() || region.empty()) return;
+
+    if (blocks)
+    {
+        // Only the blocks the region overlaps are looked at
+        const int blockSize = FieldBlockRanges::kBlockSize;
+        activeBlocks_.assign(blocks->blockCount(), 0);
+        for (int bz = region.z0 / blockSize; bz <= (region.z1 - 1) / blockSize; ++bz)
+            for (int by = region.y0 / blockSize; by <= (region.y1 - 1) / blockSize; ++by)
+                for (int bx = region.x0 / blockSize; bx <= (region.x1 - 1) / blockSize; ++bx)
+                {
+                    const std::size_t block = blocks->blockIndex(bx, by, bz);
+                    activeBlocks_[block] = blocks->mayCross(block, isoLevel) ? 1 : 0;
+                }
+        activeBlocksX_ = blocks->blocksX();
+        activeBlocksY_ = blocks->blocksY();
+    }
+
+    // A few slabs per thread so a slab crossing lots of surface does not hold up the rest
+    const int layers = region.z1 - region.z0;
+    const int threads = pool ? static_cast<int>(pool->getThreadCount()) : 1;
+    const int slabCount = std::max(1, std::min(layers, threads > 1 ? threads * 4 : 1));
+    if (slabs_.size() < static_cast<std::size_t>(slabCount))
+        slabs_.resize(slabCount);
+    for (int i = 0; i < slabCount; ++i)
+    {
+        slabs_[i].cubes = region;
+        slabs_[i].cubes.z0 = region.z0 + static_cast<int>(static_cast<long long>(layers) * i / slabCount);
+        slabs_[i].cubes.z1 = region.z0 + static_cast<int>(static_cast<long long>(layers) * (i + 1) / slabCount);
+        slabs_[i].bottomFromBelow = i > 0 || bottomFromBelow;
+    }
+    topSlab_ = slabCount - 1;
+
+    if (slabCount == 1)
+    {
+        // Serial: march straight into the output buffers
+        vertices_.swap(slabs_[0].vertices);
+        indices_.swap(slabs_[0].indices);
+        marchSlab(field, isoLevel, slabs_[0]);
+        vertices_.swap(slabs_[0].vertices);
+        indices_.swap(slabs_[0].indices);
+        topSlabBase_ = 0;
+        return;
+    }
+
+    pool->parallelFor(0, slabCount, 1, [&](int first, int last) {
+        for (int i = first; i < last; ++i)
+            marchSlab(field, isoLevel, slabs_[i]);
+    });
+    stitchSlabs(static_cast<std::size_t>(slabCount), pool);
+    topSlabBase_ = vertices_.size() - slabs_[topSlab_].vertices.size();
+}
+
+void CubeMarching::marchSlab(const ScalarFieldView& field, float isoLevel, SlabMesh& slab) const
+{
+    if (caseKernel_ == CaseKernel::Packed)
+        marchSlabWith<CaseKernel::Packed>(field, isoLevel, slab);
+    else
+        marchSlabWith<CaseKernel::TableScan>(field, isoLevel, slab);
+}
+
+template <CaseKernel Kernel>
+void CubeMarching::marchSlabWith(const ScalarFieldView& field, float isoLevel, SlabMesh& slab) const
+{
+    slab.vertices.clear();
+    slab.indices.clear();
+    const BlockMask blockMask{ activeBlocks_.data(), activeBlocksX_, activeBlocksY_ };
+    const BlockMask* mask = activeBlocks_.empty() ? nullptr : &blockMask;
+
+    if (meshMode_ == MeshMode::FlatShaded)
+    {
+        const float gridSizeX = static_cast<float>(field.sizeX - 1);
+        const float gridSizeY = static_cast<float>(field.sizeY - 1);
+        marchLayers(field, isoLevel, slab.cubes, mask,
+                    [&](const float (&cubeValues)[GridCell::CornerCount], int cubeIndex, int x, int y, int z) {
+                        emitCube<Kernel>(slab, cubeValues, cubeIndex, x, y, z, gridSizeX, gridSizeY, isoLevel);
+                    });
+        return;
+    }
+
+    EdgeCache& edges = slab.edges;
+    // Edge planes cover the samples of the region's cube rows: (x1 - x0 + 1) x (y1 - y0 + 1)
+    const CubeRegion& cubes = slab.cubes;
+    const std::size_t planeSize = static_cast<std::size_t>(cubes.x1 - cubes.x0 + 1) * (cubes.y1 - cubes.y0 + 1);
+    for (int layer = 0; layer < 2; ++layer)
+    {
+        edges.x[layer].assign(planeSize, -1);
+        edges.y[layer].assign(planeSize, -1);
+    }
+    edges.z.assign(planeSize, -1);
+
+    for (int z = cubes.z0; z < cubes.z1; ++z)
+    {
+        // The old top slice is the new bottom slice; its edges keep their vertices
+        if (z > cubes.z0)
+        {
+            std::swap(edges.x[0], edges.x[1]);
+            std::swap(edges.y[0], edges.y[1]);
+            std::fill(edges.x[1].begin(), edges.x[1].end(), -1);
+            std::fill(edges.y[1].begin(), edges.y[1].end(), -1);
+            std::fill(edges.z.begin(), edges.z.end(), -1);
+        }
+        CubeRegion layer = cubes;
+        layer.z0 = z;
+        layer.z1 = z + 1;
+        marchLayers(field, isoLevel, layer, mask,
+                    [&](const float (&cubeValues)[GridCell::CornerCount], int cubeIndex, int x, int y, int cz) {
+                        emitCubeShared<Kernel>(slab, field, cubeValues, cubeIndex, x, y, cz, isoLevel);
+                    });
+    }
+}
+
+void CubeMarching::stitchSlabs(std::size_t slabCount, WorkStealingPool* pool)
+{
+    // Prefix sums of the slab sizes give every slab its place in the serial order
+    std::vector<std::size_t> vertexBase(slabCount + 1, 0);
+    std::vector<std::size_t> indexBase(slabCount + 1, 0);
+    for (std::size_t i = 0; i < slabCount; ++i)
+    {
+        vertexBase[i + 1] = vertexBase[i] + slabs_[i].vertices.size();
+        indexBase[i + 1] = indexBase[i] + slabs_[i].indices.size();
+    }
+    vertices_.resize(vertexBase[slabCount]);
+    indices_.resize(indexBase[slabCount]);
+
+    pool->parallelFor(0, static_cast<int>(slabCount), 1, [&](int first, int last) {
+        for (int i = first; i < last; ++i)
+        {
+            const SlabMesh& slab = slabs_[i];
+            std::copy(slab.vertices.begin(), slab.vertices.end(), vertices_.begin() + vertexBase[i]);
+
+            const int base = static_cast<int>(vertexBase[i]);
+            int* out = indices_.data() + indexBase[i];
+            for (const int index : slab.indices)
+            {
+                if (index >= 0)
+                {
+                    *out++ = base + index;
+                    continue;
+                }
+                // The first slab's bottom slice is left to the caller (setBottomFromBelow)
+                if (i == 0)
+                {
+                    *out++ = index;
+                    continue;
+                }
+                // Bottom-slice edge owned by the slab below (SharedVertices only)
+                const int key = -2 - index;
+                const std::size_t cell = static_cast<std::size_t>(key / 2);
+                const EdgeCache& below = slabs_[i - 1].edges;
+                const int local = (key % 2 == 0) ? below.x[1][cell] : below.y[1][cell];
+                *out++ = static_cast<int>(vertexBase[i - 1]) + local;
+            }
+        }
+    });
+}
+
+template <CaseKernel Kernel>
+void CubeMarching::emitCube(SlabMesh& slab, const float (&cubeValues)[GridCell::CornerCount], int cubeIndex,
+                            int x, int y, int z, float gridSizeX, float gridSizeY, float isoLevel)
+{
+    // Corner offsets in the same order as processSingleCube's cubeVertices
+    static const int cornerOffset[GridCell::CornerCount][3] = {
+        {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+        {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+    };
+
+    // Only the crossed edges are filled in; the same arithmetic as interpolateVertices
+    Vertex edgeVertices[12];
+    auto interpolate = [&](int i) {
+        const int c1 = edgeToVertices[i].first;
+        const int c2 = edgeToVertices[i].second;
+        const float val1 = cubeValues[c1];
+        const float val2 = cubeValues[c2];
+        const float denom = val2 - val1;
+
+        float mu = 0.0f;
+        if (std::fabs(denom) > 1e-8f)
+            mu = (isoLevel - val1) / denom;
+
+        const int* o1 = cornerOffset[c1];
+        const int* o2 = cornerOffset[c2];
+        const glm::vec3 p1(x + o1[0], y + o1[1], z + o1[2]);
+        const glm::vec3 p2(x + o2[0], y + o2[1], z + o2[2]);
+        const glm::vec2 t1((x + o1[0]) / gridSizeX, (y + o1[1]) / gridSizeY);
+        const glm::vec2 t2((x + o2[0]) / gridSizeX, (y + o2[1]) / gridSizeY);
+
+        edgeVertices[i].Position = p1 + mu * (p2 - p1);
+        edgeVertices[i].Normal = glm::vec3(0.0f);
+        edgeVertices[i].TexCoords = t1 + mu * (t2 - t1);
+    };
+
+    auto emitTriangle = [&](int e0, int e1, int e2) {
+        Vertex vert0 = edgeVertices[e0];
+        Vertex vert1 = edgeVertices[e1];
+        Vertex vert2 = edgeVertices[e2];
+
+        const glm::vec3 faceNormal = calculateFaceNormal(vert0, vert1, vert2);
+        vert0.Normal = faceNormal;
+        vert1.Normal = faceNormal;
+        vert2.Normal = faceNormal;
+
+        const int baseVertexIndex = static_cast<int>(slab.vertices.size());
+        slab.vertices.push_back(vert0);
+        slab.vertices.push_back(vert1);
+        slab.vertices.push_back(vert2);
+
+        slab.indices.push_back(baseVertexIndex);
+        slab.indices.push_back(baseVertexIndex + 1);
+        slab.indices.push_back(baseVertexIndex + 2);
+    };
+
+    if constexpr (Kernel == CaseKernel::Packed)
+    {
+        const MarchingCase& packed = kMarchingCases[cubeIndex];
+        for (int k = 0; k < packed.edgeCount; ++k)
+            interpolate(packed.edges[k]);
+        const unsigned char* triangles = packed.triangles;
+        for (int t = 0; t < packed.triangleCount; ++t, triangles += 3)
+            emitTriangle(triangles[0], triangles[1], triangles[2]);
+    }
+    else
+    {
+        const int intersectionsKey = edgeTable[cubeIndex];
+        for (int i = 0; i < 12; ++i)
+            if (intersectionsKey & (1 << i)) interpolate(i);
+        const int* triangles = triTable[cubeIndex];
+        for (int i = 0; triangles[i] != -1; i += 3)
+            emitTriangle(triangles[i], triangles[i + 1], triangles[i + 2]);
+    }
+}
+
+// Field gradient at a grid point: central differences inside, one-sided on the border.
+static glm::vec3 fieldGradient(const ScalarFieldView& field, int x, int y, int z)
+{
+    const int x0 = x > 0 ? x - 1 : x, x1 = x + 1 < field.sizeX ? x + 1 : x;
+    const int y0 = y > 0 ? y - 1 : y, y1 = y + 1 < field.sizeY ? y + 1 : y;
+    const int z0 = z > 0 ? z - 1 : z, z1 = z + 1 < field.sizeZ ? z + 1 : z;
+    return glm::vec3((field.at(x1, y, z) - field.at(x0, y, z)) / static_cast<float>(x1 - x0),
+                     (field.at(x, y1, z) - field.at(x, y0, z)) / static_cast<float>(y1 - y0),
+                     (field.at(x, y, z1) - field.at(x, y, z0)) / static_cast<float>(z1 - z0));
+}
+
+// Each cube edge as (axis, offset of its lower grid point, lower corner, upper corner).
+// Vertices are always interpolated from the lower point so neighbouring cubes agree.
+struct CubeEdge {
+    int axis;
+    int dx, dy, dz;
+    int low, high;
+};
+static const CubeEdge kCubeEdges[12] = {
+    {0, 0, 0, 0, 0, 1}, {1, 1, 0, 0, 1, 2}, {0, 0, 1, 0, 3, 2}, {1, 0, 0, 0, 0, 3},
+    {0, 0, 0, 1, 4, 5}, {1, 1, 0, 1, 5, 6}, {0, 0, 1, 1, 7, 6}, {1, 0, 0, 1, 4, 7},
+    {2, 0, 0, 0, 0, 4}, {2, 1, 0, 0, 1, 5}, {2, 1, 1, 0, 2, 6}, {2, 0, 1, 0, 3, 7}
+};
+
+int CubeMarching::edgeVertex(SlabMesh& slab, const ScalarFieldView& field, int axis, int x, int y, int z,
+                             float lowValue, float highValue, float isoLevel)
+{
+    const float denom = highValue - lowValue;
+    float mu = 0.0f;
+    if (std::fabs(denom) > 1e-8f)
+        mu = (isoLevel - lowValue) / denom;
+
+    const int hx = x + (axis == 0), hy = y + (axis == 1), hz = z + (axis == 2);
+    const glm::vec3 p1(x, y, z);
+    const glm::vec3 p2(hx, hy, hz);
+    const float gridSizeX = static_cast<float>(field.sizeX - 1);
+    const float gridSizeY = static_cast<float>(field.sizeY - 1);
+    const glm::vec2 t1(x / gridSizeX, y / gridSizeY);
+    const glm::vec2 t2(hx / gridSizeX, hy / gridSizeY);
+
+    // The triangle tables wind faces towards falling field values, so the normal is the
+    // negated gradient; it then faces the same side as the flat-shaded face normals
+    glm::vec3 normal = -glm::mix(fieldGradient(field, x, y, z), fieldGradient(field, hx, hy, hz), mu);
+    const float length = glm::length(normal);
+    normal = length > 1e-8f ? normal / length : glm::vec3(0.0f);
+
+    Vertex vertex;
+    vertex.Position = p1 + mu * (p2 - p1);
+    vertex.Normal = normal;
+    vertex.TexCoords = t1 + mu * (t2 - t1);
+    slab.vertices.push_back(vertex);
+    return static_cast<int>(slab.vertices.size() - 1);
+}
+
+template <CaseKernel Kernel>
+void CubeMarching::emitCubeShared(SlabMesh& slab, const ScalarFieldView& field,
+                                  const float (&cubeValues)[GridCell::CornerCount],
+                                  int cubeIndex, int x, int y, int z, float isoLevel)
+{
+    // Bottom-slice x/y edges of a stacked slab belong to the slab below
+    const bool bottomOwnedBelow = slab.bottomFromBelow && z == slab.cubes.z0;
+    const int cacheWidth = slab.cubes.x1 - slab.cubes.x0 + 1;
+
+    int edgeIndex[12];
+    auto lookUp = [&](int i) {
+        const CubeEdge& edge = kCubeEdges[i];
+        const int ex = x + edge.dx, ey = y + edge.dy;
+        const std::size_t cell = static_cast<std::size_t>(ey - slab.cubes.y0) * cacheWidth + (ex - slab.cubes.x0);
+        int* slot = edge.axis == 2 ? &slab.edges.z[cell]
+                  : edge.axis == 0 ? &slab.edges.x[edge.dz][cell]
+                                   : &slab.edges.y[edge.dz][cell];
+        if (*slot == -1)
+        {
+            if (bottomOwnedBelow && edge.axis != 2 && edge.dz == 0)
+                *slot = -2 - static_cast<int>(cell * 2 + edge.axis);
+            else
+                *slot = edgeVertex(slab, field, edge.axis, ex, ey, z + edge.dz,
+                                   cubeValues[edge.low], cubeValues[edge.high], isoLevel);
+        }
+        edgeIndex[i] = *slot;
+    };
+
+    if constexpr (Kernel == CaseKernel::Packed)
+    {
+        const MarchingCase& packed = kMarchingCases[cubeIndex];
+        for (int k = 0; k < packed.edgeCount; ++k)
+            lookUp(packed.edges[k]);
+        const int triangleIndices = packed.triangleCount * 3;
+        for (int i = 0; i < triangleIndices; ++i)
+            slab.indices.push_back(edgeIndex[packed.triangles[i]]);
+    }
+    else
+    {
+        const int intersectionsKey = edgeTable[cubeIndex];
+        for (int i = 0; i < 12; ++i)
+            if (intersectionsKey & (1 << i)) lookUp(i);
+        const int* triangles = triTable[cubeIndex];
+        for (int i = 0; triangles[i] != -1; i += 3)
+        {
+            slab.indices.push_back(edgeIndex[triangles[i]]);
+            slab.indices.push_back(edgeIndex[triangles[i + 1]]);
+            slab.indices.push_back(edgeIndex[triangles[i + 2]]);
+        }
+    }
+}
+
 void CubeMarching::clearMesh()
 {
     vertices_.clear();
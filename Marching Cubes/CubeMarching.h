@@ -9,6 +9,9 @@
 #include <array>
 #include <cstddef>
 #include "../mesh.h"
+#include "ScalarField.h"
+
+class WorkStealingPool;
 
 // Grid cell: 8 corner vertices and their scalar values
 struct GridCell {
@@ -17,6 +20,39 @@ struct GridCell {
     std::array<float, CornerCount> value{};   // corner scalar values
 };
 
+// How generateMesh lays out its output.
+// FlatShaded: three vertices per triangle with the face normal, indices 0..n-1.
+// SharedVertices: one vertex per crossed grid edge, shared by every triangle that uses
+// it, with a smooth normal from the field gradient.
+enum class MeshMode {
+    FlatShaded,
+    SharedVertices
+};
+
+// How the flat-field paths read a cube's case.
+// Packed: a table built from tables.h at compile time lists each case's crossed edges
+// and triangle count, so the hot loop runs fixed-count loops with no per-edge test and
+// no scan for triTable's -1 terminator.
+// TableScan: the original edgeTable bit tests and triTable scan, kept for comparison.
+// Both give the same mesh.
+enum class CaseKernel {
+    Packed,
+    TableScan
+};
+
+// Half-open box of cubes [x0, x1) x [y0, y1) x [z0, z1); cube (x, y, z) spans samples
+// x..x+1, y..y+1, z..z+1.
+struct CubeRegion {
+    int x0 = 0, y0 = 0, z0 = 0;
+    int x1 = 0, y1 = 0, z1 = 0;
+
+    static CubeRegion wholeField(const ScalarFieldView& field)
+    {
+        return { 0, 0, 0, field.sizeX - 1, field.sizeY - 1, field.sizeZ - 1 };
+    }
+    bool empty() const { return x0 >= x1 || y0 >= y1 || z0 >= z1; }
+};
+
 // CubeMarching: compute cube index, interpolate edge intersections and
 // produce triangle lists for a single cube or a full scalar field.
 class CubeMarching {
@@ -54,8 +90,30 @@ public:
     std::vector<std::array<int,3>> triangulateField(const std::vector<std::vector<std::vector<float>>>& scalarField,
                                                     float isoLevel) const;
 
-    // Generate mesh (vertices + indices) for the field and store internally.
-    void generateMesh(const std::vector<std::vector<std::vector<float>>>& scalarField, float isoLevel);
+    // Generate mesh (vertices + indices) for the field and store internally. In
+    // SharedVertices mode, or with a pool, the field is copied into a flat buffer first.
+    void generateMesh(const std::vector<std::vector<std::vector<float>>>& scalarField, float isoLevel,
+                      WorkStealingPool* pool = nullptr);
+
+    // Same mesh from a flat strided field. Walks two z-slices at a time, slides the
+    // corner values along x and only interpolates the edges a cube crosses, so nothing
+    // is allocated per cube. Output matches the nested overload vertex for vertex.
+    // With a pool, z-slabs are meshed in parallel into their own arenas and stitched in
+    // z order; the result is identical to the serial one for any thread count.
+    void generateMesh(const ScalarFieldView& field, float isoLevel, WorkStealingPool* pool = nullptr);
+
+    // As above, but skips every block of cubes whose min/max range (see FieldBlockRanges)
+    // does not straddle isoLevel. Build the ranges once per field and pass them on each
+    // iso change; the mesh is the same as without them. Ignored if built for another size.
+    void generateMesh(const ScalarFieldView& field, float isoLevel, const FieldBlockRanges& blocks,
+                      WorkStealingPool* pool = nullptr);
+
+    // Mesh only the cubes of `region` (clamped to the field). Positions, texture
+    // coordinates and gradient normals are those of the whole-field mesh, so meshes of
+    // neighbouring regions line up; shared vertices are not shared across regions.
+    // Block ranges, when given and built for this field, skip empty blocks as above.
+    void generateRegion(const ScalarFieldView& field, float isoLevel, const CubeRegion& region,
+                        const FieldBlockRanges* blocks = nullptr, WorkStealingPool* pool = nullptr);
 
     // Stepwise processing helpers
     void clearMesh();
@@ -64,6 +122,26 @@ public:
     void processUpToCell(const std::vector<std::vector<std::vector<float>>>& scalarField,
                         int maxX, int maxY, int maxZ, float isoLevel);
 
+    // Output layout of generateMesh; the stepwise helpers are always flat shaded.
+    void setMeshMode(MeshMode mode) { meshMode_ = mode; }
+    MeshMode getMeshMode() const { return meshMode_; }
+
+    // SharedVertices seam between regions stacked in z, meshed one after another. With
+    // this set, generateRegion does not create the x/y edge vertices of the region's bottom
+    // slice: its indices refer to them as -2 - (cell * 2 + axis), cell being
+    // (y - y0) * (x1 - x0 + 1) + (x - x0), and the caller resolves them with
+    // getTopSliceVertex of the region below.
+    void setBottomFromBelow(bool fromBelow) { bottomFromBelow_ = fromBelow; }
+    bool getBottomFromBelow() const { return bottomFromBelow_; }
+
+    // SharedVertices only: mesh vertex on the x/y edge of the last region's top slice with
+    // key cell * 2 + axis (as above), or -1 if the surface does not cross it.
+    int getTopSliceVertex(std::size_t key) const;
+
+    // Case lookup of the flat-field paths (see CaseKernel)
+    void setCaseKernel(CaseKernel kernel) { caseKernel_ = kernel; }
+    CaseKernel getCaseKernel() const { return caseKernel_; }
+
     void setIsoLevel(float isoLevel) { isoLevel_ = isoLevel; }
     float getIsoLevel() const { return isoLevel_; }
 
@@ -73,8 +151,62 @@ public:
     std::size_t getTriangleCount() const { return indices_.size() / 3; }
 
 private:
+    // SharedVertices edge caches over the samples of a region's cube rows, indexed
+    // (y - y0) * (x1 - x0 + 1) + (x - x0) (-1 = no vertex yet). x/y edges are kept for the
+    // bottom [0] and top [1] slice of the current cube layer, z edges for the layer itself.
+    struct EdgeCache {
+        std::vector<int> x[2];
+        std::vector<int> y[2];
+        std::vector<int> z;
+    };
+
+    // Vertices and indices of the cubes in `cubes`, with indices local to the slab. In
+    // SharedVertices mode a slab stacked on another (bottomFromBelow) does not recreate
+    // the x/y edge vertices of its bottom slice: it refers to them as
+    // -2 - (cell * 2 + axis) and stitching looks them up in the top-slice cache of the
+    // slab below. Cache cells are relative to the region's corner.
+    struct SlabMesh {
+        CubeRegion cubes;
+        bool bottomFromBelow = false;
+        std::vector<Vertex> vertices;
+        std::vector<int> indices;
+        EdgeCache edges;
+    };
+
+    void generateMeshImpl(const ScalarFieldView& field, float isoLevel, const CubeRegion& region,
+                          const FieldBlockRanges* blocks, WorkStealingPool* pool, bool bottomFromBelow);
+    void marchSlab(const ScalarFieldView& field, float isoLevel, SlabMesh& slab) const;
+    template <CaseKernel Kernel>
+    void marchSlabWith(const ScalarFieldView& field, float isoLevel, SlabMesh& slab) const;
+    void stitchSlabs(std::size_t slabCount, WorkStealingPool* pool);
+
+    // Append the triangles of one active cube at (x, y, z) from its corner values.
+    template <CaseKernel Kernel>
+    static void emitCube(SlabMesh& slab, const float (&cubeValues)[GridCell::CornerCount], int cubeIndex,
+                         int x, int y, int z, float gridSizeX, float gridSizeY, float isoLevel);
+
+    // SharedVertices counterpart of emitCube: looks crossed edges up in the slice caches
+    // and only creates the vertices no neighbouring cube has made yet.
+    template <CaseKernel Kernel>
+    static void emitCubeShared(SlabMesh& slab, const ScalarFieldView& field,
+                               const float (&cubeValues)[GridCell::CornerCount],
+                               int cubeIndex, int x, int y, int z, float isoLevel);
+    static int edgeVertex(SlabMesh& slab, const ScalarFieldView& field, int axis, int x, int y, int z,
+                          float lowValue, float highValue, float isoLevel);
+
     float isoLevel_{0.0f};
+    MeshMode meshMode_{MeshMode::FlatShaded};
+    CaseKernel caseKernel_{CaseKernel::Packed};
+    bool bottomFromBelow_{false};
     std::vector<Vertex> vertices_{}; // generated vertices with normals built-in
     std::vector<int> indices_{};     // flattened triangle indices (triples)
+    std::vector<SlabMesh> slabs_{};  // per-slab arenas, reused across calls
+    int topSlab_{-1};                // slab holding the last region's top slice, -1 = none
+    std::size_t topSlabBase_{0};     // its first vertex in vertices_
+
+    // Per-call block mask (1 = may hold surface) and its block grid; empty = march all
+    std::vector<unsigned char> activeBlocks_{};
+    int activeBlocksX_{0};
+    int activeBlocksY_{0};
 };
 #endif // CUBEMARCHING_H
@@ -0,0 +1,152 @@
+#include "MappedVolume.h"
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedVolume::~MappedVolume()
+{
+    close();
+}
+
+bool MappedVolume::isOpen() const
+{
+#ifdef _WIN32
+    return mapping_ != nullptr;
+#else
+    return fd_ >= 0;
+#endif
+}
+
+bool MappedVolume::open(const std::string& path, int sizeX, int sizeY, int sizeZ)
+{
+    close();
+    if (sizeX < 1 || sizeY < 1 || sizeZ < 1)
+    {
+        std::cerr << "Invalid volume size " << sizeX << "x" << sizeY << "x" << sizeZ << std::endl;
+        return false;
+    }
+    const std::uint64_t needed = static_cast<std::uint64_t>(sizeX) * sizeY * sizeZ * sizeof(float);
+    std::uint64_t fileBytes = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Volume not found: " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size)) fileBytes = static_cast<std::uint64_t>(size.QuadPart);
+    HANDLE mapping = fileBytes >= needed ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    if (!mapping)
+    {
+        CloseHandle(file);
+        std::cerr << (fileBytes < needed ? "Volume file too small: " : "Cannot map volume: ") << path << std::endl;
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Volume not found: " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0) fileBytes = static_cast<std::uint64_t>(info.st_size);
+    if (fileBytes < needed)
+    {
+        ::close(fd);
+        std::cerr << "Volume file too small: " << path << " (" << fileBytes << " of " << needed << " bytes)" << std::endl;
+        return false;
+    }
+    fd_ = fd;
+#endif
+
+    sizeX_ = sizeX;
+    sizeY_ = sizeY;
+    sizeZ_ = sizeZ;
+    path_ = path;
+    return true;
+}
+
+void MappedVolume::close()
+{
+    unmapWindow();
+#ifdef _WIN32
+    if (mapping_) CloseHandle(static_cast<HANDLE>(mapping_));
+    if (file_) CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+#endif
+    sizeX_ = sizeY_ = sizeZ_ = 0;
+}
+
+ScalarFieldView MappedVolume::mapSlices(int z0, int z1)
+{
+    unmapWindow();
+    if (!isOpen() || z0 < 0 || z1 >= sizeZ_ || z0 > z1) return ScalarFieldView();
+
+    // Views must start on an allocation boundary; map from there and skip the lead-in
+#ifdef _WIN32
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    const std::uint64_t granularity = system.dwAllocationGranularity;
+#else
+    const std::uint64_t granularity = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+    const std::uint64_t begin = static_cast<std::uint64_t>(z0) * sliceBytes();
+    const std::uint64_t end = static_cast<std::uint64_t>(z1 + 1) * sliceBytes();
+    const std::uint64_t alignedBegin = begin - begin % granularity;
+    const std::size_t bytes = static_cast<std::size_t>(end - alignedBegin);
+
+#ifdef _WIN32
+    void* window = MapViewOfFile(static_cast<HANDLE>(mapping_), FILE_MAP_READ,
+                                 static_cast<DWORD>(alignedBegin >> 32), static_cast<DWORD>(alignedBegin), bytes);
+    if (!window)
+    {
+        std::cerr << "Cannot map slices " << z0 << ".." << z1 << " of " << path_ << std::endl;
+        return ScalarFieldView();
+    }
+#else
+    void* window = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd_, static_cast<off_t>(alignedBegin));
+    if (window == MAP_FAILED)
+    {
+        std::cerr << "Cannot map slices " << z0 << ".." << z1 << " of " << path_ << std::endl;
+        return ScalarFieldView();
+    }
+    madvise(window, bytes, MADV_SEQUENTIAL);
+#endif
+    window_ = window;
+    windowBytes_ = bytes;
+
+    const float* first = reinterpret_cast<const float*>(static_cast<const char*>(window) + (begin - alignedBegin));
+    return ScalarFieldView::dense(first, sizeX_, sizeY_, z1 - z0 + 1);
+}
+
+void MappedVolume::unmapWindow()
+{
+    if (!window_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(window_);
+#else
+    munmap(window_, windowBytes_);
+#endif
+    window_ = nullptr;
+    windowBytes_ = 0;
+}
@@ -0,0 +1,52 @@
+#ifndef MAPPEDVOLUME_H
+#define MAPPEDVOLUME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "ScalarField.h"
+
+// Read-only memory map of a raw float32 volume on disk: sizeX * sizeY * sizeZ native
+// floats, x fastest, then y, then z (the dense ScalarFieldView layout). Only a window
+// of whole z-slices is mapped at a time, so address space and resident pages stay
+// bounded by the window, not the file.
+class MappedVolume {
+public:
+    MappedVolume() = default;
+    ~MappedVolume();
+
+    MappedVolume(const MappedVolume&) = delete;
+    MappedVolume& operator=(const MappedVolume&) = delete;
+
+    // Open `path` as a volume of the given size; false (with a message on std::cerr)
+    // if it cannot be opened or is smaller than the volume.
+    bool open(const std::string& path, int sizeX, int sizeY, int sizeZ);
+    void close();
+    bool isOpen() const;
+
+    int sizeX() const { return sizeX_; }
+    int sizeY() const { return sizeY_; }
+    int sizeZ() const { return sizeZ_; }
+    std::uint64_t sliceBytes() const { return static_cast<std::uint64_t>(sizeX_) * sizeY_ * sizeof(float); }
+
+    // Map slices z0..z1 (inclusive) in place of the previous window and view them as a
+    // field of z1 - z0 + 1 slices. The view stays valid until the next call or close().
+    // Returns an empty view on failure.
+    ScalarFieldView mapSlices(int z0, int z1);
+    std::size_t mappedBytes() const { return windowBytes_; }
+    void unmapWindow(); // drop the current window; views of it become invalid
+
+private:
+    int sizeX_ = 0, sizeY_ = 0, sizeZ_ = 0;
+    std::string path_;
+#ifdef _WIN32
+    void* file_ = nullptr;    // HANDLE
+    void* mapping_ = nullptr; // HANDLE
+#else
+    int fd_ = -1;
+#endif
+    void* window_ = nullptr;  // start of the mapped pages (aligned down from slice z0)
+    std::size_t windowBytes_ = 0;
+};
+
+#endif // MAPPEDVOLUME_H
@@ -0,0 +1,135 @@
+#include "MeshSink.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+PlyMeshSink::~PlyMeshSink()
+{
+    if (faces_.is_open())
+    {
+        faces_.close();
+        std::remove((path_ + ".faces").c_str());
+    }
+}
+
+bool PlyMeshSink::open(const std::string& path)
+{
+    path_ = path;
+    vertexCount_ = triangleCount_ = 0;
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    faces_.open(path + ".faces", std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    if (!out_.is_open() || !faces_.is_open())
+    {
+        std::cerr << "Cannot write PLY: " << path << std::endl;
+        return false;
+    }
+    writeHeader();
+    return true;
+}
+
+void PlyMeshSink::writeHeader()
+{
+    // Counts are padded to a fixed width so finish() can rewrite them in place
+    char counts[2][32];
+    std::snprintf(counts[0], sizeof(counts[0]), "%20llu", static_cast<unsigned long long>(vertexCount_));
+    std::snprintf(counts[1], sizeof(counts[1]), "%20llu", static_cast<unsigned long long>(triangleCount_));
+    out_ << "ply\n"
+         << "format binary_little_endian 1.0\n"
+         << "element vertex " << counts[0] << "\n"
+         << "property float x\nproperty float y\nproperty float z\n"
+         << "property float nx\nproperty float ny\nproperty float nz\n"
+         << "property float s\nproperty float t\n"
+         << "element face " << counts[1] << "\n"
+         << "property list uchar int vertex_indices\n"
+         << "end_header\n";
+}
+
+void PlyMeshSink::addVertex(const Vertex& vertex)
+{
+    const float values[8] = { vertex.Position.x, vertex.Position.y, vertex.Position.z,
+                              vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+                              vertex.TexCoords.x, vertex.TexCoords.y };
+    out_.write(reinterpret_cast<const char*>(values), sizeof(values));
+    ++vertexCount_;
+}
+
+void PlyMeshSink::addTriangle(int a, int b, int c)
+{
+    // uchar 3 followed by three int32, 13 bytes
+    char face[13];
+    face[0] = 3;
+    const int indices[3] = { a, b, c };
+    std::memcpy(face + 1, indices, sizeof(indices));
+    faces_.write(face, sizeof(face));
+    ++triangleCount_;
+}
+
+bool PlyMeshSink::finish()
+{
+    faces_.flush();
+    faces_.seekg(0);
+    std::vector<char> buffer(1 << 20);
+    while (faces_)
+    {
+        faces_.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        out_.write(buffer.data(), faces_.gcount());
+    }
+    faces_.close();
+    std::remove((path_ + ".faces").c_str());
+
+    out_.seekp(0);
+    writeHeader();
+    out_.close();
+    if (!out_)
+    {
+        std::cerr << "Failed writing PLY: " << path_ << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ObjMeshSink::open(const std::string& path)
+{
+    path_ = path;
+    vertexCount_ = triangleCount_ = 0;
+    out_.open(path, std::ios::trunc);
+    if (!out_.is_open())
+    {
+        std::cerr << "Cannot write OBJ: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ObjMeshSink::addVertex(const Vertex& vertex)
+{
+    char line[192];
+    const int length = std::snprintf(line, sizeof(line), "v %.9g %.9g %.9g\nvn %.6g %.6g %.6g\nvt %.6g %.6g\n",
+                                     vertex.Position.x, vertex.Position.y, vertex.Position.z,
+                                     vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+                                     vertex.TexCoords.x, vertex.TexCoords.y);
+    out_.write(line, length);
+    ++vertexCount_;
+}
+
+void ObjMeshSink::addTriangle(int a, int b, int c)
+{
+    // OBJ indices start at 1
+    char line[96];
+    const int length = std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                                     a + 1, a + 1, a + 1, b + 1, b + 1, b + 1, c + 1, c + 1, c + 1);
+    out_.write(line, length);
+    ++triangleCount_;
+}
+
+bool ObjMeshSink::finish()
+{
+    out_.close();
+    if (!out_)
+    {
+        std::cerr << "Failed writing OBJ: " << path_ << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef MESHSINK_H
+#define MESHSINK_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "../mesh.h"
+
+// Destination for a mesh produced a piece at a time. Vertices are numbered in the order
+// they are added, from 0; a triangle may only use vertices already added.
+class MeshSink {
+public:
+    virtual ~MeshSink() = default;
+
+    virtual void addVertex(const Vertex& vertex) = 0;
+    virtual void addTriangle(int a, int b, int c) = 0;
+
+    // Complete the output; false (with a message on std::cerr) if writing failed.
+    virtual bool finish() = 0;
+
+    std::uint64_t vertexCount() const { return vertexCount_; }
+    std::uint64_t triangleCount() const { return triangleCount_; }
+
+protected:
+    std::uint64_t vertexCount_ = 0;
+    std::uint64_t triangleCount_ = 0;
+};
+
+// Binary little-endian PLY: x y z nx ny nz s t per vertex, int triangles. PLY wants all
+// vertices before any face, so faces are spilled to `<path>.faces` and appended by
+// finish(), which also fills in the counts left blank in the header.
+class PlyMeshSink : public MeshSink {
+public:
+    PlyMeshSink() = default;
+    ~PlyMeshSink() override;
+
+    bool open(const std::string& path);
+    void addVertex(const Vertex& vertex) override;
+    void addTriangle(int a, int b, int c) override;
+    bool finish() override;
+
+private:
+    void writeHeader();
+
+    std::string path_;
+    std::ofstream out_;
+    std::fstream faces_;
+};
+
+// Wavefront OBJ text: v / vn / vt per vertex and f a/a/a b/b/b c/c/c per triangle,
+// written as they arrive.
+class ObjMeshSink : public MeshSink {
+public:
+    bool open(const std::string& path);
+    void addVertex(const Vertex& vertex) override;
+    void addTriangle(int a, int b, int c) override;
+    bool finish() override;
+
+private:
+    std::string path_;
+    std::ofstream out_;
+};
+
+#endif // MESHSINK_H
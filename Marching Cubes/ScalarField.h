@@ -0,0 +1,148 @@
+#ifndef SCALARFIELD_H
+#define SCALARFIELD_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Read-only view of a flat 3D scalar field:
+// value(x, y, z) = data[x * strideX + y * strideY + z * strideZ] (strides in floats).
+// dense() describes the usual x-fastest layout, i.e. the same order as field[z][y][x].
+struct ScalarFieldView {
+    const float* data = nullptr;
+    int sizeX = 0;
+    int sizeY = 0;
+    int sizeZ = 0;
+    std::ptrdiff_t strideX = 1;
+    std::ptrdiff_t strideY = 0;
+    std::ptrdiff_t strideZ = 0;
+
+    static ScalarFieldView dense(const float* data, int sizeX, int sizeY, int sizeZ)
+    {
+        ScalarFieldView view;
+        view.data = data;
+        view.sizeX = sizeX;
+        view.sizeY = sizeY;
+        view.sizeZ = sizeZ;
+        view.strideX = 1;
+        view.strideY = sizeX;
+        view.strideZ = static_cast<std::ptrdiff_t>(sizeX) * sizeY;
+        return view;
+    }
+
+    float at(int x, int y, int z) const
+    {
+        return data[x * strideX + y * strideY + z * strideZ];
+    }
+
+    // Pointer to sample (0, y, z); step along x with strideX.
+    const float* row(int y, int z) const { return data + y * strideY + z * strideZ; }
+
+    // At least one cube in every direction
+    bool hasCubes() const { return data && sizeX > 1 && sizeY > 1 && sizeZ > 1; }
+};
+
+// Min/max summary of a field in blocks of kBlockSize^3 cubes. Each block's range also
+// covers the samples on its far faces, so it bounds every corner of its cubes. Build it
+// once per field and reuse it for any iso level: a block whose range does not straddle
+// the iso level holds no surface and the mesher skips it.
+class FieldBlockRanges {
+public:
+    static constexpr int kBlockSize = 8;
+
+    FieldBlockRanges() = default;
+    explicit FieldBlockRanges(const ScalarFieldView& field) { build(field); }
+
+    void build(const ScalarFieldView& field)
+    {
+        sizeX_ = field.sizeX;
+        sizeY_ = field.sizeY;
+        sizeZ_ = field.sizeZ;
+        blocksX_ = blocksFor(sizeX_);
+        blocksY_ = blocksFor(sizeY_);
+        blocksZ_ = blocksFor(sizeZ_);
+        const std::size_t count = static_cast<std::size_t>(blocksX_) * blocksY_ * blocksZ_;
+        minValue_.assign(count, 0.0f);
+        maxValue_.assign(count, 0.0f);
+        if (!field.hasCubes()) return;
+
+        for (int bz = 0; bz < blocksZ_; ++bz)
+            for (int by = 0; by < blocksY_; ++by)
+                for (int bx = 0; bx < blocksX_; ++bx)
+                    summarize(field, bx, by, bz);
+    }
+
+    // Recompute the blocks whose samples include any in [min, max] (inclusive), e.g.
+    // after a local edit. The field must have the dimensions it was built with.
+    void refresh(const ScalarFieldView& field, int minX, int minY, int minZ, int maxX, int maxY, int maxZ)
+    {
+        if (!covers(field)) return;
+        // Sample s lies in blocks (s - 1) / kBlockSize and s / kBlockSize
+        const int bx0 = std::max(0, (minX - 1) / kBlockSize), bx1 = std::min(blocksX_ - 1, maxX / kBlockSize);
+        const int by0 = std::max(0, (minY - 1) / kBlockSize), by1 = std::min(blocksY_ - 1, maxY / kBlockSize);
+        const int bz0 = std::max(0, (minZ - 1) / kBlockSize), bz1 = std::min(blocksZ_ - 1, maxZ / kBlockSize);
+        for (int bz = bz0; bz <= bz1; ++bz)
+            for (int by = by0; by <= by1; ++by)
+                for (int bx = bx0; bx <= bx1; ++bx)
+                    summarize(field, bx, by, bz);
+    }
+
+    // Built for a field of these dimensions
+    bool covers(const ScalarFieldView& field) const
+    {
+        return !minValue_.empty() && field.sizeX == sizeX_ && field.sizeY == sizeY_ && field.sizeZ == sizeZ_;
+    }
+
+    int blocksX() const { return blocksX_; }
+    int blocksY() const { return blocksY_; }
+    int blocksZ() const { return blocksZ_; }
+    std::size_t blockCount() const { return minValue_.size(); }
+
+    // Index of the block holding cube (x, y, z) is blockIndex(x / kBlockSize, ...)
+    std::size_t blockIndex(int bx, int by, int bz) const
+    {
+        return (static_cast<std::size_t>(bz) * blocksY_ + by) * blocksX_ + bx;
+    }
+
+    // Cubes are crossed when some corner is below isoLevel and some is not
+    bool mayCross(std::size_t block, float isoLevel) const
+    {
+        return minValue_[block] < isoLevel && maxValue_[block] >= isoLevel;
+    }
+
+private:
+    static int blocksFor(int samples)
+    {
+        return samples > 1 ? (samples - 2) / kBlockSize + 1 : 0;
+    }
+
+    void summarize(const ScalarFieldView& field, int bx, int by, int bz)
+    {
+        const int x0 = bx * kBlockSize, x1 = std::min(x0 + kBlockSize, field.sizeX - 1);
+        const int y0 = by * kBlockSize, y1 = std::min(y0 + kBlockSize, field.sizeY - 1);
+        const int z0 = bz * kBlockSize, z1 = std::min(z0 + kBlockSize, field.sizeZ - 1);
+
+        float lo = field.at(x0, y0, z0), hi = lo;
+        for (int z = z0; z <= z1; ++z)
+            for (int y = y0; y <= y1; ++y)
+            {
+                const float* row = field.row(y, z);
+                for (int x = x0; x <= x1; ++x)
+                {
+                    const float value = row[x * field.strideX];
+                    lo = std::min(lo, value);
+                    hi = std::max(hi, value);
+                }
+            }
+        const std::size_t block = blockIndex(bx, by, bz);
+        minValue_[block] = lo;
+        maxValue_[block] = hi;
+    }
+
+    int sizeX_ = 0, sizeY_ = 0, sizeZ_ = 0;
+    int blocksX_ = 0, blocksY_ = 0, blocksZ_ = 0;
+    std::vector<float> minValue_;
+    std::vector<float> maxValue_;
+};
+
+#endif // SCALARFIELD_H
@@ -0,0 +1,79 @@
+#include "StreamingMarcher.h"
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+StreamingMarcher::StreamingMarcher(int slabLayers)
+    : slabLayers_(std::max(1, slabLayers))
+{
+}
+
+bool StreamingMarcher::march(MappedVolume& volume, float isoLevel, MeshSink& sink, WorkStealingPool* pool)
+{
+    stats_ = Stats();
+    seam_.clear();
+    const int cubesZ = volume.sizeZ() - 1;
+    if (volume.sizeX() < 2 || volume.sizeY() < 2 || cubesZ < 1) return true;
+    const bool shared = mesher_.getMeshMode() == MeshMode::SharedVertices;
+
+    for (int z0 = 0; z0 < cubesZ; z0 += slabLayers_)
+    {
+        const int z1 = std::min(z0 + slabLayers_, cubesZ);
+
+        // Samples z0..z1 are the slab's cube corners; one more each side for gradients
+        const int first = std::max(0, z0 - 1);
+        const int last = std::min(volume.sizeZ() - 1, z1 + 1);
+        const ScalarFieldView window = volume.mapSlices(first, last);
+        if (!window.data) return false;
+
+        CubeRegion cubes = CubeRegion::wholeField(window);
+        cubes.z0 = z0 - first;
+        cubes.z1 = z1 - first;
+        // Bottom-slice edges of every slab but the first come back as -2 - key
+        mesher_.setBottomFromBelow(shared && z0 > 0);
+        mesher_.generateRegion(window, isoLevel, cubes, nullptr, pool);
+
+        const std::vector<Vertex>& vertices = mesher_.getVertices();
+        const std::vector<int>& indices = mesher_.getIndices();
+        // Sinks take int vertex indices
+        if (sink.vertexCount() + vertices.size() > static_cast<std::uint64_t>(INT_MAX))
+        {
+            std::cerr << "Mesh exceeds " << INT_MAX << " vertices at slab z " << z0
+                      << "; use SharedVertices mode or split the volume" << std::endl;
+            volume.unmapWindow();
+            return false;
+        }
+        remap_.resize(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            Vertex vertex = vertices[i];
+            remap_[i] = static_cast<int>(sink.vertexCount());
+            vertex.Position.z += static_cast<float>(first);
+            sink.addVertex(vertex);
+        }
+        auto sinkIndex = [&](int index) {
+            return index >= 0 ? remap_[index] : seam_[static_cast<std::size_t>(-2 - index)];
+        };
+        for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+            sink.addTriangle(sinkIndex(indices[i]), sinkIndex(indices[i + 1]), sinkIndex(indices[i + 2]));
+
+        if (shared)
+        {
+            seam_.resize(static_cast<std::size_t>(window.sizeX) * window.sizeY * 2);
+            for (std::size_t key = 0; key < seam_.size(); ++key)
+            {
+                const int index = mesher_.getTopSliceVertex(key);
+                seam_[key] = index < 0 ? -1 : remap_[index];
+            }
+        }
+
+        ++stats_.slabs;
+        stats_.peakWindowBytes = std::max(stats_.peakWindowBytes, volume.mappedBytes());
+        stats_.peakMeshBytes = std::max(stats_.peakMeshBytes,
+                                        vertices.size() * sizeof(Vertex) + indices.size() * sizeof(int));
+    }
+    volume.unmapWindow();
+    stats_.vertices = sink.vertexCount();
+    stats_.triangles = sink.triangleCount();
+    return true;
+}
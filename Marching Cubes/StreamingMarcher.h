@@ -0,0 +1,57 @@
+#ifndef STREAMINGMARCHER_H
+#define STREAMINGMARCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CubeMarching.h"
+#include "MappedVolume.h"
+#include "MeshSink.h"
+
+class WorkStealingPool;
+
+// Out-of-core marching cubes: marches a MappedVolume one slab of cube layers at a time
+// and hands each slab's triangles to a MeshSink, so peak memory is one mapped window
+// plus one slab mesh whatever the volume size.
+//
+// Each window keeps one extra slice on both sides of its slab, so gradient normals
+// match the in-memory mesh. In SharedVertices mode the vertices on the plane between
+// two slabs are written once: the next slab refers to the grid edges of its bottom
+// slice (CubeMarching::setBottomFromBelow) and they are looked up among the previous
+// slab's top-slice vertices, so the output is one connected mesh.
+class StreamingMarcher {
+public:
+    static constexpr int kDefaultSlabLayers = 32;
+
+    struct Stats {
+        int slabs = 0;
+        std::uint64_t vertices = 0;
+        std::uint64_t triangles = 0;
+        std::size_t peakWindowBytes = 0; // largest mapped window
+        std::size_t peakMeshBytes = 0;   // largest slab mesh (vertices + indices)
+    };
+
+    explicit StreamingMarcher(int slabLayers = kDefaultSlabLayers);
+
+    void setMeshMode(MeshMode mode) { mesher_.setMeshMode(mode); }
+    MeshMode getMeshMode() const { return mesher_.getMeshMode(); }
+    int getSlabLayers() const { return slabLayers_; }
+
+    // March the whole volume into `sink` (finish() is left to the caller). False if a
+    // window could not be mapped, or (with a message on std::cerr) if the mesh would need
+    // more than INT_MAX vertices, the most MeshSink's int indices can address.
+    bool march(MappedVolume& volume, float isoLevel, MeshSink& sink, WorkStealingPool* pool = nullptr);
+    const Stats& getStats() const { return stats_; }
+
+private:
+    int slabLayers_;
+    CubeMarching mesher_;
+    Stats stats_;
+
+    // SharedVertices seam: sink index of the vertex on each x/y edge of the last slab's
+    // top slice, indexed by the edge key cell * 2 + axis (-1 = not crossed)
+    std::vector<int> seam_;
+    std::vector<int> remap_; // slab vertex -> sink vertex
+};
+
+#endif // STREAMINGMARCHER_H
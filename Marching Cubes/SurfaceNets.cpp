@@ -0,0 +1,158 @@
+#include "SurfaceNets.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+// Corner offsets and the cube's 12 edges as corner pairs, in CubeMarching's corner order
+static const int kCornerOffset[8][3] = {
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+    {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+};
+static const int kEdgeCorners[12][2] = {
+    {0, 1}, {1, 2}, {3, 2}, {0, 3}, {4, 5}, {5, 6}, {7, 6}, {4, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+void SurfaceNets::generateMesh(const ScalarFieldView& field, float isoLevel, const FieldBlockRanges* blocks)
+{
+    vertices_.clear();
+    indices_.clear();
+    if (!field.hasCubes()) return;
+    if (blocks && !blocks->covers(field)) blocks = nullptr;
+
+    const int cubesX = field.sizeX - 1, cubesY = field.sizeY - 1, cubesZ = field.sizeZ - 1;
+    gridSizeX_ = static_cast<float>(cubesX);
+    gridSizeY_ = static_cast<float>(cubesY);
+    const std::size_t layerSize = static_cast<std::size_t>(cubesX) * cubesY;
+    cubeVertices_[0].assign(layerSize, -1);
+    cubeVertices_[1].assign(layerSize, -1);
+
+    const std::ptrdiff_t sx = field.strideX;
+    float cubeValues[8];
+
+    for (int z = 0; z < cubesZ; ++z)
+    {
+        std::swap(cubeVertices_[0], cubeVertices_[1]);
+        std::fill(cubeVertices_[1].begin(), cubeVertices_[1].end(), -1);
+        const int* below = cubeVertices_[0].data();
+        int* layer = cubeVertices_[1].data();
+
+        for (int y = 0; y < cubesY; ++y)
+        {
+            const float* bottomNear = field.row(y, z);
+            const float* bottomFar = field.row(y + 1, z);
+            const float* topNear = field.row(y, z + 1);
+            const float* topFar = field.row(y + 1, z + 1);
+
+            auto netRun = [&](int xBegin, int xEnd) {
+                const std::ptrdiff_t first = xBegin * sx;
+                float v1 = bottomNear[first], v2 = bottomFar[first], v5 = topNear[first], v6 = topFar[first];
+                for (int x = xBegin; x < xEnd; ++x)
+                {
+                    const float v0 = v1, v3 = v2, v4 = v5, v7 = v6;
+                    const std::ptrdiff_t next = (x + 1) * sx;
+                    v1 = bottomNear[next];
+                    v2 = bottomFar[next];
+                    v5 = topNear[next];
+                    v6 = topFar[next];
+
+                    const int inside = (v0 < isoLevel) + (v1 < isoLevel) + (v2 < isoLevel) + (v3 < isoLevel)
+                                     + (v4 < isoLevel) + (v5 < isoLevel) + (v6 < isoLevel) + (v7 < isoLevel);
+                    if (inside == 0 || inside == 8) continue;
+
+                    cubeValues[0] = v0; cubeValues[1] = v1; cubeValues[2] = v2; cubeValues[3] = v3;
+                    cubeValues[4] = v4; cubeValues[5] = v5; cubeValues[6] = v6; cubeValues[7] = v7;
+                    const std::size_t cell = static_cast<std::size_t>(y) * cubesX + x;
+                    layer[cell] = cubeVertex(cubeValues, x, y, z, isoLevel);
+
+                    // The three edges leaving corner 0 are shared with cubes visited earlier
+                    // (lower x, y or z), so all four cubes around a crossed one have vertices.
+                    // Quads go counter-clockwise about +axis, reversed when the field rises
+                    // along the edge, so faces point to falling values like marching cubes.
+                    const bool lowInside = v0 < isoLevel;
+                    if (lowInside != (v1 < isoLevel) && y > 0 && z > 0)
+                        emitQuad(below[cell - cubesX], below[cell], layer[cell], layer[cell - cubesX], lowInside);
+                    if (lowInside != (v3 < isoLevel) && x > 0 && z > 0)
+                        emitQuad(below[cell - 1], layer[cell - 1], layer[cell], below[cell], lowInside);
+                    if (lowInside != (v4 < isoLevel) && x > 0 && y > 0)
+                        emitQuad(layer[cell - cubesX - 1], layer[cell - cubesX], layer[cell], layer[cell - 1], lowInside);
+                }
+            };
+
+            if (!blocks)
+            {
+                netRun(0, cubesX);
+                continue;
+            }
+
+            // Cubes in blocks whose range misses the iso level have no crossed edges
+            const int blockSize = FieldBlockRanges::kBlockSize;
+            const int lastBlock = (cubesX - 1) / blockSize;
+            for (int bx = 0; bx <= lastBlock; ++bx)
+            {
+                if (!blocks->mayCross(blocks->blockIndex(bx, y / blockSize, z / blockSize), isoLevel)) continue;
+                const int runBegin = bx;
+                while (bx < lastBlock && blocks->mayCross(blocks->blockIndex(bx + 1, y / blockSize, z / blockSize), isoLevel))
+                    ++bx;
+                netRun(runBegin * blockSize, std::min((bx + 1) * blockSize, cubesX));
+            }
+        }
+    }
+}
+
+int SurfaceNets::cubeVertex(const float (&cubeValues)[8], int x, int y, int z, float isoLevel)
+{
+    // Mean of the edge crossings, interpolated as in CubeMarching
+    glm::vec3 sum(0.0f);
+    int crossings = 0;
+    for (const auto& edge : kEdgeCorners)
+    {
+        const float val1 = cubeValues[edge[0]];
+        const float val2 = cubeValues[edge[1]];
+        if ((val1 < isoLevel) == (val2 < isoLevel)) continue;
+
+        const float denom = val2 - val1;
+        float mu = 0.0f;
+        if (std::fabs(denom) > 1e-8f)
+            mu = (isoLevel - val1) / denom;
+        const int* o1 = kCornerOffset[edge[0]];
+        const int* o2 = kCornerOffset[edge[1]];
+        const glm::vec3 p1(o1[0], o1[1], o1[2]);
+        const glm::vec3 p2(o2[0], o2[1], o2[2]);
+        sum += p1 + mu * (p2 - p1);
+        ++crossings;
+    }
+    const glm::vec3 position = glm::vec3(x, y, z) + sum / static_cast<float>(crossings);
+
+    // Gradient from the cube's four edges along each axis, negated as in CubeMarching
+    const float* v = cubeValues;
+    const glm::vec3 gradient((v[1] - v[0]) + (v[2] - v[3]) + (v[5] - v[4]) + (v[6] - v[7]),
+                             (v[3] - v[0]) + (v[2] - v[1]) + (v[7] - v[4]) + (v[6] - v[5]),
+                             (v[4] - v[0]) + (v[5] - v[1]) + (v[6] - v[2]) + (v[7] - v[3]));
+    const float length = glm::length(gradient);
+
+    Vertex vertex;
+    vertex.Position = position;
+    vertex.Normal = length > 1e-8f ? -gradient / length : glm::vec3(0.0f);
+    vertex.TexCoords = glm::vec2(position.x / gridSizeX_, position.y / gridSizeY_);
+    vertices_.push_back(vertex);
+    return static_cast<int>(vertices_.size() - 1);
+}
+
+void SurfaceNets::emitQuad(int a, int b, int c, int d, bool flip)
+{
+    // Split along the shorter diagonal for better-shaped triangles
+    const float diagonalAC = glm::length(vertices_[c].Position - vertices_[a].Position);
+    const float diagonalBD = glm::length(vertices_[d].Position - vertices_[b].Position);
+    int triangles[6] = { a, b, c, a, c, d };
+    if (diagonalBD < diagonalAC)
+    {
+        const int alternate[6] = { a, b, d, b, c, d };
+        std::copy(alternate, alternate + 6, triangles);
+    }
+    if (flip)
+    {
+        std::swap(triangles[1], triangles[2]);
+        std::swap(triangles[4], triangles[5]);
+    }
+    indices_.insert(indices_.end(), triangles, triangles + 6);
+}
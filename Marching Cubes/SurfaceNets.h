@@ -0,0 +1,48 @@
+#ifndef SURFACENETS_H
+#define SURFACENETS_H
+
+#include <cstddef>
+#include <vector>
+#include "../mesh.h"
+#include "ScalarField.h"
+
+// Naive surface nets: the dual of marching cubes on the same grid.
+//
+// Every cube the surface crosses gets exactly one vertex, the mean of its edge
+// crossings, and every crossed grid edge becomes a quad (two triangles) joining the
+// four cubes around it. That gives about as many vertices as shared-vertex marching
+// cubes, about a sixth of flat-shaded, and no slivers, at the cost of rounding off
+// sharp features.
+//
+// Input, coordinates and output match CubeMarching::generateMesh on a flat field:
+// positions in grid units, texture coordinates x/(sizeX-1), y/(sizeY-1), normals from
+// the negated field gradient, and triangles wound the same way. The surface is left
+// open where it meets the border of the field.
+class SurfaceNets {
+public:
+    SurfaceNets() = default;
+
+    // Mesh the field at isoLevel. Block ranges, when given and built for this field,
+    // skip the blocks of cubes that cannot hold surface; the mesh is the same.
+    void generateMesh(const ScalarFieldView& field, float isoLevel, const FieldBlockRanges* blocks = nullptr);
+
+    const std::vector<Vertex>& getVertices() const { return vertices_; }
+    const std::vector<int>& getIndices() const { return indices_; }
+    std::size_t getTriangleCount() const { return indices_.size() / 3; }
+
+private:
+    // Place the vertex of cube (x, y, z) from its corner values, x-fastest as in
+    // CubeMarching (0: x,y,z  1: x+1,y,z  2: x+1,y+1,z  3: x,y+1,z  4..7: same at z+1).
+    int cubeVertex(const float (&cubeValues)[8], int x, int y, int z, float isoLevel);
+
+    // Two triangles over the cube vertices a, b, c, d in order around a crossed edge
+    void emitQuad(int a, int b, int c, int d, bool flip);
+
+    float gridSizeX_{1.0f};
+    float gridSizeY_{1.0f};
+    std::vector<Vertex> vertices_{};
+    std::vector<int> indices_{};
+    std::vector<int> cubeVertices_[2]{}; // vertex of each cube in layers z-1 [0] and z [1], -1 = none
+};
+
+#endif // SURFACENETS_H
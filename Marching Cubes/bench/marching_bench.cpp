@@ -0,0 +1,581 @@
+// CPU marching cubes benchmark. Runs headless. Sections:
+//   - nested std::vector field vs flat strided field
+//   - flat-shaded vs shared-vertex output
+//   - serial vs parallel z-slabs
+//   - iso sweep with and without min/max block skipping
+//   - local edits re-meshed by ChunkedMesher vs full re-meshes
+//   - surface nets vs shared-vertex marching cubes
+//   - packed compile-time case table vs the edgeTable/triTable scan
+//   - QEM decimation of the shared mesh, with ray casts over each result
+//   - the same rays through a SAH BVH
+//
+// Checks:
+//   - both field paths give the same vertices bit for bit
+//   - the shared-vertex mesh covers the same triangles, normals on the same side
+//   - parallel and block-skipping meshes equal the serial ones exactly
+//   - chunked buffers hold the same triangles as a full re-mesh of the edited field
+//   - surface nets faces point along their vertex normals, unchanged by skipping
+//   - both case kernels give the same mesh
+//   - 95% of rays hit a decimated mesh within 2 cells of where they hit the full one
+//   - the BVH finds the same hits and closest points as testing every triangle
+//
+// Usage: MarchingCubesBench [--size N] [--repeats N] [--threads N]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChunkedMesher.h"
+#include "CubeMarching.h"
+#include "ScalarField.h"
+#include "SurfaceNets.h"
+#include "geometry/bvh.h"
+#include "geometry/mesh_simplifier.h"
+#include "work_stealing_pool.h"
+
+namespace {
+
+using NestedField = std::vector<std::vector<std::vector<float>>>;
+
+struct Scene {
+    const char* name;
+    float isoLevel;
+    float (*sample)(float x, float y, float z); // coordinates in [0, 1]
+    float isoSweep[5];                          // iso slider positions for block skipping
+};
+
+float sphereSample(float x, float y, float z) {
+    const float dx = x - 0.5f, dy = y - 0.5f, dz = z - 0.5f;
+    return std::sqrt(dx * dx + dy * dy + dz * dz) - 0.4f;
+}
+
+// Two periods of a gyroid across the grid: far more active cubes than the sphere
+float gyroidSample(float x, float y, float z) {
+    const float k = 4.0f * 3.14159265f;
+    return std::sin(k * x) * std::cos(k * y) + std::sin(k * y) * std::cos(k * z) +
+           std::sin(k * z) * std::cos(k * x);
+}
+
+std::vector<float> makeFlatField(const Scene& scene, int size) {
+    std::vector<float> field(static_cast<size_t>(size) * size * size);
+    const float inv = 1.0f / static_cast<float>(size - 1);
+    size_t i = 0;
+    for (int z = 0; z < size; ++z)
+        for (int y = 0; y < size; ++y)
+            for (int x = 0; x < size; ++x)
+                field[i++] = scene.sample(x * inv, y * inv, z * inv);
+    return field;
+}
+
+NestedField makeNestedField(const std::vector<float>& flat, int size) {
+    NestedField field(size, std::vector<std::vector<float>>(size, std::vector<float>(size)));
+    size_t i = 0;
+    for (int z = 0; z < size; ++z)
+        for (int y = 0; y < size; ++y)
+            for (int x = 0; x < size; ++x)
+                field[z][y][x] = flat[i++];
+    return field;
+}
+
+template <typename Fn>
+double bestMs(int repeats, Fn&& run) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        run();
+        auto t1 = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return best;
+}
+
+bool sameMesh(const CubeMarching& a, const CubeMarching& b) {
+    const std::vector<Vertex>& va = a.getVertices();
+    const std::vector<Vertex>& vb = b.getVertices();
+    return va.size() == vb.size() && a.getIndices() == b.getIndices() &&
+           (va.empty() || std::memcmp(va.data(), vb.data(), va.size() * sizeof(Vertex)) == 0);
+}
+
+// Same triangles as the flat-shaded mesh (interpolation runs from the other end on
+// some edges, hence the tolerance) and smooth normals on the face normal's side.
+bool sameSurface(const CubeMarching& flat, const CubeMarching& shared) {
+    const std::vector<Vertex>& fv = flat.getVertices();
+    const std::vector<Vertex>& sv = shared.getVertices();
+    const std::vector<int>& si = shared.getIndices();
+    if (si.size() != fv.size()) return false;
+
+    size_t flipped = 0;
+    for (size_t i = 0; i < si.size(); ++i) {
+        const Vertex& v = sv[si[i]];
+        const glm::vec3 d = v.Position - fv[i].Position;
+        if (std::fabs(d.x) > 1e-4f || std::fabs(d.y) > 1e-4f || std::fabs(d.z) > 1e-4f) return false;
+        if (glm::dot(v.Normal, fv[i].Normal) < 0.0f) ++flipped;
+    }
+    // Only sliver triangles, whose face normal is noise, may disagree
+    return flipped * 1000 < si.size();
+}
+
+// The three vertices of every triangle, sorted; degenerate filler triangles are dropped
+std::vector<std::array<Vertex, 3>> triangleSet(const std::vector<Vertex>& vertices, const std::vector<int>& indices) {
+    std::vector<std::array<Vertex, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] == indices[i + 1] && indices[i] == indices[i + 2]) continue;
+        triangles.push_back({ vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]] });
+    }
+    std::sort(triangles.begin(), triangles.end(), [](const std::array<Vertex, 3>& a, const std::array<Vertex, 3>& b) {
+        return std::memcmp(a.data(), b.data(), sizeof(a)) < 0;
+    });
+    return triangles;
+}
+
+bool sameTriangles(const std::vector<std::array<Vertex, 3>>& a, const std::vector<std::array<Vertex, 3>>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0);
+}
+
+// Faces wound like marching cubes: each face normal on the side of its vertex normals
+bool netsFacesAgree(const SurfaceNets& nets) {
+    const std::vector<Vertex>& v = nets.getVertices();
+    const std::vector<int>& idx = nets.getIndices();
+    size_t flipped = 0;
+    for (size_t i = 0; i + 2 < idx.size(); i += 3) {
+        const Vertex& a = v[idx[i]];
+        const Vertex& b = v[idx[i + 1]];
+        const Vertex& c = v[idx[i + 2]];
+        const glm::vec3 face = glm::cross(b.Position - a.Position, c.Position - a.Position);
+        if (glm::dot(face, a.Normal + b.Normal + c.Normal) < 0.0f) ++flipped;
+    }
+    return flipped * 1000 < idx.size() / 3;
+}
+
+// Share of triangles with an angle under 10 degrees, degenerate ones included
+double sliverPercent(const std::vector<Vertex>& vertices, const std::vector<int>& indices) {
+    const float cosLimit = std::cos(10.0f * 3.14159265f / 180.0f);
+    size_t slivers = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3 p[3] = { vertices[indices[i]].Position, vertices[indices[i + 1]].Position,
+                                 vertices[indices[i + 2]].Position };
+        bool sliver = false;
+        for (int k = 0; k < 3 && !sliver; ++k) {
+            const glm::vec3 e1 = p[(k + 1) % 3] - p[k], e2 = p[(k + 2) % 3] - p[k];
+            const float l1 = glm::length(e1), l2 = glm::length(e2);
+            sliver = l1 < 1e-6f || l2 < 1e-6f || glm::dot(e1, e2) > cosLimit * l1 * l2;
+        }
+        slivers += sliver ? 1 : 0;
+    }
+    return indices.empty() ? 0.0 : 300.0 * slivers / indices.size();
+}
+
+bool sameNets(const SurfaceNets& a, const SurfaceNets& b) {
+    const std::vector<Vertex>& va = a.getVertices();
+    const std::vector<Vertex>& vb = b.getVertices();
+    return va.size() == vb.size() && a.getIndices() == b.getIndices() &&
+           (va.empty() || std::memcmp(va.data(), vb.data(), va.size() * sizeof(Vertex)) == 0);
+}
+
+struct SampleBox {
+    int minX, minY, minZ, maxX, maxY, maxZ;
+};
+
+// Carve a ball (centre and radius in [0, 1] field units) out of a field that is
+// negative inside; returns the samples it may have changed.
+SampleBox carve(std::vector<float>& field, int size, float cx, float cy, float cz, float radius) {
+    const float scale = static_cast<float>(size - 1);
+    auto lo = [&](float c) { return std::max(0, static_cast<int>(std::floor((c - radius) * scale))); };
+    auto hi = [&](float c) { return std::min(size - 1, static_cast<int>(std::ceil((c + radius) * scale))); };
+    const SampleBox box{ lo(cx), lo(cy), lo(cz), hi(cx), hi(cy), hi(cz) };
+    for (int z = box.minZ; z <= box.maxZ; ++z)
+        for (int y = box.minY; y <= box.maxY; ++y)
+            for (int x = box.minX; x <= box.maxX; ++x) {
+                const float dx = x / scale - cx, dy = y / scale - cy, dz = z / scale - cz;
+                float& value = field[(static_cast<size_t>(z) * size + y) * size + x];
+                value = std::max(value, radius - std::sqrt(dx * dx + dy * dy + dz * dz));
+            }
+    return box;
+}
+
+// Nearest hit along a ray by testing every triangle, as MouseSelector::testMesh did
+// before it had a BVH; negative if the ray misses
+float castRay(const std::vector<Vertex>& vertices, const std::vector<int>& indices,
+              const glm::vec3& origin, const glm::vec3& dir) {
+    float nearest = -1.0f;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3& v0 = vertices[indices[i]].Position;
+        const glm::vec3 edge1 = vertices[indices[i + 1]].Position - v0;
+        const glm::vec3 edge2 = vertices[indices[i + 2]].Position - v0;
+        const glm::vec3 h = glm::cross(dir, edge2);
+        const float det = glm::dot(edge1, h);
+        if (std::fabs(det) < 1e-6f) continue;
+        const float invDet = 1.0f / det;
+        const glm::vec3 s = origin - v0;
+        const float u = invDet * glm::dot(s, h);
+        if (u < 0.0f || u > 1.0f) continue;
+        const glm::vec3 q = glm::cross(s, edge1);
+        const float v = invDet * glm::dot(dir, q);
+        if (v < 0.0f || u + v > 1.0f) continue;
+        const float t = invDet * glm::dot(edge2, q);
+        if (t > 1e-6f && (nearest < 0.0f || t < nearest)) nearest = t;
+    }
+    return nearest;
+}
+
+struct Ray {
+    glm::vec3 origin, dir;
+};
+
+// Rays from outside the grid towards random points inside it
+std::vector<Ray> makeRays(int count, int size) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    const float extent = static_cast<float>(size - 1);
+    const glm::vec3 centre(0.5f * extent);
+    std::vector<Ray> rays;
+    for (int i = 0; i < count; ++i) {
+        glm::vec3 away(normal(rng), normal(rng), normal(rng));
+        away /= std::max(1e-6f, glm::length(away));
+        const glm::vec3 origin = centre + away * extent;
+        const glm::vec3 target(unit(rng) * extent, unit(rng) * extent, unit(rng) * extent);
+        rays.push_back({ origin, glm::normalize(target - origin) });
+    }
+    return rays;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int size = 256;
+    int repeats = 3;
+    int threads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) size = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--repeats" && i + 1 < argc) repeats = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "Usage: MarchingCubesBench [--size N] [--repeats N] [--threads N]\n";
+            return 1;
+        }
+    }
+
+    const Scene scenes[] = {
+        { "sphere", 0.0f, sphereSample, { -0.3f, -0.15f, 0.0f, 0.15f, 0.3f } },
+        { "gyroid", 0.0f, gyroidSample, { -1.0f, -0.5f, 0.0f, 0.5f, 1.0f } },
+    };
+    const double cubes = std::pow(static_cast<double>(size - 1), 3.0);
+
+    std::cout << "Marching cubes benchmark (" << size << "^3 samples, best of " << repeats << ")\n";
+    std::cout << std::setw(8) << "scene" << std::setw(12) << "triangles" << std::setw(13) << "nested ms"
+              << std::setw(11) << "flat ms" << std::setw(13) << "flat Mc/s" << std::setw(10) << "speedup"
+              << std::setw(8) << "match" << "\n";
+
+    WorkStealingPool pool(threads);
+    bool allMatch = true;
+    std::vector<std::string> sharedRows;
+    std::vector<std::string> parallelRows;
+    std::vector<std::string> skipRows;
+    std::vector<std::string> netsRows;
+    std::vector<std::string> kernelRows;
+    std::vector<std::string> decimateRows;
+    std::vector<std::string> bvhRows;
+    const int kRays = 200;
+    const std::vector<Ray> rays = makeRays(kRays, size);
+    for (const Scene& scene : scenes) {
+        const std::vector<float> flat = makeFlatField(scene, size);
+        const NestedField nested = makeNestedField(flat, size);
+        const ScalarFieldView view = ScalarFieldView::dense(flat.data(), size, size, size);
+
+        CubeMarching nestedMesher, flatMesher;
+        const double nestedMs = bestMs(repeats, [&] { nestedMesher.generateMesh(nested, scene.isoLevel); });
+        const double flatMs = bestMs(repeats, [&] { flatMesher.generateMesh(view, scene.isoLevel); });
+        const bool match = sameMesh(nestedMesher, flatMesher);
+        allMatch = allMatch && match;
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(8) << scene.name << std::setw(12) << flatMesher.getTriangleCount()
+                  << std::setw(13) << nestedMs << std::setw(11) << flatMs
+                  << std::setw(13) << (cubes / (flatMs * 1e3)) << std::setw(9) << (nestedMs / flatMs) << "x"
+                  << std::setw(8) << (match ? "yes" : "NO") << "\n";
+
+        CubeMarching sharedMesher;
+        sharedMesher.setMeshMode(MeshMode::SharedVertices);
+        const double sharedMs = bestMs(repeats, [&] { sharedMesher.generateMesh(view, scene.isoLevel); });
+        const bool surfaceMatch = sameSurface(flatMesher, sharedMesher);
+        allMatch = allMatch && surfaceMatch;
+
+        const double flatMb = flatMesher.getVertices().size() * sizeof(Vertex) / 1048576.0;
+        const double sharedMb = sharedMesher.getVertices().size() * sizeof(Vertex) / 1048576.0;
+        std::ostringstream row;
+        row << std::fixed << std::setprecision(1)
+            << std::setw(8) << scene.name << std::setw(12) << sharedMesher.getVertices().size()
+            << std::setw(12) << flatMb << std::setw(12) << sharedMb << std::setw(11) << sharedMs
+            << std::setw(8) << (surfaceMatch ? "yes" : "NO");
+        sharedRows.push_back(row.str());
+
+        const CubeMarching* serialMeshers[] = { &flatMesher, &sharedMesher };
+        for (const CubeMarching* serial : serialMeshers) {
+            CubeMarching parallelMesher;
+            parallelMesher.setMeshMode(serial->getMeshMode());
+            const double serialMs = serial == &flatMesher ? flatMs : sharedMs;
+            const double parallelMs = bestMs(repeats, [&] { parallelMesher.generateMesh(view, scene.isoLevel, &pool); });
+            const bool identical = sameMesh(*serial, parallelMesher);
+            allMatch = allMatch && identical;
+
+            std::ostringstream parallelRow;
+            parallelRow << std::fixed << std::setprecision(1)
+                        << std::setw(8) << scene.name
+                        << std::setw(8) << (serial == &flatMesher ? "flat" : "shared")
+                        << std::setw(12) << serialMs << std::setw(14) << parallelMs
+                        << std::setw(9) << (serialMs / parallelMs) << "x"
+                        << std::setw(11) << (identical ? "yes" : "NO");
+            parallelRows.push_back(parallelRow.str());
+        }
+
+        // Iso slider: the block summary is built once, then every iso change reuses it
+        FieldBlockRanges blocks;
+        const double buildMs = bestMs(1, [&] { blocks.build(view); });
+        double fullMs = 0.0, skipMs = 0.0;
+        size_t activeBlocks = 0;
+        bool skipMatch = true;
+        CubeMarching fullMesher, skipMesher;
+        for (const float iso : scene.isoSweep) {
+            fullMs += bestMs(repeats, [&] { fullMesher.generateMesh(view, iso); });
+            skipMs += bestMs(repeats, [&] { skipMesher.generateMesh(view, iso, blocks); });
+            skipMatch = skipMatch && sameMesh(fullMesher, skipMesher);
+            for (size_t b = 0; b < blocks.blockCount(); ++b) activeBlocks += blocks.mayCross(b, iso) ? 1 : 0;
+        }
+        allMatch = allMatch && skipMatch;
+
+        const size_t sweepSize = sizeof(scene.isoSweep) / sizeof(scene.isoSweep[0]);
+        std::ostringstream skipRow;
+        skipRow << std::fixed << std::setprecision(1)
+                << std::setw(8) << scene.name << std::setw(11) << buildMs
+                << std::setw(10) << (100.0 * activeBlocks / (blocks.blockCount() * sweepSize)) << "%"
+                << std::setw(11) << (fullMs / sweepSize) << std::setw(11) << (skipMs / sweepSize)
+                << std::setw(9) << (fullMs / skipMs) << "x" << std::setw(8) << (skipMatch ? "yes" : "NO");
+        skipRows.push_back(skipRow.str());
+
+        SurfaceNets nets, netsSkipped;
+        const double netsMs = bestMs(repeats, [&] { nets.generateMesh(view, scene.isoLevel); });
+        netsSkipped.generateMesh(view, scene.isoLevel, &blocks);
+        const bool netsMatch = netsFacesAgree(nets) && sameNets(nets, netsSkipped);
+        allMatch = allMatch && netsMatch;
+
+        std::ostringstream netsRow;
+        netsRow << std::fixed << std::setprecision(1)
+                << std::setw(8) << scene.name << std::setw(11) << flatMesher.getVertices().size()
+                << std::setw(11) << sharedMesher.getVertices().size() << std::setw(11) << nets.getVertices().size()
+                << std::setw(10) << sharedMesher.getTriangleCount() << std::setw(10) << nets.getTriangleCount()
+                << std::setw(10) << sliverPercent(sharedMesher.getVertices(), sharedMesher.getIndices()) << "%"
+                << std::setw(9) << sliverPercent(nets.getVertices(), nets.getIndices()) << "%"
+                << std::setw(8) << sharedMs << std::setw(8) << netsMs
+                << std::setw(8) << (netsMatch ? "yes" : "NO");
+        netsRows.push_back(netsRow.str());
+
+        // Both kernels timed back to back on warm meshers so neither pays for first-touch growth
+        for (const CubeMarching* reference : serialMeshers) {
+            CubeMarching packedMesher, scanMesher;
+            packedMesher.setMeshMode(reference->getMeshMode());
+            scanMesher.setMeshMode(reference->getMeshMode());
+            scanMesher.setCaseKernel(CaseKernel::TableScan);
+            packedMesher.generateMesh(view, scene.isoLevel);
+            scanMesher.generateMesh(view, scene.isoLevel);
+            double scanMs = 1e30, packedMs = 1e30;
+            for (int r = 0; r < repeats; ++r) {
+                scanMs = std::min(scanMs, bestMs(1, [&] { scanMesher.generateMesh(view, scene.isoLevel); }));
+                packedMs = std::min(packedMs, bestMs(1, [&] { packedMesher.generateMesh(view, scene.isoLevel); }));
+            }
+            const bool identical = sameMesh(packedMesher, scanMesher) && sameMesh(*reference, packedMesher);
+            allMatch = allMatch && identical;
+
+            std::ostringstream kernelRow;
+            kernelRow << std::fixed << std::setprecision(1)
+                      << std::setw(8) << scene.name
+                      << std::setw(8) << (reference == &flatMesher ? "flat" : "shared")
+                      << std::setw(10) << scanMs << std::setw(12) << (cubes / (scanMs * 1e3))
+                      << std::setw(11) << packedMs << std::setw(14) << (cubes / (packedMs * 1e3))
+                      << std::setw(9) << (scanMs / packedMs) << "x"
+                      << std::setw(11) << (identical ? "yes" : "NO");
+            kernelRows.push_back(kernelRow.str());
+        }
+
+        // Decimation: rays at the decimated mesh should hit where they hit the full one,
+        // within a couple of cells, and cost in proportion to the triangles left
+        std::vector<float> fullHits(rays.size());
+        const double fullRayMs = bestMs(1, [&] {
+            for (size_t r = 0; r < rays.size(); ++r)
+                fullHits[r] = castRay(sharedMesher.getVertices(), sharedMesher.getIndices(), rays[r].origin, rays[r].dir);
+        });
+        // The same rays through a BVH, plus closest points against a brute-force scan
+        BVH bvh;
+        const double bvhBuildMs = bestMs(repeats, [&] { bvh.build(sharedMesher.getVertices(), sharedMesher.getIndices()); });
+        std::vector<float> bvhHits(rays.size());
+        const double bvhRayMs = bestMs(repeats, [&] {
+            for (size_t r = 0; r < rays.size(); ++r) {
+                BVH::RayHit hit;
+                bvhHits[r] = bvh.intersect(rays[r].origin, rays[r].dir, hit) ? hit.distance : -1.0f;
+            }
+        });
+        bool bvhMatch = true;
+        for (size_t r = 0; r < rays.size(); ++r)
+            bvhMatch = bvhMatch && (bvhHits[r] < 0.0f) == (fullHits[r] < 0.0f) &&
+                       std::fabs(bvhHits[r] - fullHits[r]) <= 1e-4f * std::max(1.0f, fullHits[r]);
+        for (size_t r = 0; r < rays.size(); r += 10) {
+            const glm::vec3 point = rays[r].origin + rays[r].dir * (0.5f * static_cast<float>(size));
+            float brute = 1e30f;
+            const std::vector<Vertex>& sv = sharedMesher.getVertices();
+            const std::vector<int>& si = sharedMesher.getIndices();
+            for (size_t i = 0; i + 2 < si.size(); i += 3) {
+                BVH single;
+                single.build({ sv[si[i]].Position, sv[si[i + 1]].Position, sv[si[i + 2]].Position });
+                brute = std::min(brute, single.closestPoint(point).distance);
+            }
+            bvhMatch = bvhMatch && std::fabs(bvh.closestPoint(point).distance - brute) <= 1e-4f * std::max(1.0f, brute);
+        }
+        allMatch = allMatch && bvhMatch;
+
+        std::ostringstream bvhRow;
+        bvhRow << std::fixed << std::setprecision(1)
+               << std::setw(8) << scene.name << std::setw(11) << sharedMesher.getTriangleCount()
+               << std::setw(10) << bvh.nodeCount() << std::setw(7) << bvh.getDepth()
+               << std::setw(10) << bvhBuildMs << std::setw(11) << fullRayMs << std::setprecision(2)
+               << std::setw(10) << bvhRayMs << std::setprecision(0) << std::setw(10) << (fullRayMs / bvhRayMs) << "x"
+               << std::setw(11) << (bvhMatch ? "yes" : "NO");
+        bvhRows.push_back(bvhRow.str());
+
+        const size_t fullTriangles = sharedMesher.getTriangleCount();
+        for (const int keepPercent : { 100, 50, 25, 10 }) {
+            std::vector<Vertex> vertices = sharedMesher.getVertices();
+            std::vector<int> indices = sharedMesher.getIndices();
+            MeshSimplifier simplifier;
+            MeshSimplifier::Options options;
+            options.targetTriangles = fullTriangles * keepPercent / 100;
+            const double decimateMs = keepPercent == 100 ? 0.0 : bestMs(1, [&] {
+                simplifier.simplify(vertices, indices, options);
+            });
+
+            std::vector<float> hits(rays.size());
+            const double rayMs = keepPercent == 100 ? fullRayMs : bestMs(1, [&] {
+                for (size_t r = 0; r < rays.size(); ++r)
+                    hits[r] = castRay(vertices, indices, rays[r].origin, rays[r].dir);
+            });
+            if (keepPercent == 100) hits = fullHits;
+            size_t agree = 0;
+            for (size_t r = 0; r < rays.size(); ++r)
+                agree += (hits[r] < 0.0f) == (fullHits[r] < 0.0f) &&
+                         (hits[r] < 0.0f || std::fabs(hits[r] - fullHits[r]) < 2.0f) ? 1 : 0;
+            const bool close = agree * 100 >= rays.size() * 95;
+            allMatch = allMatch && close;
+
+            std::ostringstream decimateRow;
+            decimateRow << std::fixed << std::setprecision(1)
+                        << std::setw(8) << scene.name << std::setw(7) << keepPercent << "%"
+                        << std::setw(11) << indices.size() / 3 << std::setw(10) << vertices.size()
+                        << std::setw(12) << decimateMs << std::setw(10) << std::setprecision(3)
+                        << simplifier.getMaxError() << std::setprecision(1)
+                        << std::setw(10) << rayMs << std::setw(9) << (fullRayMs / rayMs) << "x"
+                        << std::setw(9) << (100.0 * agree / rays.size()) << "%";
+            decimateRows.push_back(decimateRow.str());
+        }
+    }
+
+    std::cout << "\nShared-vertex output (vertex buffer MB, flat-shaded vs shared)\n";
+    std::cout << std::setw(8) << "scene" << std::setw(12) << "vertices" << std::setw(12) << "flat MB"
+              << std::setw(12) << "shared MB" << std::setw(11) << "ms" << std::setw(8) << "match" << "\n";
+    for (const std::string& row : sharedRows) std::cout << row << "\n";
+
+    std::cout << "\nParallel z-slabs (" << threads << " threads)\n";
+    std::cout << std::setw(8) << "scene" << std::setw(8) << "mode" << std::setw(12) << "serial ms"
+              << std::setw(14) << "parallel ms" << std::setw(10) << "speedup" << std::setw(11) << "identical" << "\n";
+    for (const std::string& row : parallelRows) std::cout << row << "\n";
+
+    std::cout << "\nBlock skipping over a 5-step iso sweep (" << FieldBlockRanges::kBlockSize
+              << "^3-cube blocks, mean ms per mesh)\n";
+    std::cout << std::setw(8) << "scene" << std::setw(11) << "build ms" << std::setw(11) << "active"
+              << std::setw(11) << "full ms" << std::setw(11) << "skip ms" << std::setw(10) << "speedup"
+              << std::setw(8) << "match" << "\n";
+    for (const std::string& row : skipRows) std::cout << row << "\n";
+
+    std::cout << "\nSurface nets (SN) vs marching cubes (MC flat / shared), slivers = triangles under 10 deg\n";
+    std::cout << std::setw(8) << "scene" << std::setw(11) << "MC flat v" << std::setw(11) << "MC shr v"
+              << std::setw(11) << "SN verts" << std::setw(10) << "MC tris" << std::setw(10) << "SN tris"
+              << std::setw(11) << "MC sliver" << std::setw(10) << "SN sliver"
+              << std::setw(8) << "MC ms" << std::setw(8) << "SN ms" << std::setw(8) << "faces" << "\n";
+    for (const std::string& row : netsRows) std::cout << row << "\n";
+
+    std::cout << "\nCase kernels (edgeTable/triTable scan vs packed compile-time table, Mc/s = million cubes per second)\n";
+    std::cout << std::setw(8) << "scene" << std::setw(8) << "mode" << std::setw(10) << "scan ms"
+              << std::setw(12) << "scan Mc/s" << std::setw(11) << "packed ms" << std::setw(14) << "packed Mc/s"
+              << std::setw(10) << "speedup" << std::setw(11) << "identical" << "\n";
+    for (const std::string& row : kernelRows) std::cout << row << "\n";
+
+    std::cout << "\nQEM decimation of the shared mesh (max error in cells, " << kRays
+              << " rays tested against every triangle, agree = same hit within 2 cells)\n";
+    std::cout << std::setw(8) << "scene" << std::setw(8) << "kept" << std::setw(11) << "triangles"
+              << std::setw(10) << "vertices" << std::setw(12) << "decimate ms" << std::setw(10) << "max err"
+              << std::setw(10) << "rays ms" << std::setw(10) << "speedup" << std::setw(10) << "agree" << "\n";
+    for (const std::string& row : decimateRows) std::cout << row << "\n";
+
+    std::cout << "\nBVH (binned SAH, " << sizeof(BVH::Node) << "-byte flat nodes) vs testing every triangle, same "
+              << kRays << " rays\n";
+    std::cout << std::setw(8) << "scene" << std::setw(11) << "triangles" << std::setw(10) << "nodes"
+              << std::setw(7) << "depth" << std::setw(10) << "build ms" << std::setw(11) << "brute ms"
+              << std::setw(10) << "BVH ms" << std::setw(11) << "speedup" << std::setw(11) << "identical" << "\n";
+    for (const std::string& row : bvhRows) std::cout << row << "\n";
+
+    // Local edits: dents carved into the sphere, re-meshed chunk by chunk
+    const int kEdits = 20;
+    std::cout << "\nLocal edits (" << kEdits << " dents in the sphere, " << ChunkedMesher::kDefaultChunkSize
+              << "^3-cube chunks, mean ms per edit)\n";
+    std::cout << std::setw(8) << "mode" << std::setw(9) << "chunks" << std::setw(11) << "full ms"
+              << std::setw(13) << "chunked ms" << std::setw(10) << "speedup" << std::setw(8) << "match" << "\n";
+    const MeshMode modes[] = { MeshMode::FlatShaded, MeshMode::SharedVertices };
+    for (const MeshMode mode : modes) {
+        std::vector<float> field = makeFlatField(scenes[0], size);
+        const ScalarFieldView view = ScalarFieldView::dense(field.data(), size, size, size);
+        FieldBlockRanges blocks(view);
+        ChunkedMesher chunked;
+        chunked.setMeshMode(mode);
+        chunked.build(view, 0.0f, &pool, &blocks);
+
+        std::mt19937 rng(7);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        double chunkedMs = 0.0;
+        int chunksMeshed = 0;
+        for (int edit = 0; edit < kEdits; ++edit) {
+            float dx = normal(rng), dy = normal(rng), dz = normal(rng);
+            const float length = std::max(1e-6f, std::sqrt(dx * dx + dy * dy + dz * dz));
+            const SampleBox box = carve(field, size, 0.5f + 0.4f * dx / length, 0.5f + 0.4f * dy / length,
+                                        0.5f + 0.4f * dz / length, 0.03f);
+            chunkedMs += bestMs(1, [&] {
+                blocks.refresh(view, box.minX, box.minY, box.minZ, box.maxX, box.maxY, box.maxZ);
+                chunked.markDirty(box.minX, box.minY, box.minZ, box.maxX, box.maxY, box.maxZ);
+                chunksMeshed += chunked.update(view, &pool, &blocks);
+            });
+        }
+
+        CubeMarching full;
+        full.setMeshMode(mode);
+        const double fullMs = bestMs(repeats, [&] { full.generateMesh(view, 0.0f, blocks, &pool); });
+        const bool match = sameTriangles(triangleSet(full.getVertices(), full.getIndices()),
+                                         triangleSet(chunked.getVertices(), chunked.getIndices()));
+        allMatch = allMatch && match;
+
+        chunkedMs /= kEdits;
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(8) << (mode == MeshMode::FlatShaded ? "flat" : "shared")
+                  << std::setw(9) << (static_cast<double>(chunksMeshed) / kEdits)
+                  << std::setw(11) << fullMs << std::setw(13) << chunkedMs
+                  << std::setw(9) << (fullMs / chunkedMs) << "x" << std::setw(8) << (match ? "yes" : "NO") << "\n";
+    }
+    return allMatch ? 0 : 1;
+}
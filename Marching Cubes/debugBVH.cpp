@@ -5,13 +5,16 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "GPUMarchCubes.h"
+#include "../geometry/bvh.h"
 #include "../model.h"
 #include "../shader.h"
 #include "../camera.h"
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <memory>
 
 const unsigned int SCR_WIDTH = 1200;
 const unsigned int SCR_HEIGHT = 900;
@@ -35,11 +38,6 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 
-struct Triangle {
-    glm::vec3 v0, v1, v2;
-    glm::vec3 normal;
-};
-
 struct BoundingBox {
     glm::vec3 min = glm::vec3(1e10f);
     glm::vec3 max = glm::vec3(-1e10f);
@@ -55,12 +53,6 @@ struct BoundingBox {
         center = (min + max) * 0.5f;
     }
 
-    void update(const Triangle& tri) {
-        update(tri.v0);
-        update(tri.v1);
-        update(tri.v2);
-    }
-
     ~BoundingBox(){
         if(VAO) glDeleteVertexArrays(1, &VAO);
         if(VBO) glDeleteBuffers(1, &VBO);
@@ -122,112 +114,37 @@ struct BoundingBox {
     }
 };
 
-struct Node {
-    BoundingBox bbox;
-    std::vector<Triangle> triangles;
-    Node* childA;
-    Node* childB;
-    bool isLeaf;
-    
-    ~Node() {
-        delete childA;
-        delete childB;
-    }
-};
-
-class BVH {
-public:
-    BoundingBox rootBBox;
-    Node* root;
-
-    BVH(const std::vector<Triangle>& triangles) {
-        root = buildBVH(triangles, 0);
-        rootBBox = root->bbox;
+// Draws the BVH nodes at one depth, scaling a unit box to each node's bounds
+void renderBVH(const BVH& bvh, BoundingBox& unitBox, Shader& shader, int targetDepth) {
+    glm::vec3 color;
+    switch (targetDepth % 6) {
+        case 0: color = glm::vec3(1.0f, 0.0f, 0.0f); break; // Red - Root
+        case 1: color = glm::vec3(0.0f, 1.0f, 0.0f); break; // Green - Level 1
+        case 2: color = glm::vec3(0.0f, 0.0f, 1.0f); break; // Blue - Level 2
+        case 3: color = glm::vec3(1.0f, 1.0f, 0.0f); break; // Yellow - Level 3
+        case 4: color = glm::vec3(1.0f, 0.0f, 1.0f); break; // Magenta - Level 4
+        case 5: color = glm::vec3(0.0f, 1.0f, 1.0f); break; // Cyan - Level 5
     }
-    
-    ~BVH() {
-        delete root;
-    }
-
-    void renderBVH(Shader& shader, int targetDepth) {
-        if (root) {
-            renderNodeRecursive(root, shader, 0, targetDepth);
-        }
-    }
-
-private:
-    void renderNodeRecursive(Node* node, Shader& shader, int currentDepth, int targetDepth) {
-        if (!node) return;
-        if (currentDepth == targetDepth) {
-            glm::vec3 color;
-            switch (currentDepth % 6) {
-                case 0: color = glm::vec3(1.0f, 0.0f, 0.0f); break; // Red - Root
-                case 1: color = glm::vec3(0.0f, 1.0f, 0.0f); break; // Green - Level 1
-                case 2: color = glm::vec3(0.0f, 0.0f, 1.0f); break; // Blue - Level 2
-                case 3: color = glm::vec3(1.0f, 1.0f, 0.0f); break; // Yellow - Level 3
-                case 4: color = glm::vec3(1.0f, 0.0f, 1.0f); break; // Magenta - Level 4
-                case 5: color = glm::vec3(0.0f, 1.0f, 1.0f); break; // Cyan - Level 5
-            }
-            
-            // Set model matrix to center the box at its center
-            glm::mat4 boxModel = glm::translate(glm::mat4(1.0f), node->bbox.center);
-            shader.setMat4("model", boxModel);
-            shader.setVec3("color", color);
-            
-            node->bbox.render();
-        }
-        
-        // Continue traversing children
-        if (currentDepth < targetDepth && !node->isLeaf) {
-            if (node->childA) renderNodeRecursive(node->childA, shader, currentDepth + 1, targetDepth);
-            if (node->childB) renderNodeRecursive(node->childB, shader, currentDepth + 1, targetDepth);
-        }
-    }
-    Node* buildBVH(const std::vector<Triangle>& triangles, int depth) {
-        Node* node = new Node();
-        for (const auto& tri : triangles) {
-            node->bbox.update(tri);
-        }
-
-        if (triangles.size() <= 2 || depth >= MAX_DEPTH) {
-            node->triangles = triangles;
-            node->isLeaf = true;
-            node->childA = nullptr;
-            node->childB = nullptr;
-            return node;
-        }
-
-        // Split along longest axis
-        glm::vec3 extent = node->bbox.max - node->bbox.min;
-        int axis = 0;
-        if (extent.y > extent.x && extent.y > extent.z) axis = 1;
-        else if (extent.z > extent.x) axis = 2;
-
-        float splitPos = node->bbox.min[axis] + extent[axis] * 0.5f;
-
-        std::vector<Triangle> leftTris, rightTris;
-        for (const auto& tri : triangles) {
-            float centroid = (tri.v0[axis] + tri.v1[axis] + tri.v2[axis]) / 3.0f;
-            if (centroid < splitPos) leftTris.push_back(tri);
-            else rightTris.push_back(tri);
-        }
-
-        // Where all triangles go to one side
-        if (leftTris.empty() || rightTris.empty()) {
-            leftTris.clear();
-            rightTris.clear();
-            for (size_t i = 0; i < triangles.size(); ++i) {
-                if (i < triangles.size() / 2) leftTris.push_back(triangles[i]);
-                else rightTris.push_back(triangles[i]);
-            }
-        }
+    shader.setVec3("color", color);
+
+    bvh.forEachNodeAtDepth(targetDepth, [&](const BVH::Node& node) {
+        glm::mat4 boxModel = glm::translate(glm::mat4(1.0f), (node.boundsMin + node.boundsMax) * 0.5f);
+        boxModel = glm::scale(boxModel, node.boundsMax - node.boundsMin);
+        shader.setMat4("model", boxModel);
+        unitBox.render();
+    });
+}
 
-        node->childA = buildBVH(leftTris, depth + 1);
-        node->childB = buildBVH(rightTris, depth + 1);
-        node->isLeaf = false;
-        return node;
-    }
-};
+// Builds the BVH with the current construction depth and reports its size and build time
+void buildBVH(BVH& bvh, const std::vector<glm::vec3>& corners) {
+    BVH::Options options;
+    options.maxDepth = MAX_DEPTH;
+    auto start = std::chrono::high_resolution_clock::now();
+    bvh.build(corners, options);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "BVH: " << bvh.nodeCount() << " nodes (" << bvh.nodeCount() * sizeof(BVH::Node) << " bytes), depth "
+              << bvh.getDepth() << ", " << bvh.triangleCount() << " triangles, built in " << ms << " ms" << std::endl;
+}
 
 int main()
 {
@@ -272,26 +189,24 @@ int main()
     Model bunnyModel("models/stanford-bunny/source/bunny.obj");
     std::cout << "Model loaded with " << bunnyModel.meshes.size() << " mesh(es)" << std::endl;
 
-    BoundingBox boundingBox;
-    // Collect all triangles and compute bounding box
-    std::vector<Triangle> allTriangles;
+    // Collect all triangles, three corners each
+    std::vector<glm::vec3> allCorners;
     for (const auto& mesh : bunnyModel.meshes) {
-        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-            Triangle tri;
-            tri.v0 = glm::vec3(mesh.vertices[mesh.indices[i]].Position);
-            tri.v1 = glm::vec3(mesh.vertices[mesh.indices[i + 1]].Position);
-            tri.v2 = glm::vec3(mesh.vertices[mesh.indices[i + 2]].Position);
-            glm::vec3 edge1 = tri.v1 - tri.v0;
-            glm::vec3 edge2 = tri.v2 - tri.v0;
-            tri.normal = glm::normalize(glm::cross(edge1, edge2));
-            allTriangles.push_back(tri);
-            boundingBox.update(tri);
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            allCorners.push_back(mesh.vertices[mesh.indices[i]].Position);
+            allCorners.push_back(mesh.vertices[mesh.indices[i + 1]].Position);
+            allCorners.push_back(mesh.vertices[mesh.indices[i + 2]].Position);
         }
     }
     
-    std::cout << "Building BVH with " << allTriangles.size() << " triangles..." << std::endl;
-    BVH* bvh = new BVH(allTriangles);
-    std::cout << "BVH construction completed" << std::endl;
+    std::cout << "Building BVH with " << allCorners.size() / 3 << " triangles..." << std::endl;
+    BVH bvh;
+    buildBVH(bvh, allCorners);
+    
+    // One wireframe box, scaled to every node drawn; released before the context goes
+    auto unitBox = std::make_unique<BoundingBox>();
+    unitBox->update(glm::vec3(-0.5f));
+    unitBox->update(glm::vec3(0.5f));
     
     // Print controls
     std::cout << "\n=== CONTROLS ===" << std::endl;
@@ -313,9 +228,7 @@ int main()
         processInput(window);
         
         if (needsRebuild) {
-            delete bvh;
-            bvh = new BVH(allTriangles);
-            std::cout << "BVH rebuilt with depth " << MAX_DEPTH << std::endl;
+            buildBVH(bvh, allCorners);
             needsRebuild = false;
         }
         
@@ -330,7 +243,7 @@ int main()
             boxShader.use();
             boxShader.setMat4("projection", projection);
             boxShader.setMat4("view", view);
-            bvh->renderBVH(boxShader, currentViewDepth);
+            renderBVH(bvh, *unitBox, boxShader, currentViewDepth);
         }
 
         if (showModel) {
@@ -361,7 +274,7 @@ int main()
     }
     
     std::cout << "Cleaning up..." << std::endl;
-    delete bvh;
+    unitBox.reset();
     bunnyModel.meshes.clear();
     glfwTerminate();
     std::cout << "Test completed successfully!" << std::endl;
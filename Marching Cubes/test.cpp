@@ -9,6 +9,7 @@
 #include "../shader.h"
 #include "../camera.h"
 #include "CubeMarching.h"
+#include "../work_stealing_pool.h"
 #include <iostream>
 #include "../geometry/sphere.h"
 #include "../model.h"
@@ -73,6 +74,7 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 CubeMarching mc;
+WorkStealingPool marchPool; // full-mesh generation (G) meshes z-slabs in parallel
 Mesh marchingCubesMesh;
 int res = 16; // lower for stepwise view
 float isolevel = 0.0f;
@@ -213,7 +215,7 @@ int main() {
 
         if (generateAll) {
             mc.clearMesh();
-            mc.generateMesh(scalarField, isolevel);
+            mc.generateMesh(scalarField, isolevel, &marchPool);
             meshNeedsUpdate = true;
             generateAll = false;
         }
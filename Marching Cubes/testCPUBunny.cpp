@@ -8,7 +8,14 @@
 #include "../camera.h"
 #include "../model.h"
 #include "CubeMarching.h"
+#include "SurfaceNets.h"
+#include "../geometry/bvh.h"
+#include "../geometry/mesh_simplifier.h"
+#include "../work_stealing_pool.h"
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <string>
 #include <vector>
 
 const unsigned int SCR_WIDTH = 800;
@@ -22,102 +29,49 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Iso slider (Up/Down): SDF offset of the marched surface
+float isoLevel = 0.0f;
+bool isoChanged = false;
+const float isoSpeed = 0.01f; // SDF units per second
+
+// Extractor toggle (N): marching cubes or surface nets
+bool useSurfaceNets = false;
+bool nKeyHeld = false;
+
+// Decimation post-pass (X): keep 1, 1/2, 1/4 or 1/8 of the triangles
+int decimateShift = 0;
+bool xKeyHeld = false;
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 
-// Helper to compute distance from point to triangle and return closest point
-float distanceToTriangle(const glm::vec3& p, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, glm::vec3* outClosestPoint = nullptr) {
-    glm::vec3 edge0 = v1 - v0;
-    glm::vec3 edge1 = v2 - v0;
-    glm::vec3 v0p = p - v0;
-    
-    float a = glm::dot(edge0, edge0);
-    float b = glm::dot(edge0, edge1);
-    float c = glm::dot(edge1, edge1);
-    float d = glm::dot(edge0, v0p);
-    float e = glm::dot(edge1, v0p);
-    
-    float det = a * c - b * b;
-    float s = b * e - c * d;
-    float t = b * d - a * e;
-    
-    if (s + t <= det) {
-        if (s < 0.f) {
-            if (t < 0.f) {
-                s = glm::clamp(-d / a, 0.f, 1.f);
-                t = 0.f;
-            } else {
-                s = 0.f;
-                t = glm::clamp(-e / c, 0.f, 1.f);
-            }
-        } else if (t < 0.f) {
-            s = glm::clamp(-d / a, 0.f, 1.f);
-            t = 0.f;
-        } else {
-            float invDet = 1.f / det;
-            s *= invDet;
-            t *= invDet;
-        }
-    } else {
-        if (s < 0.f) {
-            s = 0.f;
-            t = glm::clamp((-e + b) / (c - b - c + a), 0.f, 1.f);
-        } else if (t < 0.f) {
-            t = 0.f;
-            s = glm::clamp((-d + b) / (a - b - a + c), 0.f, 1.f);
-        } else {
-            float numer = c + e - b - d;
-            float denom = a - 2.f * b + c;
-            s = glm::clamp(numer / denom, 0.f, 1.f);
-            t = 1.f - s;
-        }
-    }
-    
-    glm::vec3 closest = v0 + s * edge0 + t * edge1;
-    if (outClosestPoint) {
-        *outClosestPoint = closest;
-    }
-    return glm::distance(p, closest);
-}
-
 // Helper function to generate a signed distance field from a mesh
 std::vector<std::vector<std::vector<float>>> generateSDFFromMesh(
     const Model& model,
     int gridSizeX, int gridSizeY, int gridSizeZ,
-    glm::vec3& outBoundsMin, glm::vec3& outBoundsMax)
+    glm::vec3& outBoundsMin, glm::vec3& outBoundsMax,
+    WorkStealingPool& pool)
 {
-    // Collect all triangles with their normals
-    struct Triangle {
-        glm::vec3 v0, v1, v2;
-        glm::vec3 normal;
-    };
-    std::vector<Triangle> triangles;
+    // Collect all triangles, three corners each
+    std::vector<glm::vec3> corners;
     
     outBoundsMin = glm::vec3(1e10f);
     outBoundsMax = glm::vec3(-1e10f);
     
     for (const auto& mesh : model.meshes) {
-        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-            Triangle tri;
-            tri.v0 = mesh.vertices[mesh.indices[i]].Position;
-            tri.v1 = mesh.vertices[mesh.indices[i + 1]].Position;
-            tri.v2 = mesh.vertices[mesh.indices[i + 2]].Position;
-            
-            // Compute face normal
-            glm::vec3 edge1 = tri.v1 - tri.v0;
-            glm::vec3 edge2 = tri.v2 - tri.v0;
-            tri.normal = glm::normalize(glm::cross(edge1, edge2));
-            
-            triangles.push_back(tri);
-            
-            outBoundsMin = glm::min(outBoundsMin, glm::min(tri.v0, glm::min(tri.v1, tri.v2)));
-            outBoundsMax = glm::max(outBoundsMax, glm::max(tri.v0, glm::max(tri.v1, tri.v2)));
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                const glm::vec3& corner = mesh.vertices[mesh.indices[i + k]].Position;
+                corners.push_back(corner);
+                outBoundsMin = glm::min(outBoundsMin, corner);
+                outBoundsMax = glm::max(outBoundsMax, corner);
+            }
         }
     }
     
-    if (triangles.empty()) {
+    if (corners.empty()) {
         std::cerr << "Error: Model has no triangles!" << std::endl;
         return std::vector<std::vector<std::vector<float>>>();
     }
@@ -130,7 +84,14 @@ std::vector<std::vector<std::vector<float>>> generateSDFFromMesh(
     
     std::cout << "Mesh bounds: [" << outBoundsMin.x << ", " << outBoundsMin.y << ", " << outBoundsMin.z << "] to ["
               << outBoundsMax.x << ", " << outBoundsMax.y << ", " << outBoundsMax.z << "]" << std::endl;
-    std::cout << "Processing " << triangles.size() << " triangles..." << std::endl;
+    std::cout << "Processing " << corners.size() / 3 << " triangles..." << std::endl;
+    
+    // Closest-triangle queries go through a BVH instead of testing every triangle
+    BVH bvh;
+    auto bvhStart = std::chrono::high_resolution_clock::now();
+    bvh.build(corners);
+    double bvhMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - bvhStart).count();
+    std::cout << "BVH: " << bvh.nodeCount() << " nodes, depth " << bvh.getDepth() << ", built in " << bvhMs << " ms" << std::endl;
     
     // Create SDF grid (3D vector for CPU marching cubes)
     std::vector<std::vector<std::vector<float>>> sdfGrid(
@@ -146,46 +107,33 @@ std::vector<std::vector<std::vector<float>>> generateSDFFromMesh(
     float cellSizeY = gridSize.y / (gridSizeY - 1);
     float cellSizeZ = gridSize.z / (gridSizeZ - 1);
     
-    // Compute signed distance to closest triangle for each grid point
-    int totalPoints = gridSizeX * gridSizeY * gridSizeZ;
-    int processedPoints = 0;
-    
-    for (int z = 0; z < gridSizeZ; ++z) {
-        if (z % 4 == 0) {
-            std::cout << "Progress: " << (100 * processedPoints / totalPoints) << "%" << std::endl;
-        }
-        for (int y = 0; y < gridSizeY; ++y) {
-            for (int x = 0; x < gridSizeX; ++x) {
-                glm::vec3 gridPos = outBoundsMin + glm::vec3(
-                    x * cellSizeX,
-                    y * cellSizeY,
-                    z * cellSizeZ
-                );
+    // Compute signed distance to closest triangle for each grid point, one z-slice per task
+    std::atomic<int> slicesDone{0};
+    
+    pool.parallelFor(0, gridSizeZ, 1, [&](int firstZ, int lastZ) {
+        for (int z = firstZ; z < lastZ; ++z) {
+            for (int y = 0; y < gridSizeY; ++y) {
+                for (int x = 0; x < gridSizeX; ++x) {
+                    glm::vec3 gridPos = outBoundsMin + glm::vec3(
+                        x * cellSizeX,
+                        y * cellSizeY,
+                        z * cellSizeZ
+                    );
                 
-                // Find minimum distance to any triangle and track closest
-                float minDist = 1e10f;
-                glm::vec3 closestPoint;
-                glm::vec3 closestNormal;
+                    // Closest triangle, and which side of it the sample is on
+                    const BVH::PointHit closest = bvh.closestPoint(gridPos);
+                    glm::vec3 toPoint = gridPos - closest.point;
+                    float sign = glm::dot(toPoint, closest.faceNormal) < 0.0f ? -1.0f : 1.0f;
                 
-                for (const auto& tri : triangles) {
-                    glm::vec3 currentClosest;
-                    float dist = distanceToTriangle(gridPos, tri.v0, tri.v1, tri.v2, &currentClosest);
-                    if (dist < minDist) {
-                        minDist = dist;
-                        closestPoint = currentClosest;
-                        closestNormal = tri.normal;
-                    }
+                    sdfGrid[z][y][x] = sign * closest.distance;
                 }
-                
-                // Determine if point is inside using normal direction
-                glm::vec3 toPoint = gridPos - closestPoint;
-                float sign = glm::dot(toPoint, closestNormal) < 0.0f ? -1.0f : 1.0f;
-                
-                sdfGrid[z][y][x] = sign * minDist;
-                processedPoints++;
+            }
+            const int done = ++slicesDone;
+            if (done % 4 == 0) {
+                std::cout << ("Progress: " + std::to_string(100 * done / gridSizeZ) + "%\n") << std::flush;
             }
         }
-    }
+    });
     
     std::cout << "SDF generation complete!" << std::endl;
     return sdfGrid;
@@ -241,7 +189,8 @@ int main()
     // Generate SDF from bunny model
     std::cout << "Generating signed distance field from bunny model..." << std::endl;
     glm::vec3 boundsMin, boundsMax;
-    auto sdfGrid = generateSDFFromMesh(bunnyModel, gridSizeX, gridSizeY, gridSizeZ, boundsMin, boundsMax);
+    WorkStealingPool pool;
+    auto sdfGrid = generateSDFFromMesh(bunnyModel, gridSizeX, gridSizeY, gridSizeZ, boundsMin, boundsMax, pool);
     
     if (sdfGrid.empty()) {
         std::cerr << "Failed to generate SDF grid" << std::endl;
@@ -249,22 +198,56 @@ int main()
         return -1;
     }
     
+    // Flat copy of the SDF plus its min/max block summary, built once; every iso change
+    // then only marches the blocks around the surface
+    std::vector<float> sdfSamples;
+    sdfSamples.reserve(static_cast<size_t>(gridSizeX) * gridSizeY * gridSizeZ);
+    for (const auto& slice : sdfGrid)
+        for (const auto& row : slice)
+            sdfSamples.insert(sdfSamples.end(), row.begin(), row.end());
+    const ScalarFieldView sdfView = ScalarFieldView::dense(sdfSamples.data(), gridSizeX, gridSizeY, gridSizeZ);
+    const FieldBlockRanges sdfBlocks(sdfView);
+    
     std::cout << "Running CPU marching cubes..." << std::endl;
     CubeMarching mc;
-    mc.generateMesh(sdfGrid, 0.0f);  // Use isolevel 0.0 for signed distance
-    
-    std::cout << "Generated mesh: " << mc.getVertices().size() << " vertices, " 
-              << (mc.getIndices().size() / 3) << " triangles" << std::endl;
-    
+    mc.setMeshMode(MeshMode::SharedVertices);  // Shared vertices, smooth SDF-gradient normals
+    SurfaceNets nets;
     Mesh marchingCubesMesh;
-    const auto& vertices = mc.getVertices();
-    const auto& indices = mc.getIndices();
     
-    if (!vertices.empty() && !indices.empty()) {
+    auto remesh = [&]() {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (useSurfaceNets)
+            nets.generateMesh(sdfView, isoLevel, &sdfBlocks);
+        else
+            mc.generateMesh(sdfView, isoLevel, sdfBlocks, &pool);  // z-slabs in parallel, empty blocks skipped
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        
+        std::vector<Vertex> vertices = useSurfaceNets ? nets.getVertices() : mc.getVertices();
+        const auto& indices = useSurfaceNets ? nets.getIndices() : mc.getIndices();
+        std::cout << (useSurfaceNets ? "Surface nets" : "Marching cubes") << ", iso " << isoLevel << ": "
+                  << vertices.size() << " vertices, " << (indices.size() / 3) << " triangles in " << ms << " ms" << std::endl;
         std::vector<unsigned int> meshIndices(indices.begin(), indices.end());
-        std::vector<Texture> textures;
-        marchingCubesMesh = Mesh(vertices, meshIndices, textures);
-    }
+        if (decimateShift > 0 && !meshIndices.empty()) {
+            start = std::chrono::high_resolution_clock::now();
+            MeshSimplifier simplifier;
+            MeshSimplifier::Options options;
+            options.targetTriangles = meshIndices.size() / 3 >> decimateShift;
+            simplifier.simplify(vertices, meshIndices, options);
+            ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            std::cout << "Decimated to 1/" << (1 << decimateShift) << ": " << vertices.size() << " vertices, "
+                      << (meshIndices.size() / 3) << " triangles in " << ms << " ms, max error "
+                      << simplifier.getMaxError() << " cells" << std::endl;
+        }
+        // Re-meshed every frame while the iso keys are held, so free the old GL objects
+        marchingCubesMesh.releaseBuffers();
+        if (!vertices.empty() && !meshIndices.empty()) {
+            std::vector<Texture> textures;
+            marchingCubesMesh = Mesh(vertices, meshIndices, textures);
+        } else {
+            marchingCubesMesh = Mesh();
+        }
+    };
+    remesh();  // isolevel 0.0 is the bunny's surface
     
     std::cout << "Mesh ready for rendering. Starting render loop..." << std::endl;
     
@@ -275,6 +258,11 @@ int main()
         
         processInput(window);
         
+        if (isoChanged) {
+            remesh();
+            isoChanged = false;
+        }
+        
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
@@ -339,6 +327,29 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(UP, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, deltaTime);
+    
+    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
+        isoLevel += isoSpeed * deltaTime;
+        isoChanged = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
+        isoLevel -= isoSpeed * deltaTime;
+        isoChanged = true;
+    }
+    
+    const bool nKeyDown = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+    if (nKeyDown && !nKeyHeld) {
+        useSurfaceNets = !useSurfaceNets;
+        isoChanged = true;
+    }
+    nKeyHeld = nKeyDown;
+
+    const bool xKeyDown = glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS;
+    if (xKeyDown && !xKeyHeld) {
+        decimateShift = (decimateShift + 1) % 4;
+        isoChanged = true;
+    }
+    xKeyHeld = xKeyDown;
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
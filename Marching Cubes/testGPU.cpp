@@ -5,6 +5,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "GPUMarchCubes.h"
+#include "../geometry/bvh.h"
 #include "../model.h"
 #include "../shader.h"
 #include "../camera.h"
@@ -13,6 +14,7 @@
 #include <algorithm>
 #include <cmath>
 #include <chrono>
+#include <memory>
 
 const unsigned int SCR_WIDTH = 1200;
 const unsigned int SCR_HEIGHT = 900;
@@ -124,19 +126,6 @@ struct BoundingBox {
     }
 };
 
-struct Node {
-    BoundingBox bbox;
-    std::vector<Triangle> triangles;
-    Node* childA;
-    Node* childB;
-    bool isLeaf;
-
-    ~Node() {
-        delete childA;
-        delete childB;
-    }
-};
-
 // Helper to compute distance from point to triangle and return closest point
 float distanceToTriangle(const glm::vec3& p, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, glm::vec3* outClosestPoint = nullptr) {
     glm::vec3 edge0 = v1 - v0;
@@ -199,148 +188,33 @@ float distanceToTriangle(const glm::vec3& p, const glm::vec3& v0, const glm::vec
     return glm::distance(p, closest);
 }
 
-class BVH {
-public:
-    BoundingBox rootBBox;
-    Node* root;
-
-    BVH(const std::vector<Triangle>& triangles) {
-        root = buildBVH(triangles, 0);
-        rootBBox = root->bbox;
+// Draws the BVH nodes at one depth, scaling a unit box to each node's bounds
+void renderBVH(const BVH& bvh, BoundingBox& unitBox, Shader& shader, int targetDepth) {
+    glm::vec3 color;
+    switch (targetDepth % 6) {
+        case 0: color = glm::vec3(1.0f, 0.0f, 0.0f); break; // Red - Root
+        case 1: color = glm::vec3(0.0f, 1.0f, 0.0f); break; // Green - Level 1
+        case 2: color = glm::vec3(0.0f, 0.0f, 1.0f); break; // Blue - Level 2
+        case 3: color = glm::vec3(1.0f, 1.0f, 0.0f); break; // Yellow - Level 3
+        case 4: color = glm::vec3(1.0f, 0.0f, 1.0f); break; // Magenta - Level 4
+        case 5: color = glm::vec3(0.0f, 1.0f, 1.0f); break; // Cyan - Level 5
     }
-    
-    ~BVH() {
-        delete root;
-    }
-
-    void renderBVH(Shader& shader, int targetDepth) {
-        if (root) {
-            renderNodeRecursive(root, shader, 0, targetDepth);
-        }
-    }
-
-    float queryDistance(const glm::vec3& point, glm::vec3* outClosestPoint = nullptr, glm::vec3* outNormal = nullptr) {
-        if (!root) return 1e10f;
-        
-        float bestDist = 1e10f;
-        glm::vec3 bestPoint, bestNormal;
-        queryDistanceRecursive(root, point, bestDist, bestPoint, bestNormal);
-        
-        if (outClosestPoint) *outClosestPoint = bestPoint;
-        if (outNormal) *outNormal = bestNormal;
-        return bestDist;
-    }
-
-private:
-    void queryDistanceRecursive(Node* node, const glm::vec3& point, 
-                               float& bestDist, glm::vec3& bestPoint, glm::vec3& bestNormal) {
-        if (!node) return;
-        
-        // Early exit if bounding box is too far
-        float boxDist = distanceToBox(point, node->bbox.min, node->bbox.max);
-        if (boxDist > bestDist) return;
-        
-        if (node->isLeaf) {
-            // Test all triangles in this leaf
-            for (const auto& tri : node->triangles) {
-                glm::vec3 closestPoint;
-                float dist = distanceToTriangle(point, tri.v0, tri.v1, tri.v2, &closestPoint);
-                if (dist < bestDist) {
-                    bestDist = dist;
-                    bestPoint = closestPoint;
-                    bestNormal = tri.normal;
-                }
-            }
-        } else {
-            // Recurse to children
-            queryDistanceRecursive(node->childA, point, bestDist, bestPoint, bestNormal);
-            queryDistanceRecursive(node->childB, point, bestDist, bestPoint, bestNormal);
-        }
-    }
-    
-    float distanceToBox(const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax) {
-        glm::vec3 closest = glm::clamp(point, boxMin, boxMax);
-        return glm::distance(point, closest);
-    }
-
-    void renderNodeRecursive(Node* node, Shader& shader, int currentDepth, int targetDepth) {
-        if (!node) return;
-        if (currentDepth == targetDepth) {
-            glm::vec3 color;
-            switch (currentDepth % 6) {
-                case 0: color = glm::vec3(1.0f, 0.0f, 0.0f); break; // Red - Root
-                case 1: color = glm::vec3(0.0f, 1.0f, 0.0f); break; // Green - Level 1
-                case 2: color = glm::vec3(0.0f, 0.0f, 1.0f); break; // Blue - Level 2
-                case 3: color = glm::vec3(1.0f, 1.0f, 0.0f); break; // Yellow - Level 3
-                case 4: color = glm::vec3(1.0f, 0.0f, 1.0f); break; // Magenta - Level 4
-                case 5: color = glm::vec3(0.0f, 1.0f, 1.0f); break; // Cyan - Level 5
-            }
-            
-            glm::mat4 boxModel = glm::translate(glm::mat4(1.0f), node->bbox.center);
-            shader.setMat4("model", boxModel);
-            shader.setVec3("color", color);
-            
-            node->bbox.render();
-        }
-        
-        // Continue traversing children
-        if (currentDepth < targetDepth && !node->isLeaf) {
-            if (node->childA) renderNodeRecursive(node->childA, shader, currentDepth + 1, targetDepth);
-            if (node->childB) renderNodeRecursive(node->childB, shader, currentDepth + 1, targetDepth);
-        }
-    }
-    Node* buildBVH(const std::vector<Triangle>& triangles, int depth) {
-        Node* node = new Node();
-        for (const auto& tri : triangles) {
-            node->bbox.update(tri);
-        }
-
-        if (triangles.size() <= 2 || depth >= MAX_DEPTH) {
-            node->triangles = triangles;
-            node->isLeaf = true;
-            node->childA = nullptr;
-            node->childB = nullptr;
-            return node;
-        }
-
-        // Split along longest axis
-        glm::vec3 extent = node->bbox.max - node->bbox.min;
-        int axis = 0;
-        if (extent.y > extent.x && extent.y > extent.z) axis = 1;
-        else if (extent.z > extent.x) axis = 2;
-
-        float splitPos = node->bbox.min[axis] + extent[axis] * 0.5f;
-
-        std::vector<Triangle> leftTris, rightTris;
-        for (const auto& tri : triangles) {
-            float centroid = (tri.v0[axis] + tri.v1[axis] + tri.v2[axis]) / 3.0f;
-            if (centroid < splitPos) leftTris.push_back(tri);
-            else rightTris.push_back(tri);
-        }
-
-        // Where all triangles go to one side
-        if (leftTris.empty() || rightTris.empty()) {
-            leftTris.clear();
-            rightTris.clear();
-            for (size_t i = 0; i < triangles.size(); ++i) {
-                if (i < triangles.size() / 2) leftTris.push_back(triangles[i]);
-                else rightTris.push_back(triangles[i]);
-            }
-        }
-
-        node->childA = buildBVH(leftTris, depth + 1);
-        node->childB = buildBVH(rightTris, depth + 1);
-        node->isLeaf = false;
-        return node;
-    }
-};
+    shader.setVec3("color", color);
+
+    bvh.forEachNodeAtDepth(targetDepth, [&](const BVH::Node& node) {
+        glm::mat4 boxModel = glm::translate(glm::mat4(1.0f), (node.boundsMin + node.boundsMax) * 0.5f);
+        boxModel = glm::scale(boxModel, node.boundsMax - node.boundsMin);
+        shader.setMat4("model", boxModel);
+        unitBox.render();
+    });
+}
 
 // Helper function to generate a signed distance field from a mesh
 std::vector<float> generateSDFFromMesh(
     const Model& model,
     int gridSizeX, int gridSizeY, int gridSizeZ,
     glm::vec3& outBoundsMin, glm::vec3& outBoundsMax, 
-    BVH* modelBVH = nullptr)
+    const BVH* modelBVH = nullptr)
 {
     // Collect all triangles with their normals
     std::vector<Triangle> triangles;
@@ -415,7 +289,10 @@ std::vector<float> generateSDFFromMesh(
                 
                 if (modelBVH) {
                     // Use BVH for fast distance queries
-                    minDist = modelBVH->queryDistance(gridPos, &closestPoint, &closestNormal);
+                    const BVH::PointHit closest = modelBVH->closestPoint(gridPos);
+                    minDist = closest.distance;
+                    closestPoint = closest.point;
+                    closestNormal = closest.faceNormal;
                 } else {
                     // Fallback to brute force
                     minDist = 1e10f;
@@ -521,8 +398,26 @@ int main()
     }
     
     std::cout << "Building BVH with " << allTriangles.size() << " triangles..." << std::endl;
-    BVH* bvh = new BVH(allTriangles);
-    std::cout << "BVH construction completed" << std::endl;
+    std::vector<glm::vec3> allCorners;
+    allCorners.reserve(allTriangles.size() * 3);
+    for (const auto& tri : allTriangles) {
+        allCorners.push_back(tri.v0);
+        allCorners.push_back(tri.v1);
+        allCorners.push_back(tri.v2);
+    }
+    BVH::Options bvhOptions;
+    bvhOptions.maxDepth = MAX_DEPTH;
+    BVH bvh;
+    auto bvhStart = std::chrono::high_resolution_clock::now();
+    bvh.build(allCorners, bvhOptions);
+    double bvhMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - bvhStart).count();
+    std::cout << "BVH construction completed: " << bvh.nodeCount() << " nodes, depth " << bvh.getDepth()
+              << ", " << bvhMs << " ms" << std::endl;
+
+    // One wireframe box, scaled to every node drawn; released before the context goes
+    auto unitBox = std::make_unique<BoundingBox>();
+    unitBox->update(glm::vec3(-0.5f));
+    unitBox->update(glm::vec3(0.5f));
     
     // Set grid resolution (higher = more detail)
     int gridSizeX = 80;
@@ -533,7 +428,7 @@ int main()
     glm::vec3 boundsMin, boundsMax;
     
     auto startTime = std::chrono::high_resolution_clock::now();
-    std::vector<float> sdfGrid = generateSDFFromMesh(bunnyModel, gridSizeX, gridSizeY, gridSizeZ, boundsMin, boundsMax, bvh);
+    std::vector<float> sdfGrid = generateSDFFromMesh(bunnyModel, gridSizeX, gridSizeY, gridSizeZ, boundsMin, boundsMax, &bvh);
     auto endTime = std::chrono::high_resolution_clock::now();
     
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
@@ -663,7 +558,7 @@ int main()
             boxShader.use();
             boxShader.setMat4("projection", projection);
             boxShader.setMat4("view", view);
-            bvh->renderBVH(boxShader, MAX_DEPTH);
+            renderBVH(bvh, *unitBox, boxShader, MAX_DEPTH);
         }
                 
         glfwSwapBuffers(window);
@@ -671,6 +566,7 @@ int main()
     }
     
     std::cout << "Cleaning up..." << std::endl;
+    unitBox.reset();
     glDeleteBuffers(1, &marchVBO);
     glDeleteBuffers(1, &marchEBO);
     glDeleteVertexArrays(1, &marchVAO);
@@ -0,0 +1,194 @@
+// Out-of-core marching cubes: meshes a raw float32 volume (x fastest, native byte
+// order) slab by slab from a memory map and streams the triangles to a PLY or OBJ file,
+// so volumes larger than RAM can be meshed.
+//
+// Usage:
+//   StreamMarch <volume.raw> <sizeX> <sizeY> <sizeZ> <out.ply|out.obj>
+//               [--iso V] [--slab N] [--shared] [--threads N] [--check]
+//   StreamMarch --make-sphere <out.raw> <size>
+//
+// --check also meshes the volume in memory (small volumes only) and compares counts, then
+// does the same for a 40^3 volume of whole-number distances at iso 12, whose vertices sit
+// exactly on sample points and so on the planes between slabs.
+// --make-sphere writes a signed-distance sphere volume, one slice at a time, to try it on.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CubeMarching.h"
+#include "MappedVolume.h"
+#include "MeshSink.h"
+#include "StreamingMarcher.h"
+#include "work_stealing_pool.h"
+
+namespace {
+
+int usage() {
+    std::cerr << "Usage: StreamMarch <volume.raw> <sizeX> <sizeY> <sizeZ> <out.ply|out.obj>\n"
+                 "                   [--iso V] [--slab N] [--shared] [--threads N] [--check]\n"
+                 "       StreamMarch --make-sphere <out.raw> <size>\n";
+    return 1;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Counts what it is given and writes nothing
+class CountingSink : public MeshSink {
+public:
+    void addVertex(const Vertex&) override { ++vertexCount_; }
+    void addTriangle(int, int, int) override { ++triangleCount_; }
+    bool finish() override { return true; }
+};
+
+// Write a size^3 volume of value(x, y, z) one slice at a time
+template <typename Value>
+bool writeVolume(const std::string& path, int size, Value value) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write volume: " << path << std::endl;
+        return false;
+    }
+    std::vector<float> slice(static_cast<size_t>(size) * size);
+    for (int z = 0; z < size; ++z) {
+        size_t i = 0;
+        for (int y = 0; y < size; ++y)
+            for (int x = 0; x < size; ++x)
+                slice[i++] = value(x, y, z);
+        out.write(reinterpret_cast<const char*>(slice.data()), static_cast<std::streamsize>(slice.size() * sizeof(float)));
+    }
+    out.close();
+    if (!out) {
+        std::cerr << "Failed writing volume: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int makeSphere(const std::string& path, int size) {
+    const float inv = 1.0f / static_cast<float>(size - 1);
+    const bool written = writeVolume(path, size, [inv](int x, int y, int z) {
+        const float dx = x * inv - 0.5f, dy = y * inv - 0.5f, dz = z * inv - 0.5f;
+        return std::sqrt(dx * dx + dy * dy + dz * dz) - 0.4f;
+    });
+    if (!written) return 1;
+    std::cout << "Wrote " << size << "^3 sphere volume to " << path << "\n";
+    return 0;
+}
+
+// Mesh the mapped volume in memory and compare with what the marcher streamed
+bool matchesInMemory(MappedVolume& volume, const StreamingMarcher& marcher, float isoLevel) {
+    // The in-memory reference needs the whole field resident
+    const ScalarFieldView whole = volume.mapSlices(0, volume.sizeZ() - 1);
+    if (!whole.data) return false;
+    CubeMarching reference;
+    reference.setMeshMode(marcher.getMeshMode());
+    reference.generateMesh(whole, isoLevel);
+    const StreamingMarcher::Stats& stats = marcher.getStats();
+    const bool match = reference.getVertices().size() == stats.vertices &&
+                       reference.getTriangleCount() == stats.triangles;
+    std::cout << "In-memory mesh: " << reference.getVertices().size() << " vertices, "
+              << reference.getTriangleCount() << " triangles, " << (match ? "match" : "MISMATCH") << "\n";
+    return match;
+}
+
+// Whole-number distances from the centre: with an integer iso every vertex lands on a
+// sample, and slab seams must still join by grid edge rather than by position
+bool checkIntegerVolume(const std::string& path, int slabLayers, MeshMode mode, WorkStealingPool* pool) {
+    const int size = 40;
+    const float isoLevel = 12.0f;
+    const float centre = 0.5f * (size - 1);
+    const bool written = writeVolume(path, size, [centre](int x, int y, int z) {
+        const float dx = x - centre, dy = y - centre, dz = z - centre;
+        return std::floor(std::sqrt(dx * dx + dy * dy + dz * dz));
+    });
+    if (!written) return false;
+
+    bool match = false;
+    {
+        MappedVolume volume;
+        StreamingMarcher marcher(slabLayers);
+        marcher.setMeshMode(mode);
+        CountingSink sink;
+        if (volume.open(path, size, size, size) && marcher.march(volume, isoLevel, sink, pool)) {
+            std::cout << "Integer volume " << size << "^3 at iso " << isoLevel << ": "
+                      << marcher.getStats().vertices << " vertices, " << marcher.getStats().triangles
+                      << " triangles streamed\n";
+            match = matchesInMemory(volume, marcher, isoLevel);
+        }
+    }
+    std::remove(path.c_str());
+    return match;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 4 && std::string(argv[1]) == "--make-sphere")
+        return makeSphere(argv[2], std::max(2, std::atoi(argv[3])));
+    if (argc < 6) return usage();
+
+    const std::string volumePath = argv[1];
+    const int sizeX = std::atoi(argv[2]), sizeY = std::atoi(argv[3]), sizeZ = std::atoi(argv[4]);
+    const std::string outPath = argv[5];
+    float isoLevel = 0.0f;
+    int slabLayers = StreamingMarcher::kDefaultSlabLayers;
+    int threads = 1;
+    bool shared = false, check = false;
+    for (int i = 6; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--iso" && i + 1 < argc) isoLevel = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--slab" && i + 1 < argc) slabLayers = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--shared") shared = true;
+        else if (arg == "--check") check = true;
+        else return usage();
+    }
+
+    MappedVolume volume;
+    if (!volume.open(volumePath, sizeX, sizeY, sizeZ)) return 1;
+
+    std::unique_ptr<MeshSink> sink;
+    if (endsWith(outPath, ".obj")) {
+        auto obj = std::make_unique<ObjMeshSink>();
+        if (!obj->open(outPath)) return 1;
+        sink = std::move(obj);
+    } else {
+        auto ply = std::make_unique<PlyMeshSink>();
+        if (!ply->open(outPath)) return 1;
+        sink = std::move(ply);
+    }
+
+    WorkStealingPool pool(threads);
+    StreamingMarcher marcher(slabLayers);
+    marcher.setMeshMode(shared ? MeshMode::SharedVertices : MeshMode::FlatShaded);
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    if (!marcher.march(volume, isoLevel, *sink, threads > 1 ? &pool : nullptr) || !sink->finish()) return 1;
+    const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    const StreamingMarcher::Stats& stats = marcher.getStats();
+    const double volumeMb = static_cast<double>(volume.sliceBytes()) * sizeZ / 1048576.0;
+    std::cout << "Meshed " << sizeX << "x" << sizeY << "x" << sizeZ << " (" << volumeMb << " MB) in "
+              << stats.slabs << " slabs of " << slabLayers << " layers, " << seconds << " s\n"
+              << stats.vertices << " vertices, " << stats.triangles << " triangles -> " << outPath << "\n"
+              << "Peak window " << stats.peakWindowBytes / 1048576.0 << " MB, peak slab mesh "
+              << stats.peakMeshBytes / 1048576.0 << " MB\n";
+
+    if (check) {
+        if (!matchesInMemory(volume, marcher, isoLevel)) return 1;
+        if (!checkIntegerVolume(outPath + ".steps.raw", slabLayers, marcher.getMeshMode(),
+                                threads > 1 ? &pool : nullptr))
+            return 1;
+    }
+    return 0;
+}
@@ -4,10 +4,12 @@
 #include <glm/glm.hpp>
 
 #include <optional>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "../camera.h"
+#include "../geometry/bvh.h"
 #include "../mesh.h"
 #include "../model.h"
 #include "globals.h"
@@ -25,15 +27,23 @@ public:
 
     MouseSelector(Camera& camera, float nearPlane = 0.1f, float farPlane = 100.0f);
 
+    // Rays are tested against a BVH of each mesh, built on the first ray that reaches it.
+    // The mesh must outlive the selectable, and after changing its vertices or indices call
+    // refreshMesh; moving the object only needs updateSelectableTransform.
     ID addSelectable(const Model& model, const glm::mat4& transform = glm::mat4(1.0f));
     
     ID addSelectable(const Mesh& mesh, const glm::mat4& transform = glm::mat4(1.0f));
     
+    // Also drops the cached BVHs of the selectable's meshes
     bool removeSelectable(ID id);
     
     void updateSelectableTransform(ID id, const glm::mat4& transform);
     
     void clearSelection();
+
+    // Drop the cached BVH of a mesh whose vertices or indices changed; the next ray rebuilds
+    // it. This is the only way a cached BVH is invalidated.
+    void refreshMesh(const Mesh& mesh) { meshBVHs.erase(&mesh); }
     
     void setSelection(ID id) { selectedId = id; }
     
@@ -63,16 +73,15 @@ private:
     std::optional<ID> selectedId;
     mutable glm::vec3 lastIntersectionPoint{0.0f};
     bool mousePressedLastFrame{false};
+    // Per-mesh BVH in mesh space, built on the first ray that reaches the mesh and kept
+    // until refreshMesh or removeSelectable
+    mutable std::unordered_map<const Mesh*, BVH> meshBVHs;
 
     glm::vec3 calculateRayDirection(const std::pair<int, int>& screenSize, 
                                     const std::pair<int, int>& mousePos) const;
     
-    std::pair<bool, float> rayIntersectsTriangle(const glm::vec3& rayOrigin,
-                                                 const glm::vec3& rayDir,
-                                                 const glm::vec3& v0,
-                                                 const glm::vec3& v1,
-                                                 const glm::vec3& v2) const;
-    
+    void forgetMeshes(const Selectable& selectable);
+
     std::optional<std::pair<ID, float>> testModel(const glm::vec3& rayOrigin,
                                                  const glm::vec3& rayDir,
                                                  const Selectable& selectable) const;
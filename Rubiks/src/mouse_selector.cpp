@@ -6,13 +6,8 @@
 
 #include <algorithm>
 #include <cmath>
-#include <limits>
 #include <unordered_set>
 
-namespace {
-constexpr float kEpsilon = 1e-6f;
-}
-
 MouseSelector::MouseSelector(Camera& cam, float nearPlaneDistance, float farPlaneDistance)
     : camera(&cam), nearPlane(nearPlaneDistance), farPlane(farPlaneDistance) {}
 
@@ -29,11 +24,12 @@ ID MouseSelector::addSelectable(const Mesh& mesh, const glm::mat4& transform) {
 }
 
 bool MouseSelector::removeSelectable(ID id) {
-    auto it = std::remove_if(selectables.begin(), selectables.end(), [id](const Selectable& selectable) {
+    auto it = std::find_if(selectables.begin(), selectables.end(), [id](const Selectable& selectable) {
         return selectable.id == id;
     });
     if (it != selectables.end()) {
-        selectables.erase(it, selectables.end());
+        forgetMeshes(*it);
+        selectables.erase(it);
         if (selectedId && *selectedId == id) {
             selectedId.reset();
         }
@@ -42,6 +38,17 @@ bool MouseSelector::removeSelectable(ID id) {
     return false;
 }
 
+void MouseSelector::forgetMeshes(const Selectable& selectable) {
+    if (selectable.mesh) {
+        meshBVHs.erase(selectable.mesh);
+    }
+    if (selectable.model) {
+        for (const auto& mesh : selectable.model->meshes) {
+            meshBVHs.erase(&mesh);
+        }
+    }
+}
+
 void MouseSelector::updateSelectableTransform(ID id, const glm::mat4& transform) {
     for (auto& selectable : selectables) {
         if (selectable.id == id) {
@@ -130,56 +137,6 @@ glm::vec3 MouseSelector::calculateRayDirection(const std::pair<int, int>& screen
 }
 
 
-std::pair<bool, float> MouseSelector::rayIntersectsTriangle(const glm::vec3& rayOrigin,
-                                                            const glm::vec3& rayDir,
-                                                            const glm::vec3& v0,
-                                                            const glm::vec3& v1,
-                                                            const glm::vec3& v2) const {
-    // Compute edge vectors from v0
-    glm::vec3 edge1 = v1 - v0;
-    glm::vec3 edge2 = v2 - v0;
-    
-    // Begin calculating determinant (also used to calculate u parameter)
-    glm::vec3 h = glm::cross(rayDir, edge2);
-    float det = glm::dot(edge1, h);
-    
-    // If determinant is near zero, ray lies in plane of triangle
-    if (std::abs(det) < kEpsilon) {
-        return {false, 0.0f};
-    }
-
-    float invDet = 1.0f / det;
-    
-    // Calculate distance from v0 to ray origin
-    glm::vec3 s = rayOrigin - v0;
-    
-    // Calculate u parameter and test bounds
-    float u = invDet * glm::dot(s, h);
-    if (u < 0.0f || u > 1.0f) {
-        return {false, 0.0f};
-    }
-
-    // Prepare to test v parameter
-    glm::vec3 q = glm::cross(s, edge1);
-    
-    // Calculate v parameter and test bounds
-    float v = invDet * glm::dot(rayDir, q);
-    if (v < 0.0f || u + v > 1.0f) {
-        return {false, 0.0f};
-    }
-
-    // Calculate t (distance along ray to intersection)
-    float t = invDet * glm::dot(edge2, q);
-    
-    // Ray intersection (t must be positive - in front of camera)
-    if (t > kEpsilon) {
-        return {true, t};
-    }
-    
-    return {false, 0.0f};
-}
-
-
 std::optional<std::pair<ID, float>> MouseSelector::testModel(const glm::vec3& rayOrigin,
                                                              const glm::vec3& rayDir,
                                                              const Selectable& selectable) const {
@@ -202,37 +159,28 @@ std::optional<std::pair<ID, float>> MouseSelector::testModel(const glm::vec3& ra
 std::optional<std::pair<ID, float>> MouseSelector::testMesh(const glm::vec3& rayOrigin,
                                                             const glm::vec3& rayDir,
                                                             const Selectable& selectable) const {
-    if (!selectable.mesh) {
+    // A singular transform (e.g. zero scale to hide an object) has no inverse to cast
+    // the ray through; such an object covers no area, so it is never hit
+    if (!selectable.mesh || glm::determinant(selectable.transform) == 0.0f) {
         return std::nullopt;
     }
 
     const auto& mesh = *selectable.mesh;
-    float closestDistance = std::numeric_limits<float>::max();
-    bool hit = false;
-
-    // Iterate through triangles (3 indices per triangle)
-    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
-        // Get vertex data
-        Vertex v0 = mesh.vertices[mesh.indices[i]];
-        Vertex v1 = mesh.vertices[mesh.indices[i + 1]];
-        Vertex v2 = mesh.vertices[mesh.indices[i + 2]];
-
-        // Transform vertices to world space
-        glm::vec3 p0 = glm::vec3(selectable.transform * glm::vec4(v0.Position, 1.0f));
-        glm::vec3 p1 = glm::vec3(selectable.transform * glm::vec4(v1.Position, 1.0f));
-        glm::vec3 p2 = glm::vec3(selectable.transform * glm::vec4(v2.Position, 1.0f));
-
-        // Test intersection
-        auto [intersects, distance] = rayIntersectsTriangle(rayOrigin, rayDir, p0, p1, p2);
-        if (intersects && distance < closestDistance) {
-            closestDistance = distance;
-            hit = true;
-            lastIntersectionPoint = rayOrigin + rayDir * distance;
-        }
+    auto [cached, inserted] = meshBVHs.try_emplace(&mesh);
+    if (inserted) {
+        cached->second.build(mesh.vertices, mesh.indices);
     }
 
-    if (hit) {
-        return std::make_pair(selectable.id, closestDistance);
+    // Cast in mesh space; an affine transform keeps the ray parameter, so the hit
+    // distance is still in units of the world-space direction
+    const glm::mat4 toMesh = glm::inverse(selectable.transform);
+    const glm::vec3 meshOrigin = glm::vec3(toMesh * glm::vec4(rayOrigin, 1.0f));
+    const glm::vec3 meshDir = glm::vec3(toMesh * glm::vec4(rayDir, 0.0f));
+
+    BVH::RayHit hit;
+    if (cached->second.intersect(meshOrigin, meshDir, hit)) {
+        lastIntersectionPoint = rayOrigin + rayDir * hit.distance;
+        return std::make_pair(selectable.id, hit.distance);
     }
     return std::nullopt;
 }
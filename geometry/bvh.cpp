@@ -0,0 +1,381 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+static_assert(sizeof(BVH::Node) == 32, "BVH nodes are meant to be two per cache line");
+
+namespace {
+
+constexpr float kEpsilon = 1e-6f;
+
+// Entry distance of a ray into a box, or infinity if it misses within [0, maxDistance)
+float rayBoxEntry(const glm::vec3& origin, const glm::vec3& inverseDirection, const BVH::Node& node, float maxDistance)
+{
+    const glm::vec3 t0 = (node.boundsMin - origin) * inverseDirection;
+    const glm::vec3 t1 = (node.boundsMax - origin) * inverseDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+    const float tEntry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return tEntry <= tExit ? tEntry : std::numeric_limits<float>::infinity();
+}
+
+float boxDistance2(const glm::vec3& point, const BVH::Node& node)
+{
+    const glm::vec3 d = point - glm::clamp(point, node.boundsMin, node.boundsMax);
+    return glm::dot(d, d);
+}
+
+// Closest point on triangle v0 v1 v2 to p (Ericson, Real-Time Collision Detection 5.1.5)
+glm::vec3 closestOnTriangle(const glm::vec3& p, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+    const glm::vec3 ab = v1 - v0, ac = v2 - v0, ap = p - v0;
+    const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return v0;
+
+    const glm::vec3 bp = p - v1;
+    const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return v1;
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return v0 + ab * (d1 / (d1 - d3));
+
+    const glm::vec3 cp = p - v2;
+    const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return v2;
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return v0 + ac * (d2 / (d2 - d6));
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return v1 + (v2 - v1) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    const float denominator = va + vb + vc;
+    if (denominator == 0.0f) return v0; // degenerate triangle
+    const float inverse = 1.0f / denominator;
+    return v0 + ab * (vb * inverse) + ac * (vc * inverse);
+}
+
+template <typename Index>
+std::vector<glm::vec3> gatherCorners(const std::vector<Vertex>& vertices, const std::vector<Index>& indices)
+{
+    std::vector<glm::vec3> corners;
+    corners.reserve(indices.size() - indices.size() % 3);
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+        for (int k = 0; k < 3; ++k)
+            corners.push_back(vertices[indices[i + k]].Position);
+    return corners;
+}
+
+} // namespace
+
+float BVH::Bounds::area() const
+{
+    const glm::vec3 e = max - min;
+    if (e.x < 0.0f) return 0.0f; // empty
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+void BVH::build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    build(gatherCorners(vertices, indices));
+}
+
+void BVH::build(const std::vector<Vertex>& vertices, const std::vector<int>& indices)
+{
+    build(gatherCorners(vertices, indices));
+}
+
+void BVH::build(const std::vector<glm::vec3>& corners)
+{
+    build(corners, Options());
+}
+
+void BVH::build(const std::vector<glm::vec3>& corners, const Options& options)
+{
+    clear();
+    options_ = options;
+    options_.maxLeafTriangles = std::max(1, options_.maxLeafTriangles);
+    options_.maxDepth = std::min(std::max(0, options_.maxDepth), kStackSize - 2);
+
+    const std::uint32_t count = static_cast<std::uint32_t>(corners.size() / 3);
+    if (count == 0) return;
+
+    triangleBounds_.resize(count);
+    centroids_.resize(count);
+    order_.resize(count);
+    for (std::uint32_t t = 0; t < count; ++t)
+    {
+        Bounds& bounds = triangleBounds_[t];
+        bounds = Bounds();
+        for (int k = 0; k < 3; ++k) bounds.grow(corners[t * 3 + k]);
+        centroids_[t] = (corners[t * 3] + corners[t * 3 + 1] + corners[t * 3 + 2]) * (1.0f / 3.0f);
+        order_[t] = t;
+    }
+
+    // A binary tree over n leaves of at least one triangle has at most 2n - 1 nodes
+    nodes_.reserve(static_cast<std::size_t>(count) * 2 - 1);
+    nodes_.push_back(Node());
+    subdivide(0, 0, count, 0);
+    nodes_.shrink_to_fit();
+
+    // Corners in leaf order so a leaf's triangles sit next to each other
+    corners_.resize(static_cast<std::size_t>(count) * 3);
+    for (std::uint32_t slot = 0; slot < count; ++slot)
+        for (int k = 0; k < 3; ++k)
+            corners_[slot * 3 + k] = corners[order_[slot] * 3 + k];
+
+    triangleBounds_.clear();
+    triangleBounds_.shrink_to_fit();
+    centroids_.clear();
+    centroids_.shrink_to_fit();
+}
+
+void BVH::clear()
+{
+    nodes_.clear();
+    order_.clear();
+    corners_.clear();
+    depth_ = 0;
+}
+
+void BVH::subdivide(std::uint32_t nodeIndex, std::uint32_t begin, std::uint32_t end, int depth)
+{
+    depth_ = std::max(depth_, depth);
+    const std::uint32_t count = end - begin;
+
+    Bounds bounds, centroidBounds;
+    for (std::uint32_t i = begin; i < end; ++i)
+    {
+        bounds.grow(triangleBounds_[order_[i]]);
+        centroidBounds.grow(centroids_[order_[i]]);
+    }
+    nodes_[nodeIndex].boundsMin = bounds.min;
+    nodes_[nodeIndex].boundsMax = bounds.max;
+
+    auto makeLeaf = [&] {
+        nodes_[nodeIndex].first = begin;
+        nodes_[nodeIndex].count = count;
+    };
+    if (count <= 1 || depth >= options_.maxDepth)
+    {
+        makeLeaf();
+        return;
+    }
+
+    // Binned SAH: cost of a split = sum over both sides of area * triangles, in units
+    // of the parent's area; a leaf costs its triangle count plus nothing to traverse
+    int bestAxis = -1, bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    const glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+    glm::vec3 scale;
+    for (int axis = 0; axis < 3; ++axis) scale[axis] = extent[axis] > 0.0f ? kBins / extent[axis] : 0.0f;
+
+    // One pass bins every triangle on all three axes
+    Bounds binBounds[3][kBins];
+    std::uint32_t binCounts[3][kBins] = {};
+    for (std::uint32_t i = begin; i < end; ++i)
+    {
+        const std::uint32_t t = order_[i];
+        const glm::vec3 offset = (centroids_[t] - centroidBounds.min) * scale;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const int bin = std::min(kBins - 1, static_cast<int>(offset[axis]));
+            ++binCounts[axis][bin];
+            binBounds[axis][bin].grow(triangleBounds_[t]);
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (extent[axis] <= 0.0f) continue;
+
+        // Sweep from the right to get the area and count of every right side
+        float rightArea[kBins - 1];
+        std::uint32_t rightCount[kBins - 1];
+        Bounds right;
+        std::uint32_t rightTotal = 0;
+        for (int split = kBins - 1; split > 0; --split)
+        {
+            right.grow(binBounds[axis][split]);
+            rightTotal += binCounts[axis][split];
+            rightArea[split - 1] = right.area();
+            rightCount[split - 1] = rightTotal;
+        }
+        Bounds left;
+        std::uint32_t leftTotal = 0;
+        for (int split = 1; split < kBins; ++split)
+        {
+            left.grow(binBounds[axis][split - 1]);
+            leftTotal += binCounts[axis][split - 1];
+            if (leftTotal == 0 || rightCount[split - 1] == 0) continue;
+            const float cost = left.area() * leftTotal + rightArea[split - 1] * rightCount[split - 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    const float parentArea = bounds.area();
+    const float splitCost = parentArea > 0.0f ? 1.0f + bestCost / parentArea : 1.0f;
+    const bool worthSplitting = bestAxis >= 0 && splitCost < static_cast<float>(count);
+    if (!worthSplitting && count <= static_cast<std::uint32_t>(options_.maxLeafTriangles))
+    {
+        makeLeaf();
+        return;
+    }
+
+    std::uint32_t middle;
+    if (bestAxis >= 0)
+    {
+        const float axisScale = scale[bestAxis];
+        const float origin = centroidBounds.min[bestAxis];
+        middle = static_cast<std::uint32_t>(
+            std::partition(order_.begin() + begin, order_.begin() + end, [&](std::uint32_t t) {
+                return std::min(kBins - 1, static_cast<int>((centroids_[t][bestAxis] - origin) * axisScale)) < bestSplit;
+            }) - order_.begin());
+    }
+    else
+    {
+        // All centroids coincide: halve the run so oversized leaves still split
+        middle = begin + count / 2;
+    }
+
+    const std::uint32_t leftIndex = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back(Node());
+    subdivide(leftIndex, begin, middle, depth + 1);
+    const std::uint32_t rightIndex = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back(Node());
+    subdivide(rightIndex, middle, end, depth + 1);
+    nodes_[nodeIndex].first = rightIndex;
+    nodes_[nodeIndex].count = 0;
+}
+
+bool BVH::intersect(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit, float maxDistance) const
+{
+    if (nodes_.empty()) return false;
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    float nearest = maxDistance;
+    bool found = false;
+
+    std::uint32_t stack[kStackSize];
+    int top = 0;
+    if (rayBoxEntry(origin, inverseDirection, nodes_[0], nearest) == std::numeric_limits<float>::infinity())
+        return false;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const std::uint32_t index = stack[--top];
+        const Node& node = nodes_[index];
+        if (node.isLeaf())
+        {
+            // Moller-Trumbore
+            for (std::uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+            {
+                const glm::vec3& v0 = corners_[slot * 3];
+                const glm::vec3 edge1 = corners_[slot * 3 + 1] - v0;
+                const glm::vec3 edge2 = corners_[slot * 3 + 2] - v0;
+                const glm::vec3 h = glm::cross(direction, edge2);
+                const float det = glm::dot(edge1, h);
+                if (std::fabs(det) < kEpsilon) continue;
+                const float invDet = 1.0f / det;
+                const glm::vec3 s = origin - v0;
+                const float u = invDet * glm::dot(s, h);
+                if (u < 0.0f || u > 1.0f) continue;
+                const glm::vec3 q = glm::cross(s, edge1);
+                const float v = invDet * glm::dot(direction, q);
+                if (v < 0.0f || u + v > 1.0f) continue;
+                const float t = invDet * glm::dot(edge2, q);
+                if (t > kEpsilon && t < nearest)
+                {
+                    nearest = t;
+                    hit.distance = t;
+                    hit.triangle = order_[slot];
+                    hit.u = u;
+                    hit.v = v;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first; the other is culled if a hit comes before it
+        std::uint32_t nearChild = index + 1, farChild = node.first;
+        float nearEntry = rayBoxEntry(origin, inverseDirection, nodes_[nearChild], nearest);
+        float farEntry = rayBoxEntry(origin, inverseDirection, nodes_[farChild], nearest);
+        if (farEntry < nearEntry)
+        {
+            std::swap(nearChild, farChild);
+            std::swap(nearEntry, farEntry);
+        }
+        if (farEntry != std::numeric_limits<float>::infinity()) stack[top++] = farChild;
+        if (nearEntry != std::numeric_limits<float>::infinity()) stack[top++] = nearChild;
+    }
+    return found;
+}
+
+BVH::PointHit BVH::closestPoint(const glm::vec3& point) const
+{
+    PointHit best;
+    if (nodes_.empty()) return best;
+    float bestDistance2 = std::numeric_limits<float>::infinity();
+
+    std::uint32_t stack[kStackSize];
+    float stackDistance2[kStackSize];
+    int top = 0;
+    stack[top] = 0;
+    stackDistance2[top++] = boxDistance2(point, nodes_[0]);
+    while (top > 0)
+    {
+        --top;
+        if (stackDistance2[top] >= bestDistance2) continue;
+        const std::uint32_t index = stack[top];
+        const Node& node = nodes_[index];
+        if (node.isLeaf())
+        {
+            for (std::uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+            {
+                const glm::vec3& v0 = corners_[slot * 3];
+                const glm::vec3& v1 = corners_[slot * 3 + 1];
+                const glm::vec3& v2 = corners_[slot * 3 + 2];
+                const glm::vec3 closest = closestOnTriangle(point, v0, v1, v2);
+                const glm::vec3 d = point - closest;
+                const float distance2 = glm::dot(d, d);
+                if (distance2 < bestDistance2)
+                {
+                    bestDistance2 = distance2;
+                    best.triangle = order_[slot];
+                    best.point = closest;
+                    best.faceNormal = glm::cross(v1 - v0, v2 - v0);
+                }
+            }
+            continue;
+        }
+
+        std::uint32_t nearChild = index + 1, farChild = node.first;
+        float nearDistance2 = boxDistance2(point, nodes_[nearChild]);
+        float farDistance2 = boxDistance2(point, nodes_[farChild]);
+        if (farDistance2 < nearDistance2)
+        {
+            std::swap(nearChild, farChild);
+            std::swap(nearDistance2, farDistance2);
+        }
+        if (farDistance2 < bestDistance2)
+        {
+            stack[top] = farChild;
+            stackDistance2[top++] = farDistance2;
+        }
+        if (nearDistance2 < bestDistance2)
+        {
+            stack[top] = nearChild;
+            stackDistance2[top++] = nearDistance2;
+        }
+    }
+    best.distance = std::sqrt(bestDistance2);
+    return best;
+}
@@ -0,0 +1,133 @@
+/**
+ * BVH - flat bounding volume hierarchy over a triangle list
+ *
+ * Built top-down with a binned surface area heuristic (SAH): at every node the
+ * triangle centroids are dropped into bins along each axis and the plane between
+ * two bins with the lowest expected ray cost wins. The builder only reorders an
+ * array of triangle ids in place; no triangles are copied while splitting.
+ *
+ * Nodes live in one array in depth-first order, 32 bytes each. The left child of an
+ * inner node is always the next node, so only the right child's index is stored.
+ * Leaves point to a run of the triangle array, and each triangle's corners are
+ * copied once, after the build, into the same order for traversal.
+ *
+ * Common Usage Pattern:
+ *   BVH bvh;
+ *   bvh.build(mesh.vertices, mesh.indices);
+ *   BVH::RayHit hit;
+ *   if (bvh.intersect(origin, direction, hit)) ...         // nearest hit, hit.triangle
+ *   BVH::PointHit closest = bvh.closestPoint(point);        // e.g. for SDF sampling
+ */
+
+#ifndef GEOMETRY_BVH_H
+#define GEOMETRY_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "../mesh.h"
+
+class BVH {
+public:
+    struct Node {
+        glm::vec3 boundsMin;
+        std::uint32_t first;  // leaf: first slot in the triangle order; inner: right child
+        glm::vec3 boundsMax;
+        std::uint32_t count;  // triangles in a leaf, 0 for an inner node
+
+        bool isLeaf() const { return count != 0; }
+    };
+
+    struct Options {
+        int maxLeafTriangles = 4; // split any node with more triangles, cost permitting
+        int maxDepth = 48;        // nodes at this depth become leaves
+    };
+
+    struct RayHit {
+        float distance = std::numeric_limits<float>::infinity();
+        std::uint32_t triangle = 0;  // index of the triangle in the input list
+        float u = 0.0f, v = 0.0f;    // barycentric coordinates of the hit
+    };
+
+    struct PointHit {
+        float distance = std::numeric_limits<float>::infinity();
+        std::uint32_t triangle = 0;
+        glm::vec3 point{ 0.0f };
+        glm::vec3 faceNormal{ 0.0f }; // unnormalised, wound like the triangle
+    };
+
+    static constexpr int kBins = 16;
+    static constexpr int kStackSize = 64;
+
+    // Triangle soup, three corners per triangle, or an indexed Vertex mesh
+    void build(const std::vector<glm::vec3>& corners);
+    void build(const std::vector<glm::vec3>& corners, const Options& options);
+    void build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    void build(const std::vector<Vertex>& vertices, const std::vector<int>& indices);
+    void clear();
+
+    // Nearest hit with distance in (0, maxDistance); direction need not be unit length,
+    // distances are in units of it
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                   float maxDistance = std::numeric_limits<float>::infinity()) const;
+    // Closest point on the surface; distance is infinite if the BVH is empty
+    PointHit closestPoint(const glm::vec3& point) const;
+
+    const std::vector<Node>& getNodes() const { return nodes_; }
+    std::size_t nodeCount() const { return nodes_.size(); }
+    std::size_t triangleCount() const { return order_.size(); }
+    int getDepth() const { return depth_; }
+    bool empty() const { return nodes_.empty(); }
+
+    // Calls fn(node) for every node at the given depth (the root is depth 0)
+    template <typename Fn>
+    void forEachNodeAtDepth(int depth, Fn&& fn) const
+    {
+        if (nodes_.empty()) return;
+        std::uint32_t stack[kStackSize];
+        int depths[kStackSize];
+        int top = 0;
+        stack[top] = 0;
+        depths[top++] = 0;
+        while (top > 0)
+        {
+            --top;
+            const Node& node = nodes_[stack[top]];
+            const int nodeDepth = depths[top];
+            if (nodeDepth == depth || node.isLeaf())
+            {
+                if (nodeDepth == depth) fn(node);
+                continue;
+            }
+            stack[top] = node.first;
+            depths[top++] = nodeDepth + 1;
+            stack[top] = static_cast<std::uint32_t>(&node - nodes_.data()) + 1;
+            depths[top++] = nodeDepth + 1;
+        }
+    }
+
+private:
+    struct Bounds {
+        glm::vec3 min{ std::numeric_limits<float>::max() };
+        glm::vec3 max{ -std::numeric_limits<float>::max() };
+
+        void grow(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+        void grow(const Bounds& b) { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+        float area() const;
+    };
+
+    void subdivide(std::uint32_t nodeIndex, std::uint32_t begin, std::uint32_t end, int depth);
+
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> order_;   // triangle ids, grouped by leaf
+    std::vector<glm::vec3> corners_;     // corners of order_[i] at 3i..3i+2
+    int depth_ = 0;
+    Options options_;
+
+    // Build scratch, indexed by triangle id
+    std::vector<Bounds> triangleBounds_;
+    std::vector<glm::vec3> centroids_;
+};
+
+#endif // GEOMETRY_BVH_H
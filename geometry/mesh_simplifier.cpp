@@ -0,0 +1,401 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+
+// A collapse may not turn a face further than this from its old normal (about 78 deg)
+constexpr double kMinFaceCos = 0.2;
+// Border planes count this much more than face planes
+constexpr double kBorderWeight = 10.0;
+
+std::uint64_t edgeKey(int a, int b)
+{
+    if (a > b) std::swap(a, b);
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(a)) << 32) | static_cast<std::uint32_t>(b);
+}
+
+} // namespace
+
+void MeshSimplifier::Quadric::addPlane(double nx, double ny, double nz, double d, double w)
+{
+    a[0] += w * nx * nx; a[1] += w * nx * ny; a[2] += w * nx * nz; a[3] += w * nx * d;
+    a[4] += w * ny * ny; a[5] += w * ny * nz; a[6] += w * ny * d;
+    a[7] += w * nz * nz; a[8] += w * nz * d;
+    a[9] += w * d * d;
+    weight += w;
+}
+
+MeshSimplifier::Quadric& MeshSimplifier::Quadric::operator+=(const Quadric& other)
+{
+    for (int i = 0; i < 10; ++i) a[i] += other.a[i];
+    weight += other.weight;
+    return *this;
+}
+
+double MeshSimplifier::Quadric::error(const glm::dvec3& p) const
+{
+    // p^T A p + 2 b.p + c with A = a[0..8] minus the d column, b = (a3, a6, a8), c = a9
+    const double e = a[0] * p.x * p.x + 2.0 * a[1] * p.x * p.y + 2.0 * a[2] * p.x * p.z + 2.0 * a[3] * p.x
+                   + a[4] * p.y * p.y + 2.0 * a[5] * p.y * p.z + 2.0 * a[6] * p.y
+                   + a[7] * p.z * p.z + 2.0 * a[8] * p.z
+                   + a[9];
+    return std::max(0.0, e);
+}
+
+bool MeshSimplifier::Quadric::optimum(glm::dvec3& p) const
+{
+    // Solve A p = -b by Cramer's rule; near-singular A (flat or straight regions) fails
+    const double m00 = a[0], m01 = a[1], m02 = a[2], m11 = a[4], m12 = a[5], m22 = a[7];
+    const double c0 = m11 * m22 - m12 * m12;
+    const double c1 = m02 * m12 - m01 * m22;
+    const double c2 = m01 * m12 - m02 * m11;
+    const double det = m00 * c0 + m01 * c1 + m02 * c2;
+    const double scale = m00 * m00 + m11 * m11 + m22 * m22;
+    if (std::fabs(det) <= 1e-12 * scale * std::sqrt(scale)) return false;
+
+    const double bx = -a[3], by = -a[6], bz = -a[8];
+    const double inv = 1.0 / det;
+    p.x = (c0 * bx + c1 * by + c2 * bz) * inv;
+    p.y = (c1 * bx + (m00 * m22 - m02 * m02) * by + (m01 * m02 - m00 * m12) * bz) * inv;
+    p.z = (c2 * bx + (m01 * m02 - m00 * m12) * by + (m00 * m11 - m01 * m01) * bz) * inv;
+    return true;
+}
+
+std::size_t MeshSimplifier::simplify(std::vector<Vertex>& vertices, std::vector<int>& indices, const Options& options)
+{
+    std::vector<unsigned int> unsignedIndices(indices.begin(), indices.end());
+    const std::size_t triangles = simplify(vertices, unsignedIndices, options);
+    indices.assign(unsignedIndices.begin(), unsignedIndices.end());
+    return triangles;
+}
+
+std::size_t MeshSimplifier::simplify(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                                     const Options& options)
+{
+    maxError_ = 0.0f;
+    weld(vertices, indices, options.weldTolerance);
+    buildQuadrics();
+
+    heap_.clear();
+    for (int u = 0; u < static_cast<int>(positions_.size()); ++u) pushEdges(u);
+
+    const double maxCost = static_cast<double>(options.maxError) * options.maxError;
+    while (!heap_.empty() && liveFaces_ > options.targetTriangles)
+    {
+        std::pop_heap(heap_.begin(), heap_.end());
+        const Candidate candidate = heap_.back();
+        heap_.pop_back();
+        if (!alive_[candidate.u] || !alive_[candidate.v] ||
+            stamps_[candidate.u] != candidate.stampU || stamps_[candidate.v] != candidate.stampV)
+            continue; // an endpoint moved since this entry was queued
+        if (candidate.cost > maxCost) break;
+        if (collapse(candidate))
+            maxError_ = std::max(maxError_, static_cast<float>(std::sqrt(candidate.cost)));
+    }
+
+    // Compact the surviving vertices in their original order
+    std::vector<int> remap(positions_.size(), -1);
+    vertices.clear();
+    indices.clear();
+    for (std::size_t f = 0; f < faceAlive_.size(); ++f)
+    {
+        if (!faceAlive_[f]) continue;
+        for (int k = 0; k < 3; ++k)
+        {
+            const int v = faces_[f * 3 + k];
+            if (remap[v] < 0)
+            {
+                remap[v] = static_cast<int>(vertices.size());
+                const float length = glm::length(normals_[v]);
+                Vertex vertex;
+                vertex.Position = glm::vec3(positions_[v].x, positions_[v].y, positions_[v].z);
+                vertex.Normal = length > 1e-8f ? normals_[v] / length : glm::vec3(0.0f);
+                vertex.TexCoords = texCoords_[v];
+                vertices.push_back(vertex);
+            }
+            indices.push_back(static_cast<unsigned int>(remap[v]));
+        }
+    }
+    return indices.size() / 3;
+}
+
+void MeshSimplifier::weld(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, float tolerance)
+{
+    positions_.clear();
+    normals_.clear();
+    texCoords_.clear();
+
+    glm::vec3 lo(0.0f), hi(0.0f);
+    if (!vertices.empty()) lo = hi = vertices[0].Position;
+    for (const Vertex& vertex : vertices)
+    {
+        lo = glm::min(lo, vertex.Position);
+        hi = glm::max(hi, vertex.Position);
+    }
+    const double diagonal = glm::length(hi - lo);
+    const double epsilon = std::max(static_cast<double>(tolerance) * diagonal, 1e-12);
+    const double cell = 2.0 * epsilon;
+
+    // Hash grid of cells 2 * epsilon wide; a match is searched in the 27 cells around
+    auto cellKey = [](std::int64_t x, std::int64_t y, std::int64_t z) {
+        return static_cast<std::uint64_t>((x * 73856093) ^ (y * 19349663) ^ (z * 83492791));
+    };
+    std::unordered_multimap<std::uint64_t, int> grid;
+    grid.reserve(vertices.size());
+    std::vector<int> welded(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        const Vertex& vertex = vertices[i];
+        const glm::dvec3 p(vertex.Position.x, vertex.Position.y, vertex.Position.z);
+        const std::int64_t cx = static_cast<std::int64_t>(std::floor(p.x / cell));
+        const std::int64_t cy = static_cast<std::int64_t>(std::floor(p.y / cell));
+        const std::int64_t cz = static_cast<std::int64_t>(std::floor(p.z / cell));
+
+        int match = -1;
+        for (int dz = -1; dz <= 1 && match < 0; ++dz)
+            for (int dy = -1; dy <= 1 && match < 0; ++dy)
+                for (int dx = -1; dx <= 1 && match < 0; ++dx)
+                {
+                    const auto range = grid.equal_range(cellKey(cx + dx, cy + dy, cz + dz));
+                    for (auto it = range.first; it != range.second; ++it)
+                    {
+                        const int candidate = it->second;
+                        const glm::dvec3 q = positions_[candidate];
+                        const glm::vec2 uv = texCoords_[candidate] - vertex.TexCoords;
+                        if (std::fabs(q.x - p.x) <= epsilon && std::fabs(q.y - p.y) <= epsilon &&
+                            std::fabs(q.z - p.z) <= epsilon && std::fabs(uv.x) <= 1e-5f && std::fabs(uv.y) <= 1e-5f)
+                        {
+                            match = candidate;
+                            break;
+                        }
+                    }
+                }
+
+        if (match < 0)
+        {
+            match = static_cast<int>(positions_.size());
+            positions_.push_back(p);
+            normals_.push_back(glm::vec3(0.0f));
+            texCoords_.push_back(vertex.TexCoords);
+            grid.emplace(cellKey(cx, cy, cz), match);
+        }
+        normals_[match] += vertex.Normal;
+        welded[i] = match;
+    }
+
+    faces_.clear();
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const int a = welded[indices[i]], b = welded[indices[i + 1]], c = welded[indices[i + 2]];
+        if (a == b || b == c || a == c) continue; // collapsed by welding
+        faces_.push_back(a);
+        faces_.push_back(b);
+        faces_.push_back(c);
+    }
+    liveFaces_ = faces_.size() / 3;
+    faceAlive_.assign(liveFaces_, 1);
+}
+
+void MeshSimplifier::buildQuadrics()
+{
+    const std::size_t vertexCount = positions_.size();
+    quadrics_.assign(vertexCount, Quadric());
+    stamps_.assign(vertexCount, 0);
+    alive_.assign(vertexCount, 1);
+    border_.assign(vertexCount, 0);
+    vertexFaces_.assign(vertexCount, std::vector<int>());
+
+    std::unordered_map<std::uint64_t, int> edgeFaces; // edge -> face count, or the one face
+    edgeFaces.reserve(faces_.size());
+    for (std::size_t f = 0; f < liveFaces_; ++f)
+    {
+        const int* face = &faces_[f * 3];
+        const glm::dvec3 normal = glm::cross(positions_[face[1]] - positions_[face[0]],
+                                             positions_[face[2]] - positions_[face[0]]);
+        const double length = glm::length(normal);
+        if (length > 0.0)
+        {
+            const glm::dvec3 n = normal / length;
+            for (int k = 0; k < 3; ++k)
+                quadrics_[face[k]].addPlane(n.x, n.y, n.z, -glm::dot(n, positions_[face[0]]), 1.0);
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            vertexFaces_[face[k]].push_back(static_cast<int>(f));
+            ++edgeFaces[edgeKey(face[k], face[(k + 1) % 3])];
+        }
+    }
+
+    // Open border edges get a plane through them, perpendicular to their face
+    for (std::size_t f = 0; f < liveFaces_; ++f)
+    {
+        const int* face = &faces_[f * 3];
+        const glm::dvec3 normal = glm::cross(positions_[face[1]] - positions_[face[0]],
+                                             positions_[face[2]] - positions_[face[0]]);
+        for (int k = 0; k < 3; ++k)
+        {
+            const int a = face[k], b = face[(k + 1) % 3];
+            if (edgeFaces[edgeKey(a, b)] == 2) continue;
+            // Border (1 face) or non-manifold (3+): pin both ends to the edge
+            border_[a] = border_[b] = 1;
+            const glm::dvec3 edge = positions_[b] - positions_[a];
+            const glm::dvec3 side = glm::cross(edge, normal);
+            const double length = glm::length(side);
+            if (length <= 0.0) continue;
+            const glm::dvec3 n = side / length;
+            const double d = -glm::dot(n, positions_[a]);
+            quadrics_[a].addPlane(n.x, n.y, n.z, d, kBorderWeight);
+            quadrics_[b].addPlane(n.x, n.y, n.z, d, kBorderWeight);
+        }
+    }
+}
+
+void MeshSimplifier::neighbours(int u, std::vector<int>& out) const
+{
+    out.clear();
+    for (const int f : vertexFaces_[u])
+        for (int k = 0; k < 3; ++k)
+            if (faces_[f * 3 + k] != u) out.push_back(faces_[f * 3 + k]);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+MeshSimplifier::Candidate MeshSimplifier::evaluate(int u, int v) const
+{
+    Quadric q = quadrics_[u];
+    q += quadrics_[v];
+
+    // Optimal point if the quadric has one, else the better of the ends and the midpoint
+    Candidate candidate{ 0.0, u, v, stamps_[u], stamps_[v], glm::dvec3(0.0) };
+    glm::dvec3 best;
+    double bestCost;
+    if (q.optimum(best))
+    {
+        bestCost = q.error(best);
+    }
+    else
+    {
+        const glm::dvec3 options[3] = { positions_[u], positions_[v], (positions_[u] + positions_[v]) * 0.5 };
+        best = options[0];
+        bestCost = q.error(best);
+        for (int i = 1; i < 3; ++i)
+        {
+            const double cost = q.error(options[i]);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                best = options[i];
+            }
+        }
+    }
+    candidate.cost = q.weight > 0.0 ? bestCost / q.weight : 0.0; // mean squared plane distance
+    candidate.target = best;
+    return candidate;
+}
+
+void MeshSimplifier::pushEdges(int u)
+{
+    neighbours(u, scratchU_);
+    for (const int v : scratchU_)
+    {
+        if (v < u && stamps_[u] == 0 && stamps_[v] == 0) continue; // initial pass: each edge once
+        heap_.push_back(evaluate(u, v));
+        std::push_heap(heap_.begin(), heap_.end());
+    }
+}
+
+bool MeshSimplifier::collapse(const Candidate& candidate)
+{
+    const int u = candidate.u, v = candidate.v;
+
+    // Link condition: the only vertices next to both ends are the far corners of the
+    // faces on the edge, otherwise the collapse pinches the surface
+    int sharedFaces = 0;
+    for (const int f : vertexFaces_[u])
+        for (int k = 0; k < 3; ++k)
+            if (faces_[f * 3 + k] == v) ++sharedFaces;
+    if (sharedFaces == 0) return false;
+    neighbours(u, scratchU_);
+    neighbours(v, scratchV_);
+    std::size_t common = 0;
+    for (std::size_t i = 0, j = 0; i < scratchU_.size() && j < scratchV_.size();)
+    {
+        if (scratchU_[i] < scratchV_[j]) ++i;
+        else if (scratchU_[i] > scratchV_[j]) ++j;
+        else { ++common; ++i; ++j; }
+    }
+    if (common != static_cast<std::size_t>(sharedFaces)) return false;
+    // An inner edge between two border vertices would join two border loops
+    if (sharedFaces == 2 && border_[u] && border_[v]) return false;
+
+    // No remaining face around either end may flip or degenerate
+    const glm::dvec3 target = candidate.target;
+    for (const int end : { u, v })
+        for (const int f : vertexFaces_[end])
+        {
+            const int* face = &faces_[f * 3];
+            if ((face[0] == u || face[1] == u || face[2] == u) && (face[0] == v || face[1] == v || face[2] == v))
+                continue;
+            glm::dvec3 p[3] = { positions_[face[0]], positions_[face[1]], positions_[face[2]] };
+            const glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            for (int k = 0; k < 3; ++k)
+                if (face[k] == end) p[k] = target;
+            const glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+            const double lengths = glm::length(before) * glm::length(after);
+            if (lengths <= 0.0 || glm::dot(before, after) < kMinFaceCos * lengths) return false;
+        }
+
+    // Attributes follow the target's position along the edge
+    const glm::dvec3 edge = positions_[v] - positions_[u];
+    const double edgeLength2 = glm::dot(edge, edge);
+    const float t = edgeLength2 > 0.0
+        ? static_cast<float>(std::min(1.0, std::max(0.0, glm::dot(target - positions_[u], edge) / edgeLength2)))
+        : 0.0f;
+    const float lengthU = glm::length(normals_[u]), lengthV = glm::length(normals_[v]);
+    const glm::vec3 normalU = lengthU > 0.0f ? normals_[u] / lengthU : normals_[u];
+    const glm::vec3 normalV = lengthV > 0.0f ? normals_[v] / lengthV : normals_[v];
+    normals_[u] = glm::mix(normalU, normalV, t);
+    texCoords_[u] = glm::mix(texCoords_[u], texCoords_[v], t);
+    positions_[u] = target;
+    quadrics_[u] += quadrics_[v];
+    border_[u] = border_[u] | border_[v];
+    alive_[v] = 0;
+    ++stamps_[u];
+
+    // Faces on the edge die; v's other faces now use u
+    std::vector<int>& facesU = vertexFaces_[u];
+    for (const int f : vertexFaces_[v])
+    {
+        int* face = &faces_[f * 3];
+        if (face[0] == u || face[1] == u || face[2] == u)
+        {
+            if (faceAlive_[f])
+            {
+                faceAlive_[f] = 0;
+                --liveFaces_;
+            }
+            continue;
+        }
+        for (int k = 0; k < 3; ++k)
+            if (face[k] == v) face[k] = u;
+        facesU.push_back(f);
+    }
+    facesU.erase(std::remove_if(facesU.begin(), facesU.end(), [&](int f) { return !faceAlive_[f]; }), facesU.end());
+    vertexFaces_[v].clear();
+    vertexFaces_[v].shrink_to_fit();
+
+    // Neighbours lost faces on the edge; drop those from their lists too
+    neighbours(u, scratchU_);
+    for (const int w : scratchU_)
+    {
+        std::vector<int>& facesW = vertexFaces_[w];
+        facesW.erase(std::remove_if(facesW.begin(), facesW.end(), [&](int f) { return !faceAlive_[f]; }), facesW.end());
+    }
+
+    pushEdges(u);
+    return true;
+}
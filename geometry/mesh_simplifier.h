@@ -0,0 +1,106 @@
+/**
+ * MeshSimplifier - quadric error metric (QEM) edge-collapse decimation
+ *
+ * Works on plain Vertex / index arrays, so it runs as a post-pass on marching cubes
+ * output (CubeMarching, SurfaceNets, GPUMarchCubes::getVertices) and on the meshes of
+ * a Model alike.
+ *
+ * Vertices at the same position (within weldTolerance) and with the same texture
+ * coordinates are welded first, so flat-shaded input with three vertices per triangle
+ * simplifies like an indexed mesh; their normals are averaged. Vertices that share a
+ * position but not texture coordinates stay apart, and the seam between them is kept
+ * like any other open border.
+ *
+ * Edges are then collapsed cheapest first, each into the point that minimises the
+ * summed squared distance to the planes of the faces merged so far (Garland & Heckbert).
+ * A collapse is skipped if it would flip a face or make the mesh non-manifold. Open
+ * borders carry extra perpendicular planes so they hold their shape.
+ *
+ * Common Usage Pattern:
+ *   MeshSimplifier::Options options;
+ *   options.targetTriangles = indices.size() / 3 / 4;   // keep a quarter
+ *   MeshSimplifier().simplify(vertices, indices, options);
+ *
+ *   for (Mesh& mesh : model.meshes)                     // Model meshes, GL context needed
+ *       mesh = simplifiedMesh(mesh, options);
+ */
+
+#ifndef GEOMETRY_MESH_SIMPLIFIER_H
+#define GEOMETRY_MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "../mesh.h"
+
+class MeshSimplifier {
+public:
+    struct Options {
+        // Stop once the mesh has at most this many triangles (0: no triangle target)
+        std::size_t targetTriangles = 0;
+        // Stop before a collapse whose RMS distance to its merged planes exceeds this,
+        // in model units (infinity: no error bound)
+        float maxError = std::numeric_limits<float>::infinity();
+        // Weld distance relative to the bounding box diagonal
+        float weldTolerance = 1e-5f;
+    };
+
+    // Simplify in place; the result is an indexed triangle list. Returns the triangle count.
+    std::size_t simplify(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const Options& options);
+    std::size_t simplify(std::vector<Vertex>& vertices, std::vector<int>& indices, const Options& options);
+
+    // Largest RMS plane distance among the collapses of the last call
+    float getMaxError() const { return maxError_; }
+
+private:
+    struct Quadric {
+        double a[10] = {};  // upper triangle of the symmetric 4x4 matrix, row major
+        double weight = 0.0;
+
+        void addPlane(double nx, double ny, double nz, double d, double w);
+        Quadric& operator+=(const Quadric& other);
+        double error(const glm::dvec3& p) const;
+        bool optimum(glm::dvec3& p) const;
+    };
+
+    struct Candidate {
+        double cost;
+        int u, v;
+        unsigned int stampU, stampV;
+        glm::dvec3 target;
+        bool operator<(const Candidate& other) const { return cost > other.cost; } // min-heap
+    };
+
+    void weld(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, float tolerance);
+    void buildQuadrics();
+    bool collapse(const Candidate& candidate);
+    void pushEdges(int u);
+    Candidate evaluate(int u, int v) const;
+    void neighbours(int u, std::vector<int>& out) const;
+
+    // Welded mesh being simplified
+    std::vector<glm::dvec3> positions_;
+    std::vector<glm::vec3> normals_;
+    std::vector<glm::vec2> texCoords_;
+    std::vector<Quadric> quadrics_;
+    std::vector<unsigned int> stamps_;
+    std::vector<unsigned char> alive_, border_;
+    std::vector<std::vector<int>> vertexFaces_;
+    std::vector<int> faces_;              // 3 welded vertices per face
+    std::vector<unsigned char> faceAlive_;
+    std::size_t liveFaces_ = 0;
+    std::vector<Candidate> heap_;
+    std::vector<int> scratchU_, scratchV_;
+    float maxError_ = 0.0f;
+};
+
+// Simplified copy of a Mesh with the same textures (creates GL buffers)
+inline Mesh simplifiedMesh(const Mesh& mesh, const MeshSimplifier::Options& options)
+{
+    std::vector<Vertex> vertices = mesh.vertices;
+    std::vector<unsigned int> indices = mesh.indices;
+    MeshSimplifier().simplify(vertices, indices, options);
+    return Mesh(vertices, indices, mesh.textures);
+}
+
+#endif // GEOMETRY_MESH_SIMPLIFIER_H
@@ -37,6 +37,13 @@ void Mesh::setupMesh () {
     glBindVertexArray(0);
 }
 
+void Mesh::releaseBuffers() {
+    if (VAO == 0) return;
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    VAO = VBO = EBO = 0;
+}
 
 void Mesh::Draw(Shader &shader) 
 {
@@ -29,6 +29,9 @@ class Mesh {
         Mesh();
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
         void Draw(Shader &shader);
+        // Delete the VAO and buffers. Meshes are copied freely and have no destructor, so
+        // whoever replaces a mesh that owns GL objects calls this on the old one first.
+        void releaseBuffers();
         
         // Getters for instanced rendering
         unsigned int getVAO() const { return VAO; }
@@ -36,7 +39,7 @@ class Mesh {
 
     private:
         // render data
-        unsigned int VAO, VBO, EBO;
+        unsigned int VAO = 0, VBO = 0, EBO = 0;
 
         void setupMesh();
 };
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Color;
+
+// Circles face the camera and the light shines straight down the view axis, so the
+// Phong terms of simple_fragment.fs collapse to constants per channel.
+uniform vec3 lightAmbient;
+uniform vec3 lightDiffuse;
+uniform vec3 lightSpecular;
+
+void main()
+{
+    vec3 ambient = lightAmbient * (Color * 0.6);
+    vec3 diffuse = lightDiffuse * Color;
+    vec3 specular = lightSpecular * vec3(0.05);
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
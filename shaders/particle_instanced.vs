@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;       // unit circle vertex
+layout (location = 1) in vec3 aInstance;  // per-instance x, y, radius
+layout (location = 2) in vec4 aColor;     // per-instance RGBA8, normalized
+
+out vec3 Color;
+
+uniform mat4 projection;
+
+void main()
+{
+	gl_Position = projection * vec4(aInstance.xy + aPos * aInstance.z, 0.0, 1.0);
+	Color = aColor.rgb;
+}
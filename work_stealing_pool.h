@@ -0,0 +1,403 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define WS_CPU_RELAX() _mm_pause()
+#else
+#define WS_CPU_RELAX() std::this_thread::yield()
+#endif
+
+// Work-stealing alternative to TPThreadPool for fork/join loops.
+//
+// Every participant owns a Chase-Lev deque of range tasks. parallelFor pushes its whole
+// range as one task, and whoever runs a task keeps splitting it in half at grain
+// boundaries, pushing the upper half onto its own deque. Owners pop from the bottom
+// (newest, smallest, cache-warm), idle workers steal from the top (oldest, largest).
+// No std::function, packaged_task or future is created per task, and there is no
+// shared queue lock on the hot path.
+//
+// The calling thread is a participant: a pool of N threads starts N-1 workers, and
+// parallelFor runs work on the caller until the loop is complete. Calls from threads
+// outside the pool are serialized; calls from inside a task (nested loops) are not.
+
+class WSWaitGroup;
+
+struct WSRangeJob {
+    void (*invoke)(const void* fn, int begin, int end);
+    const void* fn;
+    int grain;
+    WSWaitGroup* group;
+};
+
+struct WSTask {
+    const WSRangeJob* job = nullptr;
+    int begin = 0;
+    int end = 0;
+};
+
+// Blocking counter for outstanding tasks. wait() spins briefly and then sleeps on a
+// condition variable; the last done() wakes it.
+class WSWaitGroup {
+public:
+    void add(int n) { count.fetch_add(n, std::memory_order_relaxed); }
+
+    void done() {
+        int current = count.load(std::memory_order_relaxed);
+        while (current > 1) {
+            if (count.compare_exchange_weak(current, current - 1, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        // Last task: decrement under the lock so a waiter cannot destroy the group
+        // between our decrement and the notify.
+        std::lock_guard<std::mutex> lock(mutex);
+        count.fetch_sub(1, std::memory_order_release);
+        cv.notify_all();
+    }
+
+    bool finished() const { return count.load(std::memory_order_acquire) == 0; }
+
+    void wait() {
+        for (int spin = 0; spin < kSpinIterations && !finished(); ++spin) {
+            WS_CPU_RELAX();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return finished(); });
+    }
+
+private:
+    static constexpr int kSpinIterations = 256;
+    std::atomic<int> count{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+// Fixed-capacity Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP'13 orderings).
+// push/pop are owner-only, steal may be called from any thread. Slots are stored as
+// atomics so a stealer racing with the owner's reuse of a slot never reads torn data;
+// such a steal loses the CAS on `top` and is discarded.
+class WSDeque {
+public:
+    explicit WSDeque(int64_t capacity = 1024)
+        : mask(checkCapacity(capacity) - 1), slots(new Slot[static_cast<size_t>(capacity)]) {}
+
+    // Returns false when full; the caller should run the task itself.
+    bool push(const WSTask& task) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > mask) return false;
+        Slot& slot = slots[b & mask];
+        slot.job.store(task.job, std::memory_order_relaxed);
+        slot.range.store(packRange(task.begin, task.end), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pop(WSTask& task) {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        read(b, task);
+        if (t == b) {
+            // Last element: race the stealers for it
+            const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                         std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal(WSTask& task) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        read(t, task);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<const WSRangeJob*> job{nullptr};
+        std::atomic<uint64_t> range{0};
+    };
+
+    static int64_t checkCapacity(int64_t capacity) {
+        if (capacity <= 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("Deque capacity must be a power of two");
+        }
+        return capacity;
+    }
+
+    static uint64_t packRange(int begin, int end) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(begin)) << 32) | static_cast<uint32_t>(end);
+    }
+
+    void read(int64_t index, WSTask& task) const {
+        const Slot& slot = slots[index & mask];
+        task.job = slot.job.load(std::memory_order_relaxed);
+        const uint64_t range = slot.range.load(std::memory_order_relaxed);
+        task.begin = static_cast<int>(static_cast<uint32_t>(range >> 32));
+        task.end = static_cast<int>(static_cast<uint32_t>(range));
+    }
+
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    alignas(64) const int64_t mask;
+    std::unique_ptr<Slot[]> slots;
+};
+
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int n = static_cast<int>(std::thread::hardware_concurrency()))
+        : numThreads(n) {
+        if (n <= 0) {
+            throw std::invalid_argument("Thread count must be positive");
+        }
+
+        // Deque numThreads-1 belongs to whichever outside thread is calling parallelFor
+        deques.reserve(numThreads);
+        for (int i = 0; i < numThreads; ++i) {
+            deques.emplace_back(new WSDeque());
+        }
+        threads.reserve(numThreads - 1);
+        for (int i = 0; i < numThreads - 1; ++i) {
+            threads.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        shutdown();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void shutdown() {
+        if (!stopping.exchange(true)) {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                ++wakeEpoch;
+            }
+            sleepCv.notify_all();
+            for (auto& thread : threads) {
+                if (thread.joinable()) thread.join();
+            }
+        }
+    }
+
+    // Run fn(first, last) over [begin, end) in chunks of at most `grain` indices and
+    // block until every chunk has finished. fn must be callable concurrently.
+    template <typename Func>
+    void parallelFor(int begin, int end, int grain, const Func& fn) {
+        if (begin >= end) return;
+        grain = std::max(1, grain);
+        if (end - begin <= grain || numThreads == 1) {
+            fn(begin, end);
+            return;
+        }
+
+        int self = participantIndex();
+        std::unique_lock<std::mutex> outsideLock;
+        if (self < 0) {
+            if (stopping.load()) {
+                throw std::runtime_error("Cannot run tasks on a stopped thread pool");
+            }
+            outsideLock = std::unique_lock<std::mutex>(outsideMutex);
+            self = numThreads - 1;
+        }
+        ParticipantScope scope(this, self);
+
+        WSWaitGroup group;
+        const WSRangeJob job{ &invokeRange<Func>, &fn, grain, &group };
+        group.add(1);
+        runTask(self, WSTask{ &job, begin, end });
+        helpUntilDone(self, group);
+    }
+
+    size_t getThreadCount() const { return static_cast<size_t>(numThreads); }
+
+    // Slot of the calling thread inside a parallelFor body: workers are 0..n-2 and the
+    // outside caller is n-1. Bodies run inline (tiny ranges, one thread) report n-1 too.
+    int currentSlot() const {
+        const int index = participantIndex();
+        return index < 0 ? numThreads - 1 : index;
+    }
+
+private:
+    static constexpr int kSpinIterations = 64;
+    static constexpr int kYieldIterations = 16;
+
+    struct Participant {
+        const WorkStealingPool* pool = nullptr;
+        int index = -1;
+    };
+
+    static Participant& currentParticipant() {
+        thread_local Participant participant;
+        return participant;
+    }
+
+    // Marks the calling thread as participant `index` for the duration of a loop so
+    // nested parallelFor calls push onto the right deque.
+    struct ParticipantScope {
+        Participant saved;
+        ParticipantScope(const WorkStealingPool* pool, int index) : saved(currentParticipant()) {
+            currentParticipant() = Participant{ pool, index };
+        }
+        ~ParticipantScope() { currentParticipant() = saved; }
+    };
+
+    int participantIndex() const {
+        const Participant& p = currentParticipant();
+        return p.pool == this ? p.index : -1;
+    }
+
+    template <typename Func>
+    static void invokeRange(const void* fn, int begin, int end) {
+        (*static_cast<const Func*>(fn))(begin, end);
+    }
+
+    // Split the task down to one grain, leaving the upper halves for thieves, then run it.
+    void runTask(int self, WSTask task) {
+        const WSRangeJob& job = *task.job;
+        while (task.end - task.begin > job.grain) {
+            const int chunks = (task.end - task.begin + job.grain - 1) / job.grain;
+            const int mid = task.begin + (chunks / 2) * job.grain;
+            job.group->add(1);
+            if (!deques[self]->push(WSTask{ task.job, mid, task.end })) {
+                job.group->done();
+                break; // Deque full: run the rest here
+            }
+            notifySleepers();
+            task.end = mid;
+        }
+
+        try {
+            job.invoke(job.fn, task.begin, task.end);
+        } catch (const std::exception& e) {
+            std::cerr << "Task exception in worker " << self << ": " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in worker " << self << std::endl;
+        }
+        job.group->done();
+    }
+
+    bool findTask(int self, WSTask& task) {
+        if (deques[self]->pop(task)) return true;
+        // Start stealing at a different victim each time to spread contention
+        thread_local uint32_t seed = 0x9E3779B9u ^ static_cast<uint32_t>(self * 7919);
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        const int start = static_cast<int>(seed % static_cast<uint32_t>(numThreads));
+        for (int k = 0; k < numThreads; ++k) {
+            const int victim = (start + k) % numThreads;
+            if (victim != self && deques[victim]->steal(task)) return true;
+        }
+        return false;
+    }
+
+    void helpUntilDone(int self, WSWaitGroup& group) {
+        int idle = 0;
+        while (!group.finished() && idle < kSpinIterations) {
+            WSTask task;
+            if (findTask(self, task)) {
+                runTask(self, task);
+                idle = 0;
+            } else {
+                ++idle;
+                WS_CPU_RELAX();
+            }
+        }
+        // Whatever is left is already running on other workers
+        group.wait();
+    }
+
+    bool hasQueuedWork() const {
+        for (const auto& deque : deques) {
+            if (!deque->empty()) return true;
+        }
+        return false;
+    }
+
+    void notifySleepers() {
+        // Pairs with the fence in sleep(): either the sleeper sees the pushed task or
+        // we see the sleeper.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                ++wakeEpoch;
+            }
+            sleepCv.notify_one();
+        }
+    }
+
+    void sleep() {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        const uint64_t epoch = wakeEpoch;
+        sleeping.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!hasQueuedWork() && !stopping.load()) {
+            sleepCv.wait(lock, [this, epoch] { return wakeEpoch != epoch || stopping.load(); });
+        }
+        sleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void workerLoop(int self) {
+        ParticipantScope scope(this, self);
+        int idle = 0;
+        while (!stopping.load(std::memory_order_acquire)) {
+            WSTask task;
+            if (findTask(self, task)) {
+                runTask(self, task);
+                idle = 0;
+            } else if (++idle < kSpinIterations) {
+                WS_CPU_RELAX();
+            } else if (idle < kSpinIterations + kYieldIterations) {
+                std::this_thread::yield();
+            } else {
+                sleep();
+                idle = 0;
+            }
+        }
+    }
+
+    int numThreads;
+    std::vector<std::unique_ptr<WSDeque>> deques;
+    std::vector<std::thread> threads;
+    std::mutex outsideMutex;
+    std::atomic<bool> stopping{false};
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<int> sleeping{0};
+    uint64_t wakeEpoch = 0;
+};
+
+#endif // WORK_STEALING_POOL_H